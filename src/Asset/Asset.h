@@ -8,7 +8,7 @@
 namespace rosy_asset
 {
     constexpr uint32_t rosy_format{0x52535946}; // "RSYF"
-    constexpr uint32_t current_version{1};
+    constexpr uint32_t current_version{2};
 
     struct file_header
     {
@@ -96,6 +96,7 @@ namespace rosy_asset
         std::array<float, 4> tangents{0.f, 0.f, 0.f, 0.f};
         std::array<float, 4> color{1.f, 0.f, 0.f, 1.f};
         std::array<float, 2> texture_coordinates{0.f, 0.f};
+        float occlusion{1.f}; // baked ambient occlusion, 1 is fully unoccluded
     };
 
     struct mesh
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "CollisionBench.h"
+#include <random>
+#include "Engine/Collision.h"
+
+using namespace rosy;
+
+namespace
+{
+    constexpr float floor_size{256.f};
+    constexpr size_t num_statics{3'000};
+    constexpr size_t num_ticks{600};
+    constexpr float tick_time{1.f / 60.f};
+    constexpr float mob_speed{1.5f};
+    // Resolving collisions for up to 4,000 mobs should take no more than this of a 60 Hz tick, larger crowds show how it scales.
+    constexpr double budget_ms{1.0};
+
+    // Half boxes and half hexagonal prisms at random yaws, one to three units across, like furniture and pillars.
+    [[nodiscard]] bool add_statics(const collision& c)
+    {
+        std::mt19937 gen{1234};
+        std::uniform_real_distribution<float> position{0.f, floor_size};
+        std::uniform_real_distribution<float> extent{0.5f, 1.5f};
+        std::uniform_real_distribution<float> yaw{0.f, std::numbers::pi_v<float>};
+        std::vector<std::array<float, 3>> points;
+        for (size_t i{0}; i < num_statics; i++)
+        {
+            const float x = position(gen);
+            const float z = position(gen);
+            const float e = extent(gen);
+            if (i % 2 == 0)
+            {
+                if (c.add_static_box({.min = {x - e, 0.f, z - e}, .max = {x + e, 2.f, z + extent(gen)}}) != result::ok) return false;
+                continue;
+            }
+            points.clear();
+            const float start = yaw(gen);
+            for (size_t corner{0}; corner < 6; corner++)
+            {
+                const float a = start + static_cast<float>(corner) * std::numbers::pi_v<float> / 3.f;
+                for (const float y : {0.f, 2.f}) points.push_back({x + std::cos(a) * e, y, z + std::sin(a) * e});
+            }
+            if (c.add_static_hull(points) != result::ok) return false;
+        }
+        return true;
+    }
+
+    void bench_mobs(const std::shared_ptr<rosy_logger::log>& l, const size_t num_mobs)
+    {
+        collision c{};
+        if (c.init(l) != result::ok) return;
+        if (!add_statics(c))
+        {
+            l->error("Error adding collision statics");
+            c.deinit();
+            return;
+        }
+        std::mt19937 gen{42};
+        std::uniform_real_distribution<float> position{0.f, floor_size};
+        std::uniform_real_distribution<float> heading{0.f, 2.f * std::numbers::pi_v<float>};
+        std::vector<float> xs(num_mobs);
+        std::vector<float> ys(num_mobs, 0.f);
+        std::vector<float> zs(num_mobs);
+        std::vector<float> vx(num_mobs);
+        std::vector<float> vz(num_mobs);
+        std::vector<uint8_t> pushed(num_mobs);
+        for (size_t i{0}; i < num_mobs; i++)
+        {
+            xs[i] = position(gen);
+            zs[i] = position(gen);
+            const float h = heading(gen);
+            vx[i] = std::cos(h) * mob_speed * tick_time;
+            vz[i] = std::sin(h) * mob_speed * tick_time;
+            if (c.add_body({.radius = 0.3f, .bottom = 0.25f, .top = 1.8f}, {xs[i], ys[i], zs[i]}) != result::ok)
+            {
+                l->error("Error adding a collision body");
+                c.deinit();
+                return;
+            }
+        }
+        if (c.prepare() != result::ok)
+        {
+            c.deinit();
+            return;
+        }
+
+        double total_ms{0.0};
+        double max_ms{0.0};
+        collision_stats totals{};
+        for (size_t tick{0}; tick < num_ticks; tick++)
+        {
+            // Mobs walk straight and turn back at the edges of the floor.
+            for (size_t i{0}; i < num_mobs; i++)
+            {
+                if (xs[i] + vx[i] < 0.f || xs[i] + vx[i] > floor_size) vx[i] = -vx[i];
+                if (zs[i] + vz[i] < 0.f || zs[i] + vz[i] > floor_size) vz[i] = -vz[i];
+                xs[i] += vx[i];
+                zs[i] += vz[i];
+            }
+            const auto start = std::chrono::high_resolution_clock::now();
+            c.resolve(xs.data(), ys.data(), zs.data(), pushed.data());
+            const auto end = std::chrono::high_resolution_clock::now();
+            const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            // The first resolve sorts mobs out of where they were added.
+            if (tick == 0) continue;
+            total_ms += ms;
+            max_ms = std::max(max_ms, ms);
+            const collision_stats s = c.stats();
+            totals.endpoint_swaps += s.endpoint_swaps;
+            totals.candidate_pairs += s.candidate_pairs;
+            totals.contacts += s.contacts;
+            totals.bodies_pushed += s.bodies_pushed;
+        }
+        const double ticks = static_cast<double>(num_ticks - 1);
+        const double mean_ms = total_ms / ticks;
+        std::cout << std::format("  {:>6} mobs  mean {:7.3f} ms  max {:7.3f} ms  {} budget  swaps {:8.0f}  pairs {:7.0f}  contacts {:6.0f}  pushed {:6.0f} a tick\n",
+                                 num_mobs, mean_ms, max_ms, mean_ms <= budget_ms ? "within" : "over", static_cast<double>(totals.endpoint_swaps) / ticks,
+                                 static_cast<double>(totals.candidate_pairs) / ticks, static_cast<double>(totals.contacts) / ticks,
+                                 static_cast<double>(totals.bodies_pushed) / ticks);
+        c.deinit();
+    }
+}
+
+void bench_collision()
+{
+    const auto l = std::make_shared<rosy_logger::log>();
+    std::cout << std::format("collision, {} statics on a {} unit floor, {} ticks, {:.1f} ms budget\n", num_statics, floor_size, num_ticks, budget_ms);
+    for (const size_t num_mobs : {1'000, 4'000, 16'000}) bench_mobs(l, num_mobs);
+}
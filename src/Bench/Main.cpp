@@ -0,0 +1,216 @@
+#include "pch.h"
+#include <random>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "Engine/Transforms.h"
+#include "NavigationBench.h"
+#include "CollisionBench.h"
+
+using namespace rosy;
+
+// Microbenchmarks for the node transform kernels against the per node glm math they replace, then for flow field navigation and collision.
+// Usage: Bench.exe [number of nodes] [iterations]
+
+namespace
+{
+    struct bench_nodes
+    {
+        std::vector<uint32_t> parents;
+        std::vector<glm::vec3> translates;
+        std::vector<float> scales;
+        std::vector<float> yaws;
+        std::vector<glm::mat4> coordinate_systems;
+        std::vector<glm::mat4> object_space_transforms;
+        std::vector<glm::mat4> object_space_parent_transforms;
+        std::vector<glm::mat4> object_spaces;
+        std::vector<glm::mat4> world_transforms;
+        std::vector<glm::mat4> inverses;
+        std::vector<std::array<float, 9>> normals;
+        std::vector<std::array<float, 6>> bounds;
+        std::vector<std::array<float, 6>> world_bounds;
+    };
+
+    // Half the nodes are roots and half are their children, matching the two level mobs hierarchy of a level.
+    bench_nodes make_nodes(const size_t num_nodes)
+    {
+        std::mt19937 gen{1234};
+        std::uniform_real_distribution<float> dist{-1.f, 1.f};
+        const size_t num_roots = std::max(static_cast<size_t>(1), num_nodes / 2);
+        bench_nodes n{};
+        for (size_t i{0}; i < num_nodes; i++)
+        {
+            n.parents.push_back(i < num_roots ? transform_no_parent : static_cast<uint32_t>(i % num_roots));
+            n.translates.emplace_back(dist(gen) * 100.f, dist(gen) * 100.f, dist(gen) * 100.f);
+            n.scales.push_back(1.f + dist(gen) * 0.5f);
+            n.yaws.push_back(dist(gen) * 3.f);
+            const glm::mat4 r = toMat4(angleAxis(dist(gen) * 3.f, normalize(glm::vec3{dist(gen), dist(gen), dist(gen)} + glm::vec3{0.f, 0.f, 2.f})));
+            n.coordinate_systems.push_back(r);
+            n.object_space_transforms.push_back(translate(glm::mat4{1.f}, glm::vec3{dist(gen), dist(gen), dist(gen)}) * r);
+            n.object_space_parent_transforms.emplace_back(1.f);
+            const float x = dist(gen);
+            const float y = dist(gen);
+            const float z = dist(gen);
+            n.bounds.push_back({x - 1.f, y - 1.f, z - 1.f, x + 1.f, y + 1.f, z + 1.f});
+        }
+        n.object_spaces.resize(num_nodes, glm::mat4{1.f});
+        n.world_transforms.resize(num_nodes, glm::mat4{1.f});
+        n.inverses.resize(num_nodes, glm::mat4{1.f});
+        n.normals.resize(num_nodes);
+        n.world_bounds.resize(num_nodes);
+        return n;
+    }
+
+    // The math Node.cpp ran for every node before the kernels, one node at a time.
+    void glm_compose(bench_nodes& n)
+    {
+        for (size_t i{0}; i < n.parents.size(); i++)
+        {
+            if (n.parents[i] != transform_no_parent) n.object_space_parent_transforms[i] = n.object_spaces[n.parents[i]];
+            n.object_spaces[i] = n.object_space_parent_transforms[i] * n.object_space_transforms[i];
+            const glm::mat4 t = translate(glm::mat4(1.f), n.translates[i]);
+            const glm::mat4 r = toMat4(angleAxis(n.yaws[i], glm::vec3{0.f, -1.f, 0.f}));
+            const glm::mat4 s = scale(glm::mat4(1.f), glm::vec3(n.scales[i], n.scales[i], n.scales[i]));
+            n.world_transforms[i] = t * r * s * n.coordinate_systems[i] * n.object_spaces[i];
+        }
+    }
+
+    void glm_affine_inverse(bench_nodes& n)
+    {
+        for (size_t i{0}; i < n.parents.size(); i++) n.inverses[i] = inverse(n.world_transforms[i]);
+    }
+
+    void glm_normal_matrix(bench_nodes& n)
+    {
+        for (size_t i{0}; i < n.parents.size(); i++)
+        {
+            const glm::mat3 normal = transpose(inverse(glm::mat3(n.world_transforms[i])));
+            std::copy_n(glm::value_ptr(normal), 9, n.normals[i].data());
+        }
+    }
+
+    void glm_transform_bounds(bench_nodes& n)
+    {
+        for (size_t i{0}; i < n.parents.size(); i++)
+        {
+            const std::array<float, 6>& b = n.bounds[i];
+            glm::vec3 lower{std::numeric_limits<float>::max()};
+            glm::vec3 upper{std::numeric_limits<float>::lowest()};
+            for (int corner{0}; corner < 8; corner++)
+            {
+                const glm::vec4 p{b[(corner & 1) ? 3 : 0], b[(corner & 2) ? 4 : 1], b[(corner & 4) ? 5 : 2], 1.f};
+                const glm::vec3 w{n.world_transforms[i] * p};
+                lower = glm::min(lower, w);
+                upper = glm::max(upper, w);
+            }
+            n.world_bounds[i] = {lower.x, lower.y, lower.z, upper.x, upper.y, upper.z};
+        }
+    }
+
+    // Parents have to be composed before children, so roots and children are two batches as in node_graph.
+    void kernel_compose(const transform_kernels& k, bench_nodes& n, const std::vector<uint32_t>& roots, const std::vector<uint32_t>& children)
+    {
+        for (const std::vector<uint32_t>* batch : {&roots, &children})
+        {
+            k.compose({
+                .indices = batch->data(),
+                .count = batch->size(),
+                .parents = n.parents.data(),
+                .translates = glm::value_ptr(n.translates.front()),
+                .scales = n.scales.data(),
+                .yaws = n.yaws.data(),
+                .coordinate_systems = glm::value_ptr(n.coordinate_systems.front()),
+                .object_space_transforms = glm::value_ptr(n.object_space_transforms.front()),
+                .object_space_parent_transforms = glm::value_ptr(n.object_space_parent_transforms.front()),
+                .object_spaces = glm::value_ptr(n.object_spaces.front()),
+                .world_transforms = glm::value_ptr(n.world_transforms.front()),
+            });
+        }
+    }
+
+    template <typename F>
+    double nanoseconds_per_node(const size_t num_nodes, const size_t iterations, F f)
+    {
+        f(); // warm up
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i{0}; i < iterations; i++) f();
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations * num_nodes);
+    }
+
+    float max_difference(const float* a, const float* b, const size_t count)
+    {
+        float diff{0.f};
+        for (size_t i{0}; i < count; i++) diff = std::max(diff, std::abs(a[i] - b[i]));
+        return diff;
+    }
+
+    void report(const std::string_view name, const double glm_ns, const double kernel_ns, const float difference)
+    {
+        std::cout << std::format("  {:<18} glm {:8.2f} ns/node  kernel {:8.2f} ns/node  speedup {:5.2f}x  max difference {}\n", name, glm_ns, kernel_ns,
+                                 glm_ns / kernel_ns, difference);
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    const size_t num_nodes = argc > 1 ? std::stoul(argv[1]) : 10'000;
+    const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200;
+    if (num_nodes == 0 || iterations == 0)
+    {
+        std::cout << "usage: Bench.exe [number of nodes] [iterations]\n";
+        return 1;
+    }
+
+    bench_nodes reference = make_nodes(num_nodes);
+    std::vector<uint32_t> roots;
+    std::vector<uint32_t> children;
+    std::vector<uint32_t> all;
+    for (size_t i{0}; i < num_nodes; i++)
+    {
+        (reference.parents[i] == transform_no_parent ? roots : children).push_back(static_cast<uint32_t>(i));
+        all.push_back(static_cast<uint32_t>(i));
+    }
+
+    const double glm_compose_ns = nanoseconds_per_node(num_nodes, iterations, [&] { glm_compose(reference); });
+    const double glm_inverse_ns = nanoseconds_per_node(num_nodes, iterations, [&] { glm_affine_inverse(reference); });
+    const double glm_normal_ns = nanoseconds_per_node(num_nodes, iterations, [&] { glm_normal_matrix(reference); });
+    const double glm_bounds_ns = nanoseconds_per_node(num_nodes, iterations, [&] { glm_transform_bounds(reference); });
+
+    const transform_isa detected = detect_transform_isa();
+    std::cout << std::format("{} nodes, {} iterations, detected {}\n", num_nodes, iterations, transform_isa_name(detected));
+    for (const transform_isa isa : {transform_isa::scalar, transform_isa::sse, transform_isa::avx2})
+    {
+        if (isa > detected) break;
+        const transform_kernels& k = get_transform_kernels(isa);
+        bench_nodes n = make_nodes(num_nodes);
+        std::cout << std::format("{}\n", transform_isa_name(isa));
+
+        const double compose_ns = nanoseconds_per_node(num_nodes, iterations, [&] { kernel_compose(k, n, roots, children); });
+        report("compose", glm_compose_ns, compose_ns,
+               max_difference(glm::value_ptr(n.world_transforms.front()), glm::value_ptr(reference.world_transforms.front()), num_nodes * 16));
+
+        const double inverse_ns = nanoseconds_per_node(num_nodes, iterations, [&]
+        {
+            k.affine_inverse(all.data(), all.size(), glm::value_ptr(n.world_transforms.front()), glm::value_ptr(n.inverses.front()));
+        });
+        report("affine inverse", glm_inverse_ns, inverse_ns, max_difference(glm::value_ptr(n.inverses.front()), glm::value_ptr(reference.inverses.front()), num_nodes * 16));
+
+        const double normal_ns = nanoseconds_per_node(num_nodes, iterations, [&]
+        {
+            k.normal_matrix(all.data(), all.size(), glm::value_ptr(n.world_transforms.front()), n.normals.front().data());
+        });
+        report("normal matrix", glm_normal_ns, normal_ns, max_difference(n.normals.front().data(), reference.normals.front().data(), num_nodes * 9));
+
+        const double bounds_ns = nanoseconds_per_node(num_nodes, iterations, [&]
+        {
+            k.transform_bounds(all.data(), all.size(), glm::value_ptr(n.world_transforms.front()), n.bounds.front().data(), n.world_bounds.front().data());
+        });
+        report("transform bounds", glm_bounds_ns, bounds_ns, max_difference(n.world_bounds.front().data(), reference.world_bounds.front().data(), num_nodes * 6));
+    }
+    bench_navigation();
+    bench_collision();
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "NavigationBench.h"
+#include <random>
+#include "Engine/Navigation.h"
+
+using namespace rosy;
+
+namespace
+{
+    // A floor of one unit cells scattered with obstacles of one to four cells a side covering about a fifth of it, like furniture.
+    std::vector<node_bounds> make_obstacles(const uint32_t grid_size)
+    {
+        std::mt19937 gen{1234};
+        std::uniform_real_distribution<float> position{0.f, static_cast<float>(grid_size)};
+        std::uniform_real_distribution<float> extent{0.5f, 3.5f};
+        const size_t num_obstacles = static_cast<size_t>(grid_size) * grid_size / 20;
+        std::vector<node_bounds> obstacles;
+        obstacles.reserve(num_obstacles);
+        for (size_t i{0}; i < num_obstacles; i++)
+        {
+            const float x = position(gen);
+            const float z = position(gen);
+            obstacles.push_back({.min = {x, 0.f, z}, .max = {x + extent(gen), 1.f, z + extent(gen)}});
+        }
+        return obstacles;
+    }
+
+    template <typename F>
+    double milliseconds_per_run(const size_t iterations, F f)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i{0}; i < iterations; i++) f();
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / static_cast<double>(iterations);
+    }
+
+    void bench_grid_size(const std::shared_ptr<rosy_logger::log>& l, const uint32_t grid_size, const size_t iterations)
+    {
+        navigation nav{};
+        if (nav.init(l, 1.f) != result::ok) return;
+        const auto size = static_cast<float>(grid_size);
+        const node_bounds floor_bounds{.min = {0.f, 0.f, 0.f}, .max = {size, 0.f, size}};
+        const std::vector<node_bounds> obstacles = make_obstacles(grid_size);
+
+        const auto build_grid = [&]
+        {
+            if (nav.set_floor(floor_bounds) != result::ok) l->error("Error setting the navigation floor");
+            for (const node_bounds& b : obstacles) nav.set_blocked(b, true);
+        };
+        const double grid_ms = milliseconds_per_run(iterations, build_grid);
+
+        // Each run targets a different corner so the field is built instead of found in the cache.
+        const std::array<std::array<float, 3>, 4> targets{
+            {
+                {0.5f, 0.f, 0.5f},
+                {size - 0.5f, 0.f, 0.5f},
+                {0.5f, 0.f, size - 0.5f},
+                {size - 0.5f, 0.f, size - 0.5f},
+            }
+        };
+        size_t target_index{0};
+        const double field_ms = milliseconds_per_run(iterations, [&]
+        {
+            build_grid();
+            if (nav.prepare_field(targets[target_index++ % targets.size()]) != result::ok) l->error("Error preparing a flow field");
+        }) - grid_ms;
+
+        // A cached field repaired after an obstacle appears in the middle of the floor and again after it is removed.
+        const node_bounds wall{.min = {size * 0.25f, 0.f, size * 0.5f}, .max = {size * 0.75f, 1.f, size * 0.5f + 1.f}};
+        const double repair_ms = milliseconds_per_run(iterations, [&]
+        {
+            nav.set_blocked(wall, true);
+            nav.set_blocked(wall, false);
+        }) / 2.0;
+
+        // One lookup per mob, every mob heading to the same target.
+        std::mt19937 gen{42};
+        std::uniform_real_distribution<float> position{0.f, size};
+        std::vector<std::array<float, 3>> mobs(10'000);
+        for (auto& m : mobs) m = {position(gen), 0.f, position(gen)};
+        const std::array<float, 3>& target = targets[(target_index - 1) % targets.size()];
+        const size_t lookup_runs = iterations * 10;
+        size_t found{0};
+        const double lookup_ms = milliseconds_per_run(lookup_runs, [&]
+        {
+            for (const auto& m : mobs)
+            {
+                if (nav.flow_direction(target, m).has_value()) found += 1;
+            }
+        });
+        const double lookup_ns = lookup_ms * 1'000'000.0 / static_cast<double>(mobs.size());
+
+        std::cout << std::format("  {:>4}x{:<4} grid {:8.3f} ms  field {:8.3f} ms  repair {:8.3f} ms  lookup {:6.2f} ns/mob  {} obstacles  {} of {} mobs have a step\n",
+                                 grid_size, grid_size, grid_ms, field_ms, repair_ms, lookup_ns, obstacles.size(), found / lookup_runs, mobs.size());
+        nav.deinit();
+    }
+}
+
+void bench_navigation()
+{
+    const auto l = std::make_shared<rosy_logger::log>();
+    std::cout << "navigation\n";
+    bench_grid_size(l, 256, 20);
+    bench_grid_size(l, 1'024, 4);
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Flow field grid builds, field builds, field repairs and lookups on square floors of 256 and 1024 cells a side.
+void bench_navigation();
@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "Allocations.h"
+
+#if defined(DEBUG) && !defined(__SANITIZE_ADDRESS__)
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Shared by every counted thread so allocations made on flecs' and the worker pool's threads during an update are counted too.
+    std::atomic<uint64_t> allocation_count{0};
+    thread_local bool thread_counted{true};
+
+    void* counted_allocate(const size_t size)
+    {
+        if (thread_counted) allocation_count.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* counted_allocate_aligned(const size_t size, const size_t alignment)
+    {
+        if (thread_counted) allocation_count.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+        return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+        // aligned_alloc requires the size to be a multiple of the alignment.
+        return std::aligned_alloc(alignment, (std::max(size, static_cast<size_t>(1)) + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    void free_aligned(void* p)
+    {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+// The array, nothrow and sized forms of new and delete all forward to these four.
+
+void* operator new(const size_t size)
+{
+    if (void* p = counted_allocate(size); p != nullptr) return p;
+    throw std::bad_alloc{};
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+    if (void* p = counted_allocate_aligned(size, static_cast<size_t>(alignment)); p != nullptr) return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    free_aligned(p);
+}
+
+uint64_t rosy::heap_allocation_count()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+void rosy::exclude_thread_from_heap_allocation_count()
+{
+    thread_counted = false;
+}
+#else
+uint64_t rosy::heap_allocation_count()
+{
+    return 0;
+}
+
+void rosy::exclude_thread_from_heap_allocation_count()
+{
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#include "Types.h"
+
+namespace rosy
+{
+    // Debug builds replace the global operator new to count every heap allocation made through it, so the engine can check that a
+    // steady state frame allocates nothing. The count is shared by the main thread and the level's workers, flecs' and the worker
+    // pool's, so a span measured on the main thread includes what they allocated meanwhile. Allocations from malloc directly, like
+    // SDL's, flecs' and Dear ImGui's, are not counted. Always 0 in release and sanitizer builds, where the allocator is left alone.
+    [[nodiscard]] uint64_t heap_allocation_count();
+    // Leaves the calling thread's allocations out of the count, the render thread's frames overlap the level update it measures.
+    void exclude_thread_from_heap_allocation_count();
+}
@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "Arena.h"
+#include <bit>
+
+using namespace rosy;
+
+namespace
+{
+    std::byte* allocate_block(const size_t size)
+    {
+        return static_cast<std::byte*>(::operator new(size, std::align_val_t{arena::cache_line_size}, std::nothrow));
+    }
+
+    void free_block(const arena::block& b)
+    {
+        ::operator delete(b.memory, std::align_val_t{arena::cache_line_size});
+    }
+}
+
+void arena::deinit()
+{
+    for (const block& b : blocks) free_block(b);
+    blocks.clear();
+    used = 0;
+}
+
+void arena::reset()
+{
+    used = 0;
+    if (blocks.size() <= 1) return;
+
+    // The last level did not fit in one block, replace them all with one that would have fit it.
+    const size_t total = capacity();
+    deinit();
+    if (std::byte* memory = allocate_block(total); memory != nullptr) blocks.push_back({.memory = memory, .size = total});
+}
+
+void* arena::allocate(const size_t size, const size_t alignment)
+{
+    assert(alignment <= cache_line_size && std::has_single_bit(alignment));
+    if (!blocks.empty())
+    {
+        const size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (const block& b = blocks.back(); start + size <= b.size)
+        {
+            used = start + size;
+            return b.memory + start;
+        }
+    }
+
+    const size_t block_size = std::max(default_block_size, size);
+    std::byte* memory = allocate_block(block_size);
+    if (memory == nullptr) return nullptr;
+    blocks.push_back({.memory = memory, .size = block_size});
+    used = size;
+    return memory;
+}
+
+size_t arena::capacity() const
+{
+    size_t total{0};
+    for (const block& b : blocks) total += b.size;
+    return total;
+}
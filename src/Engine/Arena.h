@@ -0,0 +1,87 @@
+#pragma once
+#include "Types.h"
+#include <cassert>
+#include <memory>
+#include <span>
+#include <type_traits>
+
+namespace rosy
+{
+    // A bump allocator for data that lives exactly as long as a loaded level. Every allocation is cache line aligned and nothing is
+    // freed individually, reset releases everything at once. Memory comes in blocks, when a level needed more than one block the
+    // next reset replaces them with a single block big enough for all of it, so a reloaded level allocates from one block.
+    struct arena
+    {
+        static constexpr size_t cache_line_size{64};
+        static constexpr size_t default_block_size{1024 * 1024};
+
+        struct block
+        {
+            std::byte* memory{nullptr};
+            size_t size{0};
+        };
+
+        std::vector<block> blocks;
+        size_t used{0}; // bytes used of the last block
+
+        void deinit();
+        void reset();
+        // Returns nullptr when a new block could not be allocated.
+        [[nodiscard]] void* allocate(size_t size, size_t alignment = cache_line_size);
+        [[nodiscard]] size_t capacity() const;
+    };
+
+    // A fixed capacity array in an arena. Only trivially destructible types may be stored as an arena never runs destructors.
+    template <typename T>
+        requires std::is_trivially_destructible_v<T>
+    struct arena_array
+    {
+        T* items{nullptr};
+        size_t count{0};
+        size_t max_count{0};
+
+        [[nodiscard]] result init(arena& a, const size_t new_max_count)
+        {
+            count = 0;
+            max_count = new_max_count;
+            items = nullptr;
+            if (max_count == 0) return result::ok;
+            items = static_cast<T*>(a.allocate(sizeof(T) * max_count, std::max(alignof(T), arena::cache_line_size)));
+            if (items == nullptr)
+            {
+                max_count = 0;
+                return result::allocation_failure;
+            }
+            return result::ok;
+        }
+
+        // Forgets the memory, the arena owns it.
+        void release()
+        {
+            items = nullptr;
+            count = 0;
+            max_count = 0;
+        }
+
+        void push_back(const T& item)
+        {
+            assert(count < max_count);
+            std::construct_at(items + count, item);
+            count += 1;
+        }
+
+        [[nodiscard]] bool full() const { return count == max_count; }
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+        void clear() { count = 0; }
+        T* data() { return items; }
+        const T* data() const { return items; }
+        T& front() { return items[0]; }
+        T& operator[](const size_t i) { return items[i]; }
+        const T& operator[](const size_t i) const { return items[i]; }
+        T* begin() { return items; }
+        T* end() { return items + count; }
+        const T* begin() const { return items; }
+        const T* end() const { return items + count; }
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace rosy
+{
+    // Copies count items out of a file read whole into buffer, starting at offset and advancing it past them. Fails without changing
+    // anything when the buffer ends first, the items are read as raw memory so they must be trivially copyable.
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    [[nodiscard]] bool read_items(const std::vector<char>& buffer, size_t& offset, const uint64_t count, std::vector<T>& items)
+    {
+        if (offset > buffer.size() || count > (buffer.size() - offset) / sizeof(T)) return false;
+        items.resize(count);
+        std::memcpy(items.data(), buffer.data() + offset, count * sizeof(T));
+        offset += count * sizeof(T);
+        return true;
+    }
+}
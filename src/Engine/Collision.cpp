@@ -0,0 +1,538 @@
+#include "pch.h"
+#include "Collision.h"
+#include <cmath>
+
+using namespace rosy;
+
+namespace
+{
+    // An endpoint's id is the index of its body or static with a flag for which of the two it is and another for its bounds' max side.
+    constexpr uint32_t endpoint_max_bit{1u << 31};
+    constexpr uint32_t endpoint_static_bit{1u << 30};
+    constexpr uint32_t endpoint_index_mask{endpoint_static_bit - 1};
+    // Candidate pairs reserved per body when the sweep is sized, more grow the list once.
+    constexpr size_t candidates_reserved_per_body{8};
+
+    struct endpoint
+    {
+        float value{0.f};
+        uint32_t id{0};
+    };
+
+    // A min side goes before a max side at the same value, so bounds without width open before they close and touching bounds overlap.
+    [[nodiscard]] bool endpoint_before(const endpoint& a, const endpoint& b)
+    {
+        if (a.value != b.value) return a.value < b.value;
+        return (a.id & endpoint_max_bit) == 0 && (b.id & endpoint_max_bit) != 0;
+    }
+
+    // A body's or static's bounds on the other two axes, kept together so the sweep compares them without chasing its arrays.
+    struct sweep_bounds
+    {
+        float min_z{0.f};
+        float max_z{0.f};
+        float bottom{0.f};
+        float top{0.f};
+        uint32_t index{0};
+    };
+
+    // The sweep already found the pair overlapping on x.
+    [[nodiscard]] bool overlaps(const sweep_bounds& a, const sweep_bounds& b)
+    {
+        return (a.max_z > b.min_z) & (a.min_z < b.max_z) & (a.top > b.bottom) & (a.bottom < b.top);
+    }
+
+    struct static_prism
+    {
+        std::array<float, 2> min{0.f, 0.f}; // x and z
+        std::array<float, 2> max{0.f, 0.f};
+        float bottom{0.f};
+        float top{0.f};
+        uint32_t first_vertex{0};
+        uint32_t num_vertices{0}; // 0 for boxes
+    };
+
+    // Counter clockwise in the xz plane with x to the right and z up.
+    float cross(const std::array<float, 2>& o, const std::array<float, 2>& a, const std::array<float, 2>& b)
+    {
+        return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+    }
+
+    // Andrew's monotone chain. The hull is counter clockwise without collinear corners, points are sorted in place.
+    void convex_hull(std::vector<std::array<float, 2>>& points, std::vector<std::array<float, 2>>& hull)
+    {
+        hull.clear();
+        std::ranges::sort(points);
+        const auto last = std::ranges::unique(points);
+        points.erase(last.begin(), last.end());
+        if (points.size() < 3)
+        {
+            hull = points;
+            return;
+        }
+        hull.resize(points.size() * 2);
+        size_t k{0};
+        for (const std::array<float, 2>& p : points)
+        {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], p) <= 0.f) k--;
+            hull[k++] = p;
+        }
+        const size_t lower_size = k + 1;
+        for (size_t i = points.size() - 1; i > 0; i--)
+        {
+            const std::array<float, 2>& p = points[i - 1];
+            while (k >= lower_size && cross(hull[k - 2], hull[k - 1], p) <= 0.f) k--;
+            hull[k++] = p;
+        }
+        // The last corner is the first one again.
+        hull.resize(k - 1);
+    }
+
+    [[nodiscard]] bool is_box(const std::vector<std::array<float, 2>>& hull)
+    {
+        if (hull.size() != 4) return false;
+        for (size_t i{0}; i < 4; i++)
+        {
+            const std::array<float, 2>& a = hull[i];
+            const std::array<float, 2>& b = hull[(i + 1) % 4];
+            if (a[0] != b[0] && a[1] != b[1]) return false;
+        }
+        return true;
+    }
+
+    // Each returns whether a circle of radius r at x, z overlaps the footprint and if so the smallest move that takes it out.
+    [[nodiscard]] bool push_out_of_box(const static_prism& s, const float x, const float z, const float r, std::array<float, 2>& push)
+    {
+        const float dx = x - std::clamp(x, s.min[0], s.max[0]);
+        const float dz = z - std::clamp(z, s.min[1], s.max[1]);
+        const float d2 = dx * dx + dz * dz;
+        if (d2 >= r * r) return false;
+        if (d2 > 0.f)
+        {
+            const float d = std::sqrt(d2);
+            const float depth = r - d;
+            push = {dx / d * depth, dz / d * depth};
+            return true;
+        }
+        // The center is inside, it leaves through the nearest side.
+        const std::array<float, 4> exits{x - s.min[0], s.max[0] - x, z - s.min[1], s.max[1] - z};
+        const auto side = std::ranges::min_element(exits) - exits.begin();
+        const float depth = exits[static_cast<size_t>(side)] + r;
+        switch (side)
+        {
+        case 0: push = {-depth, 0.f};
+            break;
+        case 1: push = {depth, 0.f};
+            break;
+        case 2: push = {0.f, -depth};
+            break;
+        default: push = {0.f, depth};
+            break;
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool push_out_of_hull(const std::array<float, 2>* vertices, const std::array<float, 2>* normals, const size_t count, const float x,
+                                        const float z, const float r, std::array<float, 2>& push)
+    {
+        // How far the center is outside each edge's line, the largest is its distance to the hull when it is inside or beside an edge.
+        float max_separation{std::numeric_limits<float>::lowest()};
+        size_t max_edge{0};
+        for (size_t i{0}; i < count; i++)
+        {
+            const float separation = (x - vertices[i][0]) * normals[i][0] + (z - vertices[i][1]) * normals[i][1];
+            if (separation > max_separation)
+            {
+                max_separation = separation;
+                max_edge = i;
+            }
+        }
+        if (max_separation >= r) return false;
+        if (max_separation <= 0.f)
+        {
+            const float depth = r - max_separation;
+            push = {normals[max_edge][0] * depth, normals[max_edge][1] * depth};
+            return true;
+        }
+        // Outside, the nearest point of the boundary may be a corner.
+        float nearest_d2{std::numeric_limits<float>::max()};
+        std::array<float, 2> nearest{0.f, 0.f};
+        for (size_t i{0}; i < count; i++)
+        {
+            const std::array<float, 2>& a = vertices[i];
+            const std::array<float, 2>& b = vertices[(i + 1) % count];
+            const float ex = b[0] - a[0];
+            const float ez = b[1] - a[1];
+            const float t = std::clamp(((x - a[0]) * ex + (z - a[1]) * ez) / (ex * ex + ez * ez), 0.f, 1.f);
+            const std::array<float, 2> q{a[0] + ex * t, a[1] + ez * t};
+            const float d2 = (x - q[0]) * (x - q[0]) + (z - q[1]) * (z - q[1]);
+            if (d2 < nearest_d2)
+            {
+                nearest_d2 = d2;
+                nearest = q;
+            }
+        }
+        if (nearest_d2 >= r * r) return false;
+        const float d = std::sqrt(nearest_d2);
+        const float depth = r - d;
+        push = {(x - nearest[0]) / d * depth, (z - nearest[1]) / d * depth};
+        return true;
+    }
+}
+
+struct collision_state
+{
+    std::vector<collision_body> bodies;
+    // Where each body was moved to by the last resolve.
+    std::vector<float> body_x;
+    std::vector<float> body_y;
+    std::vector<float> body_z;
+    std::vector<static_prism> statics;
+    std::vector<std::array<float, 2>> hull_vertices;
+    // Each hull edge's outward normal, the edge from a vertex to the next one.
+    std::vector<std::array<float, 2>> hull_normals;
+
+    // Sweep and prune
+    std::vector<endpoint> endpoints;
+    std::vector<sweep_bounds> body_bounds;
+    std::vector<sweep_bounds> static_bounds;
+    std::vector<sweep_bounds> active_bodies;
+    std::vector<sweep_bounds> active_statics;
+    // Where each body and static is in its active list while the sweep is inside its bounds.
+    std::vector<uint32_t> body_active_slots;
+    std::vector<uint32_t> static_active_slots;
+    // Body and static pairs, only the first num_candidates are this resolve's.
+    std::vector<std::array<uint32_t, 2>> candidates;
+    size_t num_candidates{0};
+    collision_stats stats{};
+    bool prepared{false};
+
+    // Only used while adding statics.
+    std::vector<std::array<float, 2>> footprint;
+    std::vector<std::array<float, 2>> hull;
+
+    [[nodiscard]] float endpoint_value(const uint32_t id) const
+    {
+        const uint32_t index = id & endpoint_index_mask;
+        const bool is_max = (id & endpoint_max_bit) != 0;
+        if ((id & endpoint_static_bit) != 0) return is_max ? statics[index].max[0] : statics[index].min[0];
+        return is_max ? body_x[index] + bodies[index].radius : body_x[index] - bodies[index].radius;
+    }
+
+
+    [[nodiscard]] result add_static(const static_prism& sp)
+    {
+        if (statics.size() >= endpoint_index_mask)
+        {
+            return result::overflow;
+        }
+        statics.push_back(sp);
+        prepared = false;
+        return result::ok;
+    }
+
+    // Moves endpoints left past larger ones. Most are already in place and cost a comparison.
+    void sort_endpoints()
+    {
+        for (size_t i{1}; i < endpoints.size(); i++)
+        {
+            const endpoint e = endpoints[i];
+            size_t j = i;
+            while (j > 0 && endpoint_before(e, endpoints[j - 1]))
+            {
+                endpoints[j] = endpoints[j - 1];
+                j--;
+            }
+            stats.endpoint_swaps += i - j;
+            endpoints[j] = e;
+        }
+    }
+
+    void sweep()
+    {
+        for (size_t i{0}; i < bodies.size(); i++)
+        {
+            const collision_body& b = bodies[i];
+            body_bounds[i] = {
+                .min_z = body_z[i] - b.radius,
+                .max_z = body_z[i] + b.radius,
+                .bottom = body_y[i] + b.bottom,
+                .top = body_y[i] + b.top,
+                .index = static_cast<uint32_t>(i),
+            };
+        }
+        num_candidates = 0;
+        // Every pair tested is written and kept only if it overlaps, which is cheaper than branching on dense floors.
+        const auto make_room = [this](const size_t count)
+        {
+            if (candidates.size() < num_candidates + count) candidates.resize(std::max(candidates.size() * 2, num_candidates + count));
+        };
+        const auto deactivate = [](std::vector<sweep_bounds>& active, std::vector<uint32_t>& slots, const uint32_t index)
+        {
+            const uint32_t slot = slots[index];
+            active[slot] = active.back();
+            slots[active[slot].index] = slot;
+            active.pop_back();
+        };
+        for (const endpoint& e : endpoints)
+        {
+            const uint32_t index = e.id & endpoint_index_mask;
+            const bool is_static = (e.id & endpoint_static_bit) != 0;
+            if ((e.id & endpoint_max_bit) != 0)
+            {
+                if (is_static) deactivate(active_statics, static_active_slots, index);
+                else deactivate(active_bodies, body_active_slots, index);
+                continue;
+            }
+            if (is_static)
+            {
+                const sweep_bounds& sb = static_bounds[index];
+                make_room(active_bodies.size());
+                for (const sweep_bounds& bb : active_bodies)
+                {
+                    candidates[num_candidates] = {bb.index, index};
+                    num_candidates += overlaps(bb, sb) ? 1 : 0;
+                }
+                static_active_slots[index] = static_cast<uint32_t>(active_statics.size());
+                active_statics.push_back(sb);
+            }
+            else
+            {
+                const sweep_bounds& bb = body_bounds[index];
+                make_room(active_statics.size());
+                for (const sweep_bounds& sb : active_statics)
+                {
+                    candidates[num_candidates] = {index, sb.index};
+                    num_candidates += overlaps(bb, sb) ? 1 : 0;
+                }
+                body_active_slots[index] = static_cast<uint32_t>(active_bodies.size());
+                active_bodies.push_back(bb);
+            }
+        }
+    }
+};
+
+result collision::init(const std::shared_ptr<rosy_logger::log>& new_log)
+{
+    l = new_log;
+    if (cs = new(std::nothrow) collision_state; cs == nullptr)
+    {
+        l->error("Error allocating collision state");
+        return result::allocation_failure;
+    }
+    return result::ok;
+}
+
+void collision::deinit()
+{
+    delete cs;
+    cs = nullptr;
+}
+
+void collision::clear() const
+{
+    cs->bodies.clear();
+    cs->body_x.clear();
+    cs->body_y.clear();
+    cs->body_z.clear();
+    cs->statics.clear();
+    cs->hull_vertices.clear();
+    cs->hull_normals.clear();
+    cs->endpoints.clear();
+    cs->body_bounds.clear();
+    cs->static_bounds.clear();
+    cs->active_bodies.clear();
+    cs->active_statics.clear();
+    cs->num_candidates = 0;
+    cs->stats = {};
+    cs->prepared = false;
+}
+
+result collision::add_static_box(const node_bounds& bounds) const
+{
+    if (bounds.empty()) return result::ok;
+    for (size_t i{0}; i < 3; i++)
+    {
+        if (!std::isfinite(bounds.min[i]) || !std::isfinite(bounds.max[i]))
+        {
+            l->error("collision cannot add a static box with non finite bounds");
+            return result::invalid_argument;
+        }
+    }
+    if (const auto res = cs->add_static({
+        .min = {bounds.min[0], bounds.min[2]},
+        .max = {bounds.max[0], bounds.max[2]},
+        .bottom = bounds.min[1],
+        .top = bounds.max[1],
+    }); res != result::ok)
+    {
+        l->error(std::format("collision cannot add more than {} statics", endpoint_index_mask));
+        return res;
+    }
+    return result::ok;
+}
+
+result collision::add_static_hull(const std::span<const std::array<float, 3>> points) const
+{
+    if (points.empty()) return result::ok;
+    node_bounds bounds{};
+    cs->footprint.clear();
+    for (const std::array<float, 3>& p : points)
+    {
+        if (!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2]))
+        {
+            l->error("collision cannot add a static hull with non finite points");
+            return result::invalid_argument;
+        }
+        bounds.merge({.min = p, .max = p});
+        cs->footprint.push_back({p[0], p[2]});
+    }
+    convex_hull(cs->footprint, cs->hull);
+    // Flat footprints, like a wall without thickness, are their box, which is a line.
+    if (cs->hull.size() < 3 || cs->hull.size() > max_hull_vertices || is_box(cs->hull)) return add_static_box(bounds);
+
+    static_prism sp{
+        .min = {bounds.min[0], bounds.min[2]},
+        .max = {bounds.max[0], bounds.max[2]},
+        .bottom = bounds.min[1],
+        .top = bounds.max[1],
+        .first_vertex = static_cast<uint32_t>(cs->hull_vertices.size()),
+        .num_vertices = static_cast<uint32_t>(cs->hull.size()),
+    };
+    if (const auto res = cs->add_static(sp); res != result::ok)
+    {
+        l->error(std::format("collision cannot add more than {} statics", endpoint_index_mask));
+        return res;
+    }
+    for (size_t i{0}; i < cs->hull.size(); i++)
+    {
+        const std::array<float, 2>& a = cs->hull[i];
+        const std::array<float, 2>& b = cs->hull[(i + 1) % cs->hull.size()];
+        const float ex = b[0] - a[0];
+        const float ez = b[1] - a[1];
+        const float length = std::sqrt(ex * ex + ez * ez);
+        cs->hull_vertices.push_back(a);
+        cs->hull_normals.push_back({ez / length, -ex / length});
+    }
+    return result::ok;
+}
+
+result collision::add_body(const collision_body& body, const std::array<float, 3>& position) const
+{
+    if (!(body.radius > 0.f) || !std::isfinite(body.radius) || !(body.top >= body.bottom))
+    {
+        l->error(std::format("invalid collision body radius {} bottom {} top {}", body.radius, body.bottom, body.top));
+        return result::invalid_argument;
+    }
+    if (cs->bodies.size() >= endpoint_index_mask)
+    {
+        l->error(std::format("collision cannot add more than {} bodies", endpoint_index_mask));
+        return result::overflow;
+    }
+    cs->bodies.push_back(body);
+    cs->body_x.push_back(position[0]);
+    cs->body_y.push_back(position[1]);
+    cs->body_z.push_back(position[2]);
+    cs->prepared = false;
+    return result::ok;
+}
+
+result collision::prepare() const
+{
+    const size_t num_bodies = cs->bodies.size();
+    const size_t num_statics = cs->statics.size();
+    cs->endpoints.clear();
+    cs->endpoints.reserve((num_bodies + num_statics) * 2);
+    for (uint32_t i{0}; i < num_statics; i++)
+    {
+        for (const uint32_t side : {0u, endpoint_max_bit})
+        {
+            const uint32_t id = i | endpoint_static_bit | side;
+            cs->endpoints.push_back({.value = cs->endpoint_value(id), .id = id});
+        }
+    }
+    for (uint32_t i{0}; i < num_bodies; i++)
+    {
+        for (const uint32_t side : {0u, endpoint_max_bit})
+        {
+            const uint32_t id = i | side;
+            cs->endpoints.push_back({.value = cs->endpoint_value(id), .id = id});
+        }
+    }
+    std::ranges::sort(cs->endpoints, endpoint_before);
+    cs->body_bounds.resize(num_bodies);
+    cs->static_bounds.resize(num_statics);
+    for (uint32_t i{0}; i < num_statics; i++)
+    {
+        const static_prism& sp = cs->statics[i];
+        cs->static_bounds[i] = {.min_z = sp.min[1], .max_z = sp.max[1], .bottom = sp.bottom, .top = sp.top, .index = i};
+    }
+    cs->active_bodies.clear();
+    cs->active_bodies.reserve(num_bodies);
+    cs->active_statics.clear();
+    cs->active_statics.reserve(num_statics);
+    cs->body_active_slots.resize(num_bodies);
+    cs->static_active_slots.resize(num_statics);
+    cs->candidates.resize(std::max(cs->candidates.size(), num_bodies * candidates_reserved_per_body));
+    cs->stats = {};
+    cs->prepared = true;
+    l->info(std::format("collision prepared for {} bodies and {} statics, {} of them hulls", num_bodies, num_statics,
+                        std::ranges::count_if(cs->statics, [](const static_prism& sp) { return sp.num_vertices > 0; })));
+    return result::ok;
+}
+
+void collision::resolve(float* xs, const float* ys, float* zs, uint8_t* pushed) const
+{
+    assert(cs->prepared);
+    const size_t num_bodies = cs->bodies.size();
+    std::copy_n(xs, num_bodies, cs->body_x.data());
+    std::copy_n(ys, num_bodies, cs->body_y.data());
+    std::copy_n(zs, num_bodies, cs->body_z.data());
+    std::fill_n(pushed, num_bodies, static_cast<uint8_t>(0));
+
+    cs->stats = {};
+    for (endpoint& e : cs->endpoints)
+    {
+        if ((e.id & endpoint_static_bit) == 0) e.value = cs->endpoint_value(e.id);
+    }
+    cs->sort_endpoints();
+    cs->sweep();
+    cs->stats.candidate_pairs = cs->num_candidates;
+
+    for (size_t i{0}; i < cs->num_candidates; i++)
+    {
+        const auto [body, s] = cs->candidates[i];
+        // Positions are read again for every pair as a body may already have been pushed by another static this resolve.
+        const static_prism& sp = cs->statics[s];
+        const float r = cs->bodies[body].radius;
+        std::array<float, 2> push{0.f, 0.f};
+        const bool touching = sp.num_vertices == 0
+                                  ? push_out_of_box(sp, xs[body], zs[body], r, push)
+                                  : push_out_of_hull(&cs->hull_vertices[sp.first_vertex], &cs->hull_normals[sp.first_vertex], sp.num_vertices, xs[body],
+                                                     zs[body], r, push);
+        if (!touching) continue;
+        xs[body] += push[0];
+        zs[body] += push[1];
+        cs->stats.contacts += 1;
+        if (pushed[body] == 0) cs->stats.bodies_pushed += 1;
+        pushed[body] = 1;
+    }
+    // The pushed positions are where the next resolve's insertion sort starts from.
+    std::copy_n(xs, num_bodies, cs->body_x.data());
+    std::copy_n(zs, num_bodies, cs->body_z.data());
+}
+
+size_t collision::num_bodies() const
+{
+    return cs->bodies.size();
+}
+
+size_t collision::num_statics() const
+{
+    return cs->statics.size();
+}
+
+collision_stats collision::stats() const
+{
+    return cs->stats;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Types.h"
+#include "Node.h"
+#include "Logger/Logger.h"
+#include <span>
+
+struct collision_state;
+
+namespace rosy
+{
+    // An upright capsule standing on a body's position, its axis runs from bottom to top above the position.
+    struct collision_body
+    {
+        float radius{0.f};
+        float bottom{0.f};
+        float top{0.f};
+    };
+
+    struct collision_stats
+    {
+        size_t endpoint_swaps{0}; // made re-sorting the endpoints
+        size_t candidate_pairs{0}; // bodies and statics whose bounds overlap
+        size_t contacts{0}; // candidate pairs found touching and pushed apart
+        size_t bodies_pushed{0};
+    };
+
+    // Keeps moving bodies out of static objects. Statics are upright prisms, a footprint in the xz plane over a height range, the
+    // footprint either a box or a convex hull. Bodies are upright capsules and are only ever pushed sideways, the floor they walk on
+    // and anything below their bottom does not push them.
+    // The broadphase is a sweep and prune along x. Every body's and static's bounds have two endpoints on x that stay sorted between
+    // resolves, moved bodies are sorted back into place with an insertion sort that costs next to nothing when they move a little
+    // each step. One sweep over the endpoints then yields every body and static whose bounds overlap on all three axes.
+    // Bodies are not collided with each other. A body pushed into another static's bounds is pushed out of it the next resolve.
+    // Everything is added while a level loads, resolve does not allocate once prepare has sized it.
+    struct collision
+    {
+        static constexpr size_t max_hull_vertices{32};
+
+        std::shared_ptr<rosy_logger::log> l{nullptr};
+        collision_state* cs{nullptr};
+
+        [[nodiscard]] result init(const std::shared_ptr<rosy_logger::log>& new_log);
+        void deinit();
+        // Forgets every body and static, their memory is kept for the next level.
+        void clear() const;
+
+        // The bounds' footprint over their height.
+        [[nodiscard]] result add_static_box(const node_bounds& bounds) const;
+        // The convex hull of the world space points' footprint over their height. Hulls with more than max_hull_vertices corners, or
+        // that are boxes anyway, are kept as boxes.
+        [[nodiscard]] result add_static_hull(std::span<const std::array<float, 3>> points) const;
+        // Bodies are numbered from 0 in the order they are added.
+        [[nodiscard]] result add_body(const collision_body& body, const std::array<float, 3>& position) const;
+        // Sorts the endpoints and sizes the sweep once every body and static is added.
+        [[nodiscard]] result prepare() const;
+
+        // Moves every body to its position in the arrays and pushes those overlapping a static out of it, writing their new x and z
+        // back. pushed is set for bodies that were pushed and cleared for the rest. Every array has num_bodies elements.
+        void resolve(float* xs, const float* ys, float* zs, uint8_t* pushed) const;
+
+        [[nodiscard]] size_t num_bodies() const;
+        [[nodiscard]] size_t num_statics() const;
+        // Counts from the last resolve.
+        [[nodiscard]] collision_stats stats() const;
+    };
+}
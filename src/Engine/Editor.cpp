@@ -2,6 +2,7 @@
 #include "Editor.h"
 #include <nlohmann/json.hpp>
 #include "Asset/Asset.h"
+#include "SceneSnapshot.h"
 
 using json = nlohmann::json;
 using namespace rosy;
@@ -185,28 +186,65 @@ namespace
     struct editor_manager
     {
         std::shared_ptr<rosy_logger::log> l{nullptr};
-        rosy_asset::asset level_asset;
-        std::vector<rosy_asset::asset*> origin_assets;
+        // The level's models combined into one asset. Assets handed to the level and the render thread are never changed, reloading the
+        // level builds a new one while the render thread may still hold the last.
+        std::shared_ptr<const rosy_asset::asset> combined_asset{};
+        std::vector<std::shared_ptr<const rosy_asset::asset>> origin_assets;
         std::vector<asset_description> asset_descriptions;
         rosy_editor::level_data ld;
         bool level_loaded{false};
         std::string asset_loaded{};
+        std::string level_path{};
 
-        result init(const std::shared_ptr<rosy_logger::log>& new_log)
+        result init(const std::shared_ptr<rosy_logger::log>& new_log, const std::string& new_level_path)
         {
             l = new_log;
+            level_path = new_level_path;
             return result::ok;
         }
 
+        // An .rsy level path is an asset loaded on its own, it has no level json to read models and views from or save to.
+        [[nodiscard]] bool level_is_asset() const
+        {
+            return std::filesystem::path(level_path).extension() == ".rsy";
+        }
+
         void deinit()
         {
             l = nullptr;
-            for (asset_description& desc : asset_descriptions)
+            // The render thread's copy of the read level state may still share these, they are freed with the last of them.
+            asset_descriptions.clear();
+            origin_assets.clear();
+            combined_asset = nullptr;
+        }
+
+        // An asset loaded on its own has its scene saved next to it, keyed on the asset file.
+        [[nodiscard]] static scene_snapshot_key asset_snapshot_key(const asset_description& desc)
+        {
+            return make_scene_snapshot_key(desc.id, {}, std::span{&desc.id, 1});
+        }
+
+        // Hands the level the combined asset with its scene saved next to the level json, keyed on the placed models and the assets they
+        // are placed from, or the first asset on its own when no models are placed.
+        void set_level_asset(level_editor_state* state) const
+        {
+            if (ld.models.empty())
             {
-                const auto a = static_cast<const rosy_asset::asset*>(desc.asset);
-                delete a;
-                desc.asset = nullptr;
+                state->new_asset = asset_descriptions[0].asset;
+                state->new_asset_snapshot = asset_snapshot_key(asset_descriptions[0]);
+                return;
             }
+            std::vector<std::string> placed_from;
+            for (const asset_description& a : asset_descriptions)
+            {
+                if (std::ranges::any_of(ld.models, [&a](const rosy_editor::level_data_model& m) { return m.id.starts_with(a.id); }))
+                {
+                    placed_from.push_back(a.id);
+                }
+            }
+            const json placed_models = ld.models;
+            state->new_asset = combined_asset;
+            state->new_asset_snapshot = make_scene_snapshot_key(level_path, placed_models.dump(-1, ' ', false, json::error_handler_t::replace), placed_from);
         }
 
         [[nodiscard]] result add_model(std::string id, editor_command::model_type type)
@@ -294,9 +332,14 @@ namespace
 
         [[nodiscard]] result write() const
         {
+            if (level_is_asset())
+            {
+                l->error(std::format("error writing level, {} is an asset and not a level json", level_path));
+                return result::invalid_state;
+            }
             try
             {
-                std::ofstream o("level1.json");
+                std::ofstream o(level_path);
                 json j;
                 to_json(j, ld);
                 o << std::setw(4) << j << '\n';
@@ -316,9 +359,15 @@ namespace
 
         [[nodiscard]] result read()
         {
+            if (level_is_asset())
+            {
+                ld = {};
+                ld.assets.push_back({.path = level_path});
+                return result::ok;
+            }
             try
             {
-                std::ifstream i("level1.json");
+                std::ifstream i(level_path);
                 json j;
                 i >> j;
 
@@ -363,6 +412,7 @@ namespace
                             if (a.id == cmd.id)
                             {
                                 state->new_asset = a.asset;
+                                state->new_asset_snapshot = asset_snapshot_key(a);
                                 level_loaded = false;
                                 asset_loaded = cmd.id;
                                 return result::ok;
@@ -390,7 +440,7 @@ namespace
                             l->error("Failed to load level asset during processing command");
                             return res;
                         }
-                        state->new_asset = ld.models.empty() ? asset_descriptions[0].asset : &level_asset;
+                        set_level_asset(state);
                         level_loaded = true;
                         return result::ok;
                     case editor_command::editor_command_type::add_to_level:
@@ -470,7 +520,7 @@ namespace
                             l->info(std::format("editor-command: load saved view {}", view_name));
                             if (view_to_load.level_loaded)
                             {
-                                state->new_asset = &level_asset;
+                                set_level_asset(state);
                                 level_loaded = true;
                             }
                             else
@@ -481,6 +531,7 @@ namespace
                                     if (a.id == view_to_load.asset_loaded)
                                     {
                                         state->new_asset = a.asset;
+                                        state->new_asset_snapshot = asset_snapshot_key(a);
                                         level_loaded = false;
                                         asset_loaded = cmd.id;
                                         return result::ok;
@@ -590,7 +641,7 @@ namespace
             }
             {
                 // Update post init state
-                state->new_asset = ld.models.empty() ? asset_descriptions[0].asset : &level_asset;
+                set_level_asset(state);
                 state->assets = asset_descriptions;
                 state->current_level_data.static_models.clear();
                 state->current_level_data.mob_models.clear();
@@ -633,14 +684,20 @@ namespace
             if (ld.models.empty()) return result::ok;
             if (origin_assets.empty())
             {
-                l->error("No origin assets when loading level asset. Create a level1.json file and put a path in assets");
+                l->error(std::format("No origin assets when loading level asset. Create {} and put a path in assets", level_path));
                 return result::error;
             }
             // This constructs a new asset from the pieces of other assets as defined in the level json file.
             // Meshes, samplers, images, nodes, materials all have to be re-indexed so all indexes are pointing to the correct items
             // they were in the original asset.
             level_asset_builder lab{};
-            level_asset = {};
+            const std::shared_ptr<rosy_asset::asset> built{new(std::nothrow) rosy_asset::asset};
+            if (built == nullptr)
+            {
+                l->error("level asset allocation failed");
+                return result::allocation_failure;
+            }
+            rosy_asset::asset& level_asset = *built;
 
             level_asset.shaders = origin_assets[0]->shaders; // Just use the first assets shaders, they're all the same right now.
             rosy_asset::scene new_scene{};
@@ -714,7 +771,7 @@ namespace
                     asset_helper.asset_id = asset_id;
                     // Find the origin assets index in the list of assets
                     bool found_asset_index{false};
-                    for (const rosy_asset::asset* a : origin_assets)
+                    for (const std::shared_ptr<const rosy_asset::asset>& a : origin_assets)
                     {
                         if (a->asset_path == asset_id)
                         {
@@ -735,7 +792,7 @@ namespace
                     l->info(std::format("using asset helper with id {} for {}", asset_helper_index, md.id));
                     // Keep a ref to the asset helper around and a pointer to the source asset, node name is found below
                     level_asset_builder_source_asset_helper& asset_helper = lab.assets[asset_helper_index];
-                    const rosy_asset::asset* a = origin_assets[asset_helper.rosy_package_asset_index];
+                    const rosy_asset::asset* a = origin_assets[asset_helper.rosy_package_asset_index].get();
                     std::string model_node_name{};
 
                     // Having an asset helper to work with, find this models node name in its origin asset by splitting up the model id until at the end.
@@ -1276,7 +1333,7 @@ namespace
             {
                 for (const level_asset_builder_index_map& parent_node_mapping : asset_helper.node_mappings)
                 {
-                    const rosy_asset::asset* a = origin_assets[asset_helper.rosy_package_asset_index];
+                    const rosy_asset::asset* a = origin_assets[asset_helper.rosy_package_asset_index].get();
                     rosy_asset::node& destination_node = level_asset.nodes[parent_node_mapping.destination_index];
                     const size_t num_child_nodes_expected = destination_node.child_nodes.size();
                     if (a->nodes[parent_node_mapping.source_index].child_nodes.size() != num_child_nodes_expected)
@@ -1311,6 +1368,7 @@ namespace
                 }
             }
             l->info("finished remapping level data models");
+            combined_asset = built;
             return result::ok;
         }
 
@@ -1318,8 +1376,8 @@ namespace
         {
             for (const auto& asset : ld.assets)
             {
-                rosy_asset::asset* a;
-                if (a = new(std::nothrow) rosy_asset::asset; a == nullptr)
+                const std::shared_ptr<rosy_asset::asset> a{new(std::nothrow) rosy_asset::asset};
+                if (a == nullptr)
                 {
                     l->error("asset allocation failed");
                     return result::allocation_failure;
@@ -1349,10 +1407,10 @@ namespace
                 asset_description desc{};
                 desc.id = asset_path.string();
                 desc.name = asset_path.filename().string();
-                desc.asset = static_cast<const void*>(a);
+                desc.asset = a;
                 origin_assets.push_back(a);
 
-                load_models(desc, a);
+                load_models(desc, a.get());
                 asset_descriptions.push_back(desc);
             }
             return result::ok;
@@ -1411,7 +1469,7 @@ namespace
 
 
 // ReSharper disable once CppMemberFunctionMayBeStatic
-result editor::init(const std::shared_ptr<rosy_logger::log>& new_log, [[maybe_unused]] config new_cfg)
+result editor::init(const std::shared_ptr<rosy_logger::log>& new_log, const config new_cfg)
 {
     if (em)
     {
@@ -1422,7 +1480,7 @@ result editor::init(const std::shared_ptr<rosy_logger::log>& new_log, [[maybe_un
         new_log->error("editor_manager allocation failed");
         return result::allocation_failure;
     }
-    if (const result res = em->init(new_log); res != result::ok)
+    if (const result res = em->init(new_log, new_cfg.level_path); res != result::ok)
     {
         new_log->error("editor_manager allocation failed");
         return res;
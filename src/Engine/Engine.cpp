@@ -1,6 +1,11 @@
 #include "pch.h"
 #include "Engine.h"
+#include "Allocations.h"
+#include "Math.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <SDL3/SDL.h>
 #include "imgui.h"
@@ -11,9 +16,77 @@
 #endif
 
 constexpr uint64_t sdl_time_to_seconds{1'000'000'000};
+// Frames after start up, a level load or an editor command in which the level and renderer may still grow their per frame buffers.
+constexpr uint32_t allocation_warm_up_frames{120};
+// Ten minutes at 120 frames a second, longer recordings grow as they go.
+constexpr size_t recorded_frames_reserved{72'000};
 
 using namespace rosy;
 
+// The main thread owns SDL and the level, the render thread owns graphics and builds the Dear ImGui frame. The level's read and write
+// states are double buffered: the render thread draws from its own copy of the read state and its UI writes into its own copy of
+// the write state. Everything below the mutex is owned by the render thread while has_frame is set and by the main thread while
+// it is not, and only engine::hand_off_frame moves data between the two copies. SDL is only called from the main thread, so the hand off
+// also feeds Dear ImGui its input, starts its SDL backend frame and queries the window size a resize needs.
+struct render_thread_state
+{
+    std::mutex mutex;
+    std::condition_variable frame_ready;
+    std::condition_variable frame_done;
+    bool has_frame{false};
+    bool stopping{false};
+    result render_result{result::ok};
+
+    read_level_state rls{};
+    write_level_state wls{};
+    engine_stats stats{};
+    // The window's size in pixels, the swapchain is recreated at it before the next frame is drawn when resize is set.
+    uint32_t window_width{0};
+    uint32_t window_height{0};
+    bool resize{false};
+    uint32_t viewport_width{0};
+    uint32_t viewport_height{0};
+    bool ui_wants_mouse{false};
+    bool ui_wants_keyboard{false};
+    // Frames nothing drawn has changed in for a while are handed over to keep the level's state whole but are not drawn.
+    bool redraw{true};
+    // Whether the renderer still had textures or meshes to stream after its last frame.
+    bool streaming{false};
+
+    // Set from the event watch, the window size is queried at the next hand off.
+    std::atomic<bool> resize_requested{false};
+    // Only ever touched by the main thread, SDL events for Dear ImGui passed to it at hand off while the render thread waits.
+    std::vector<SDL_Event> pending_ui_events;
+
+    std::jthread thread;
+};
+
+namespace
+{
+    void render_loop(engine* eng)
+    {
+        render_thread_state* rs = eng->rs;
+        // Drawing the previous frame overlaps the level update whose allocations the main thread checks.
+        exclude_thread_from_heap_allocation_count();
+        while (true)
+        {
+            {
+                std::unique_lock lock(rs->mutex);
+                rs->frame_ready.wait(lock, [rs] { return rs->has_frame || rs->stopping; });
+                if (!rs->has_frame) return;
+            }
+            const result res = eng->render_frame();
+            {
+                std::lock_guard lock(rs->mutex);
+                rs->render_result = res;
+                rs->has_frame = false;
+            }
+            rs->frame_done.notify_one();
+            if (res != result::ok) return;
+        }
+    }
+}
+
 //// Engine
 
 // ReSharper disable once CppParameterMayBeConstPtrOrRef
@@ -25,12 +98,8 @@ static bool event_handler(void* userdata, SDL_Event* event)  // NOLINT(misc-use-
     switch (event->type)
     {
     case SDL_EVENT_WINDOW_RESIZED:
-        if (result res = eng->gfx->resize(); res != result::ok)
-        {
-            eng->l->error(std::format("resizing-event: gfx failed to resize swapchain {}\n",
-                                      static_cast<uint8_t>(res)));
-            return false;
-        }
+        if (eng->rs == nullptr) break;
+        eng->rs->resize_requested = true;
         if (result res = eng->run_frame(); res != result::ok)
         {
             eng->l->error(std::format("resizing-event: gfx failed to render {}\n", static_cast<uint8_t>(res)));
@@ -41,7 +110,7 @@ static bool event_handler(void* userdata, SDL_Event* event)  // NOLINT(misc-use-
     return true;
 }
 
-result engine::init()
+result engine::init(const config& new_cfg)
 {
     try { l =  std::make_shared<rosy_logger::log>(); }
     catch (const std::bad_alloc&) {
@@ -61,7 +130,12 @@ result engine::init()
     }
     start_time = tick;
 
-    config cfg;
+    config cfg = new_cfg;
+    // Replays are timed frame by frame, so every frame of them is rendered.
+    render_on_demand = cfg.render_on_demand && cfg.input_replay_path.empty();
+    idle_render_delay = static_cast<uint64_t>(static_cast<double>(cfg.idle_render_delay) * static_cast<double>(sdl_time_to_seconds));
+    idle_wait_ms = static_cast<int32_t>(1'000 / std::max(1u, cfg.idle_update_rate));
+
     // SDL Window initialization.
     {
         if (!SDL_Init(SDL_INIT_VIDEO))
@@ -124,6 +198,15 @@ result engine::init()
         }
     }
 
+    // Input recording initialization
+    {
+        if (const auto res = start_input_recording(cfg); res != result::ok)
+        {
+            l->error(std::format("Input recording failed to start: {}", static_cast<uint8_t>(res)));
+            return res;
+        }
+    }
+
     // Graphics engine initialization
     {
         if (gfx = new(std::nothrow) graphics{}; gfx == nullptr)
@@ -136,6 +219,17 @@ result engine::init()
             l->error(std::format("Graphics creation failed: {}", static_cast<uint8_t>(res)));
             return res;
         }
+        viewport_width = gfx->viewport_width;
+        viewport_height = gfx->viewport_height;
+    }
+
+    // Render thread initialization
+    {
+        if (const auto res = start_render_thread(); res != result::ok)
+        {
+            l->error(std::format("Render thread creation failed: {}", static_cast<uint8_t>(res)));
+            return res;
+        }
     }
 
     l->info("Engine init done");
@@ -146,6 +240,16 @@ void engine::deinit()
 {
     if (l) l->info("Engine deinit start");
 
+    stop_render_thread();
+
+    if (recording)
+    {
+        // A failed write is already logged and leaves nothing to clean up.
+        if (!replaying && !record_path.empty() && recording->write(l, record_path) != result::ok) l->warn("Input recording was not saved");
+        delete recording;
+        recording = nullptr;
+    }
+
     if (gfx)
     {
         gfx->deinit();
@@ -180,6 +284,11 @@ result engine::run()
     SDL_Event event{};
     while (should_run)
     {
+        if (idle)
+        {
+            // Nothing drawn has changed for a while, the level is only updated when input arrives or the wait runs out.
+            SDL_WaitEventTimeout(nullptr, idle_wait_ms);
+        }
         while (SDL_PollEvent(&event))
         {
             if (event.type == SDL_EVENT_QUIT)
@@ -196,9 +305,12 @@ result engine::run()
             {
                 should_render = true;
             }
-            ImGui_ImplSDL3_ProcessEvent(&event);
-            if (const ImGuiIO& io = ImGui::GetIO(); !io.WantCaptureMouse && !io.WantCaptureKeyboard)
+            // Dear ImGui may be building a frame on the render thread, it is given the event at the next hand off.
+            rs->pending_ui_events.push_back(event);
+            // While replaying the level only gets the recorded input.
+            if (!ui_wants_mouse && !ui_wants_keyboard && !replaying)
             {
+                if (recording != nullptr) recording->record_event(event);
                 if (const auto res = lvl->process_sdl_event(event); res != result::ok)
                 {
                     return res;
@@ -211,8 +323,12 @@ result engine::run()
             continue;
         }
         if (!should_run) break;
+        if (replaying && replay_frame == recording->frames.size())
+        {
+            report_replay();
+            break;
+        }
         SDL_SetWindowRelativeMouseMode(window, !lvl->rls.cursor_enabled);
-        if (!lvl->rls.cursor_enabled) ImGui::SetMouseCursor(ImGuiMouseCursor_None);
         if (const auto res = this->run_frame(); res != result::ok)
         {
             l->error(std::format("frame failed: {}", static_cast<uint8_t>(res)));
@@ -239,19 +355,35 @@ result engine::run_frame()
         current_frame_time = tick - start_time;
         render_start = std::chrono::system_clock::now();
     }
+    // What the level is updated with, the recorded dt and viewport while replaying.
+    const uint64_t delta_time{current_frame_time - last_frame_time};
+    double dt = static_cast<double>(delta_time) / sdl_time_to_seconds;
+    if (dt > 0.25) dt = 0.25;
+    uint32_t update_width = viewport_width;
+    uint32_t update_height = viewport_height;
+    const bool replayed = replaying && replay_frame < recording->frames.size();
+    if (replayed)
+    {
+        if (const auto res = replay_input(dt, update_width, update_height); res != result::ok)
+        {
+            return res;
+        }
+    }
+    else if (recording != nullptr && !replaying)
+    {
+        recording->record_frame(dt, update_width, update_height);
+    }
     {
         // Prepare frame
         lvl->setup_frame();
     }
     // Track update time
     const auto update_start = std::chrono::system_clock::now();
+    const uint64_t update_allocations_start = heap_allocation_count();
+    const bool editing = !lvl->wls.editor_commands.commands.empty() || lvl->wls.mob_edit.submitted;
     {
         // Update
-        const uint64_t delta_time{current_frame_time - last_frame_time};
-        double dt = static_cast<double>(delta_time) / sdl_time_to_seconds;
-        if (dt > 0.25) dt = 0.25;
-
-        if (const auto res = lvl->update(gfx->viewport_width, gfx->viewport_height, dt); res != result::ok)
+        if (const auto res = lvl->update(update_width, update_height, dt); res != result::ok)
         {
             return res;
         }
@@ -262,10 +394,6 @@ result engine::run_frame()
         {
             return res;
         }
-        if (const auto res = gfx->update(lvl->rls, &lvl->wls); res != result::ok)
-        {
-            return res;
-        }
     }
     {
         // Record update time
@@ -274,12 +402,30 @@ result engine::run_frame()
         stats.level_update_time = elapsed.count() / 1000.f;
     }
     {
-        // Render
-        if (const auto res = gfx->render(stats); res != result::ok)
+        // Hand the frame to the render thread, which records it while the next frame is simulated.
+        if (const auto res = hand_off_frame(current_frame_time); res != result::ok)
         {
             return res;
         }
     }
+    {
+        // Once warmed up the level update and the handoff to the renderer reuse the memory of earlier frames, counted in debug builds only.
+        // Editor commands handed back by the render thread are copied, so they count as editing too.
+        const uint64_t update_allocations = heap_allocation_count() - update_allocations_start;
+        if (editing || !lvl->wls.editor_commands.commands.empty() || lvl->wls.mob_edit.submitted || lvl->rls.editor_state.new_asset != nullptr)
+        {
+            steady_frames = 0;
+        }
+        else if (steady_frames < allocation_warm_up_frames)
+        {
+            steady_frames += 1;
+        }
+        else if (update_allocations > 0)
+        {
+            l->warn(std::format("level update made {} heap allocations in a steady state frame", update_allocations));
+            assert(update_allocations == 0);
+        }
+    }
     {
         // Track timing
         const auto end = std::chrono::system_clock::now();
@@ -289,8 +435,206 @@ result engine::run_frame()
         stats.a_fps = std::numbers::pi_v<float> * stats.r_fps;
         stats.d_fps = (std::numbers::pi_v<float> * stats.r_fps) * (180.f / std::numbers::pi_v<float>);
         last_frame_time = current_frame_time;
+        if (replayed)
+        {
+            replay_frame_times.push_back(stats.frame_time);
+            replay_update_times.push_back(stats.level_update_time);
+        }
     }
 
     FrameMark;
     return result::ok;
 }
+
+result engine::start_render_thread()
+{
+    if (rs = new(std::nothrow) render_thread_state; rs == nullptr)
+    {
+        l->error("Error allocating render thread state");
+        return result::allocation_failure;
+    }
+    // The UI starts from the level's initial settings.
+    rs->wls = lvl->wls;
+    rs->viewport_width = viewport_width;
+    rs->viewport_height = viewport_height;
+    try
+    {
+        rs->thread = std::jthread([this] { render_loop(this); });
+    }
+    catch (const std::system_error& e)
+    {
+        l->error(std::format("Error starting the render thread: {}", e.what()));
+        return result::create_failed;
+    }
+    return result::ok;
+}
+
+result engine::hand_off_frame(const uint64_t frame_time)
+{
+    {
+        std::unique_lock lock(rs->mutex);
+        rs->frame_done.wait(lock, [this] { return !rs->has_frame; });
+        if (rs->render_result != result::ok)
+        {
+            l->error(std::format("render thread failed: {}", static_cast<uint8_t>(rs->render_result)));
+            return rs->render_result;
+        }
+        // Take back what the render thread's last frame wrote, the next update reads it. Editor commands and a submitted mob edit are
+        // consumed here so the render thread's next frame, which may not be drawn, does not hand them back again.
+        lvl->wls = rs->wls;
+        rs->wls.editor_commands.commands.clear();
+        if (rs->wls.mob_edit.submitted)
+        {
+            rs->wls.mob_edit.submitted = false;
+            rs->wls.mob_edit.updated = false;
+        }
+        viewport_width = rs->viewport_width;
+        viewport_height = rs->viewport_height;
+        ui_wants_mouse = rs->ui_wants_mouse;
+        ui_wants_keyboard = rs->ui_wants_keyboard;
+        const bool ui_input = !rs->pending_ui_events.empty();
+        for (SDL_Event& event : rs->pending_ui_events) ImGui_ImplSDL3_ProcessEvent(&event);
+        rs->pending_ui_events.clear();
+        if (rs->resize_requested.exchange(false))
+        {
+            int width{0};
+            int height{0};
+            if (!SDL_GetWindowSizeInPixels(window, &width, &height))
+            {
+                l->error(std::format("Error getting window size: {}", SDL_GetError()));
+                return result::error;
+            }
+            rs->window_width = static_cast<uint32_t>(width);
+            rs->window_height = static_cast<uint32_t>(height);
+            rs->resize = true;
+        }
+        // Give it this frame, to draw unless nothing it would draw or input it would pass the debug UI has changed for a while.
+        const bool changed = lvl->publish(rs->rls) || ui_input || rs->resize || rs->streaming;
+        if (changed) last_change_time = frame_time;
+        rs->redraw = !render_on_demand || frame_time - last_change_time < idle_render_delay;
+        if (idle == rs->redraw && l->level == rosy_logger::log_level::debug) l->debug(rs->redraw ? "Rendering resumed" : "Rendering idle");
+        idle = !rs->redraw;
+        // Reads the window and mouse and sets the cursor the last UI frame asked for, the render thread builds the UI frame this starts.
+        if (rs->redraw) ImGui_ImplSDL3_NewFrame();
+        rs->stats = stats;
+        rs->has_frame = true;
+    }
+    rs->frame_ready.notify_one();
+    return result::ok;
+}
+
+void engine::stop_render_thread()
+{
+    if (rs == nullptr) return;
+    {
+        std::unique_lock lock(rs->mutex);
+        rs->frame_done.wait(lock, [this] { return !rs->has_frame; });
+        rs->stopping = true;
+    }
+    rs->frame_ready.notify_one();
+    if (rs->thread.joinable()) rs->thread.join();
+    delete rs;
+    rs = nullptr;
+}
+
+result engine::render_frame()
+{
+    // The last image stays on screen.
+    if (!rs->redraw) return result::ok;
+    if (rs->resize)
+    {
+        rs->resize = false;
+        if (const auto res = gfx->resize(rs->window_width, rs->window_height); res != result::ok)
+        {
+            l->error(std::format("render thread failed to resize swapchain {}", static_cast<uint8_t>(res)));
+            return res;
+        }
+    }
+    if (const auto res = gfx->update(rs->rls, &rs->wls); res != result::ok)
+    {
+        return res;
+    }
+    if (const auto res = gfx->render(rs->stats, rs->rls.cursor_enabled); res != result::ok)
+    {
+        return res;
+    }
+    {
+        const ImGuiIO& io = ImGui::GetIO();
+        rs->ui_wants_mouse = io.WantCaptureMouse;
+        rs->ui_wants_keyboard = io.WantCaptureKeyboard;
+        rs->viewport_width = gfx->viewport_width;
+        rs->viewport_height = gfx->viewport_height;
+        rs->streaming = gfx->streaming();
+    }
+    return result::ok;
+}
+
+result engine::start_input_recording(const config& cfg)
+{
+    if (cfg.input_record_path.empty() && cfg.input_replay_path.empty()) return result::ok;
+    if (recording = new(std::nothrow) input_recording{}; recording == nullptr)
+    {
+        l->error("Error allocating input recording");
+        return result::allocation_failure;
+    }
+    if (!cfg.input_replay_path.empty())
+    {
+        if (const auto res = recording->read(l, cfg.input_replay_path); res != result::ok)
+        {
+            return res;
+        }
+        if (recording->level_path != cfg.level_path)
+        {
+            l->warn(std::format("input recording {} was made in {}, replaying it in {}", cfg.input_replay_path, recording->level_path, cfg.level_path));
+        }
+        if (recording->simulation_tick_rate != cfg.simulation_tick_rate)
+        {
+            l->warn(std::format("input recording {} was made at {} Hz, replaying it at {} Hz", cfg.input_replay_path, recording->simulation_tick_rate,
+                                cfg.simulation_tick_rate));
+        }
+        replaying = true;
+        replay_frame_times.reserve(recording->frames.size());
+        replay_update_times.reserve(recording->frames.size());
+        l->info(std::format("Replaying {} frames of input from {}", recording->frames.size(), cfg.input_replay_path));
+        return result::ok;
+    }
+    recording->level_path = cfg.level_path;
+    recording->simulation_tick_rate = cfg.simulation_tick_rate;
+    recording->reserve(recorded_frames_reserved);
+    record_path = cfg.input_record_path;
+    l->info(std::format("Recording input to {}", record_path));
+    return result::ok;
+}
+
+result engine::replay_input(double& dt, uint32_t& update_width, uint32_t& update_height)
+{
+    const recorded_frame& f = recording->frames[replay_frame];
+    for (size_t i{replay_event}; i < replay_event + f.num_events; i++)
+    {
+        if (const auto res = lvl->process_sdl_event(input_recording::to_sdl_event(recording->events[i])); res != result::ok)
+        {
+            return res;
+        }
+    }
+    replay_event += f.num_events;
+    replay_frame += 1;
+    dt = f.dt;
+    update_width = f.viewport_width;
+    update_height = f.viewport_height;
+    return result::ok;
+}
+
+void engine::report_replay() const
+{
+    std::vector<float> sorted_frame_times = replay_frame_times;
+    std::vector<float> sorted_update_times = replay_update_times;
+    std::ranges::sort(sorted_frame_times);
+    std::ranges::sort(sorted_update_times);
+    double frame_time_sum{0.0};
+    for (const float t : replay_frame_times) frame_time_sum += t;
+    const double frames = static_cast<double>(std::max(static_cast<size_t>(1), replay_frame_times.size()));
+    l->info(std::format("Replayed {} frames: frame mean {:.3f} ms p50 {:.3f} ms p99 {:.3f} ms max {:.3f} ms, level update p50 {:.3f} ms p99 {:.3f} ms",
+                        replay_frame_times.size(), frame_time_sum / frames, percentile(sorted_frame_times, 0.5), percentile(sorted_frame_times, 0.99),
+                        sorted_frame_times.empty() ? 0.f : sorted_frame_times.back(), percentile(sorted_update_times, 0.5),
+                        percentile(sorted_update_times, 0.99)));
+}
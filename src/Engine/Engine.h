@@ -3,11 +3,14 @@
 #include "Logger/Logger.h"
 #include "Graphics.h"
 #include "Level.h"
+#include "InputRecording.h"
 
 
 // ReSharper disable once CppInconsistentNaming
 using SDL_Window = struct SDL_Window;
 
+struct render_thread_state;
+
 namespace rosy
 {
     struct engine
@@ -17,6 +20,14 @@ namespace rosy
         SDL_Window* window{nullptr};
         level* lvl{nullptr};
         graphics* gfx{nullptr};
+        // Frames are rendered on their own thread while the main thread simulates the next one.
+        render_thread_state* rs{nullptr};
+
+        // What the render thread reported for the last frame it finished.
+        uint32_t viewport_width{0};
+        uint32_t viewport_height{0};
+        bool ui_wants_mouse{false};
+        bool ui_wants_keyboard{false};
 
         // Timing
         uint64_t start_time{0};
@@ -24,10 +35,40 @@ namespace rosy
 
         // Profiling
         engine_stats stats{};
+        // Frames the level update and renderer handoff have run without a level load or editor command, they may only allocate while warming up.
+        uint32_t steady_frames{0};
+
+        // Render on demand, idle once nothing drawn has changed for idle_render_delay in SDL time.
+        bool render_on_demand{false};
+        uint64_t idle_render_delay{0};
+        int32_t idle_wait_ms{0};
+        uint64_t last_change_time{0};
+        bool idle{false};
 
-        [[nodiscard]] result init();
+        // Input recording and replay, the recording is only made when either is asked for.
+        input_recording* recording{nullptr};
+        std::string record_path{};
+        bool replaying{false};
+        size_t replay_frame{0};
+        size_t replay_event{0};
+        std::vector<float> replay_frame_times;
+        std::vector<float> replay_update_times;
+
+        [[nodiscard]] result init(const config& new_cfg);
         [[nodiscard]] result run();
         [[nodiscard]] result run_frame();
         void deinit();
+
+        [[nodiscard]] result start_render_thread();
+        // Waits for the render thread to finish the frame it has, takes back its UI writes and gives it the level's new state, marked
+        // to be drawn unless nothing drawn has changed for a while.
+        [[nodiscard]] result hand_off_frame(uint64_t frame_time);
+        void stop_render_thread();
+        [[nodiscard]] result start_input_recording(const config& cfg);
+        // Feeds the level the next recorded frame's events and returns the dt and viewport it was updated with.
+        [[nodiscard]] result replay_input(double& dt, uint32_t& update_width, uint32_t& update_height);
+        void report_replay() const;
+        // Runs on the render thread.
+        [[nodiscard]] result render_frame();
     };
 }
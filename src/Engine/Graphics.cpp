@@ -15,6 +15,8 @@
 #include "backends/imgui_impl_vulkan.h"
 #include <dds.hpp>
 #include "Asset/Asset.h"
+#include <unordered_map>
+#include <span>
 
 using namespace rosy;
 
@@ -135,6 +137,8 @@ namespace
     constexpr uint64_t graphics_created_bit_shadow_pipeline = {1ULL << 41};
     constexpr uint64_t graphics_created_bit_msaa_image = {1ULL << 42};
     constexpr uint64_t graphics_created_bit_msaa_image_view = {1ULL << 43};
+    constexpr uint64_t graphics_created_bit_texture_staging_buffer = {1ULL << 44};
+    constexpr uint64_t graphics_created_bit_mesh_staging_buffer = {1ULL << 45};
 
     constexpr VkSampleCountFlagBits max_msaa_sample_size = VK_SAMPLE_COUNT_4_BIT;
 
@@ -277,6 +281,26 @@ namespace
         }
     }
 
+    VkExtent3D mip_extent(const VkExtent3D extent, const uint32_t mip)
+    {
+        return {
+            .width = std::max(extent.width >> mip, 1u),
+            .height = std::max(extent.height >> mip, 1u),
+            .depth = 1,
+        };
+    }
+
+    // Returns the first mip that is small enough to be uploaded when the level loads, a tail size of 0 disables streaming.
+    uint32_t texture_stream_tail_mip(const VkExtent3D extent, const uint32_t num_mips, const uint32_t tail_size)
+    {
+        if (tail_size == 0 || num_mips == 0) return 0;
+        for (uint32_t mip{0}; mip < num_mips; mip++)
+        {
+            if (const VkExtent3D e = mip_extent(extent, mip); std::max(e.width, e.height) <= tail_size) return mip;
+        }
+        return num_mips - 1;
+    }
+
     // These are written to buffer.
     struct gpu_scene_data
     {
@@ -315,6 +339,42 @@ namespace
         VkFormat image_format;
     };
 
+    enum class texture_stream_state : uint8_t
+    {
+        pending,
+        streaming,
+        resident,
+        failed, // left sampling its mip tail
+    };
+
+    // A texture that is sampled from its mip tail while its full mip chain is copied, smallest mip first, into a separate full size image
+    // over later frames. The bindless descriptor is only swapped to the full image once every mip is resident.
+    struct texture_stream
+    {
+        texture_stream_state state{texture_stream_state::pending};
+        size_t texture_index{0}; // index into dds_textures and image_views
+        uint32_t sampled_image_index{0}; // sampled image descriptor the mip tail was written to
+        std::string name{};
+        dds::Image dds_data{}; // kept on the CPU until the full chain is resident
+        VkFormat format{VK_FORMAT_UNDEFINED};
+        uint32_t num_mips{0};
+        int32_t next_mip{0}; // next mip to copy into the full image, counting down to 0
+        size_t full_chain_size{0};
+        allocated_image full_image{};
+        std::vector<size_t> graphic_object_indices{}; // graphic objects whose materials sample this texture
+        float camera_distance{(std::numeric_limits<float>::max)()};
+    };
+
+    // Resources replaced by a streamed texture that are destroyed once no frame in flight can still be sampling them.
+    struct texture_release
+    {
+        allocated_image image{};
+        VkImageView sampled_view{nullptr};
+        uint32_t sampled_image_index{0};
+        bool owns_sampled_image_index{true};
+        uint8_t frames_remaining{0};
+    };
+
     struct allocated_csm
     {
         VkImage image;
@@ -378,6 +438,40 @@ namespace
         uint64_t vertex_buffer_offset{0};
         uint32_t index_offset{0};
         uint32_t num_indices{0};
+        bool resident{true}; // surfaces of meshes that are not resident are not drawn
+    };
+
+    // A mesh of a level too large for the vertex and index pools. Its geometry is read from the asset, which is held while meshes
+    // stream, and copied into ranges suballocated from the pools while any cell using it is wanted.
+    struct mesh_stream
+    {
+        std::span<const rosy_asset::position> positions{};
+        std::span<const uint32_t> indices{};
+        std::array<float, 3> bounds_min{}; // object space
+        std::array<float, 3> bounds_max{};
+        VmaVirtualAllocation vertex_allocation{nullptr};
+        VmaVirtualAllocation index_allocation{nullptr};
+        uint32_t wanted_cells{0};
+    };
+
+    // Objects grouped by where they stand, the unit meshes are streamed in and evicted by. The pinned cell holds the dynamic objects,
+    // which can go anywhere, and is always wanted.
+    struct mesh_cell
+    {
+        std::array<float, 2> bounds_min{}; // xz
+        std::array<float, 2> bounds_max{}; // xz
+        std::vector<size_t> mesh_indices{};
+        bool pinned{false};
+        bool wanted{false};
+        float camera_distance{(std::numeric_limits<float>::max)()};
+    };
+
+    // Pool ranges of an evicted mesh that are freed once no frame in flight can still be drawing from them.
+    struct mesh_release
+    {
+        VmaVirtualAllocation vertex_allocation{nullptr};
+        VmaVirtualAllocation index_allocation{nullptr};
+        uint8_t frames_remaining{0};
     };
 
     struct gpu_scene_buffers
@@ -438,6 +532,8 @@ namespace
 
         // Buffers
         gpu_scene_buffers scene_buffer{};
+        allocated_buffer texture_staging_buffer{};
+        allocated_buffer mesh_staging_buffer{};
     };
 
     struct graphics_device
@@ -513,6 +609,8 @@ namespace
         VkCommandPool immediate_command_pool{nullptr};
 
         SDL_Window* window{nullptr};
+        // The window's size in pixels, SDL is only called from the main thread so the swapchain is created with the size it is given.
+        VkExtent2D window_extent{};
 
         // shaders
         std::vector<VkShaderEXT> debug_shaders;
@@ -527,13 +625,35 @@ namespace
         std::vector<VkSampler> samplers;
         std::vector<VkImageView> image_views;
         std::vector<allocated_image> dds_textures;
+        std::vector<texture_stream> texture_streams;
+        std::vector<texture_release> texture_releases;
+        std::vector<std::vector<size_t>> material_texture_streams; // material index to the texture streams its images use
+        std::vector<gpu_material> gpu_materials; // CPU copy of the material buffer, patched when a streamed texture swaps descriptors
+        std::vector<std::array<float, 3>> graphic_object_positions;
+        bool texture_streaming_over_budget{false};
         std::vector<gpu_mesh_buffers> gpu_meshes{};
+        bool mesh_streaming{false};
+        VmaVirtualBlock vertex_pool{nullptr};
+        VmaVirtualBlock index_pool{nullptr};
+        size_t largest_mesh_stream_size{0};
+        std::shared_ptr<const rosy_asset::asset> mesh_stream_asset{}; // owns the geometry mesh_streams point into
+        std::vector<mesh_stream> mesh_streams;
+        std::vector<mesh_cell> mesh_cells;
+        std::vector<size_t> mesh_cell_order; // mesh_cells sorted nearest first each frame
+        std::vector<mesh_release> mesh_releases;
+        std::vector<VkBufferCopy> mesh_vertex_copies;
+        std::vector<VkBufferCopy> mesh_index_copies;
+        bool mesh_streaming_over_budget{false};
         gpu_material_buffer material_buffer{};
         gpu_debug_draws_buffer debug_draws_buffer{};
         std::vector<surface_graphics_data> shadow_casting_graphics{};
         std::vector<surface_graphics_data> opaque_graphics{};
         std::vector<surface_graphics_data> blended_graphics{};
-        graphics_object_update graphics_object_update_data{};
+        // CPU copy of the dynamic graphics objects at the end of the graphics object buffers, and per frame buffer the ranges of it
+        // that changed since that buffer was last written.
+        size_t dynamic_graphic_objects_offset{0};
+        std::vector<graphic_object_data> dynamic_graphic_objects{};
+        std::array<std::vector<graphics_object_range>, max_frames_in_flight> pending_graphic_object_ranges{};
         std::vector<VkShaderEXT> scene_shaders;
         VkPipelineLayout scene_layout{};
 
@@ -758,6 +878,9 @@ namespace
                 vkDestroySampler(device, sampler, nullptr);
             }
 
+            destroy_texture_streams();
+            destroy_mesh_streams();
+
             for (const VkImageView& image_view : image_views)
             {
                 vkDestroyImageView(device, image_view, nullptr);
@@ -923,6 +1046,12 @@ namespace
                     vmaDestroyBuffer(
                         allocator, fd.graphic_objects_buffer.go_buffer.buffer,
                         fd.graphic_objects_buffer.go_buffer.allocation);
+                if (fd.frame_graphics_created_bitmask & graphics_created_bit_texture_staging_buffer)
+                    vmaDestroyBuffer(
+                        allocator, fd.texture_staging_buffer.buffer, fd.texture_staging_buffer.allocation);
+                if (fd.frame_graphics_created_bitmask & graphics_created_bit_mesh_staging_buffer)
+                    vmaDestroyBuffer(
+                        allocator, fd.mesh_staging_buffer.buffer, fd.mesh_staging_buffer.allocation);
             }
 
             if (graphics_created_bitmask & graphics_created_bit_msaa_image_view)
@@ -1642,13 +1771,7 @@ namespace
             {
                 return capabilities.currentExtent;
             }
-            int width, height;
-            SDL_GetWindowSizeInPixels(window, &width, &height);
-
-            VkExtent2D actual_extent = {
-                static_cast<uint32_t>(width),
-                static_cast<uint32_t>(height)
-            };
+            VkExtent2D actual_extent = window_extent;
 
             actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width,
                                              capabilities.maxImageExtent.width);
@@ -3522,118 +3645,981 @@ namespace
             return details;
         }
 
-        result set_asset(const rosy_asset::asset& a)
+        void destroy_texture_streams()
         {
+            // The device must be idle, nothing here waits for frames in flight.
+            for (const texture_stream& ts : texture_streams)
             {
-                // Clear any existing asset resources
+                if (ts.state == texture_stream_state::streaming && ts.full_image.graphics_created_bitmask & graphics_created_bit_dds_image)
+                {
+                    vmaDestroyImage(allocator, ts.full_image.image, ts.full_image.allocation);
+                }
+            }
+            texture_streams.clear();
+            for (const texture_release& tr : texture_releases)
+            {
+                destroy_texture_release(tr);
+            }
+            texture_releases.clear();
+            material_texture_streams.clear();
+            texture_streaming_over_budget = false;
+        }
 
-                if (graphics_created_bitmask & graphics_created_bit_device)
+        void destroy_texture_release(const texture_release& tr) const
+        {
+            vkDestroyImageView(device, tr.sampled_view, nullptr);
+            if (tr.image.graphics_created_bitmask & graphics_created_bit_dds_image_view)
+            {
+                vkDestroyImageView(device, tr.image.image_view, nullptr);
+            }
+            if (tr.image.graphics_created_bitmask & graphics_created_bit_dds_image)
+            {
+                vmaDestroyImage(allocator, tr.image.image, tr.image.allocation);
+            }
+            if (desc_sampled_images != nullptr && tr.owns_sampled_image_index)
+            {
+                desc_sampled_images->allocator.free(tr.sampled_image_index);
+            }
+        }
+
+        // A texture whose stream failed keeps sampling its mip tail. Frames in flight may still be copying into its full image, so the
+        // image is released like a replaced texture.
+        void abandon_texture_stream(texture_stream& ts)
+        {
+            if (ts.full_image.graphics_created_bitmask & graphics_created_bit_dds_image)
+            {
+                texture_releases.push_back({
+                    .image = ts.full_image,
+                    .sampled_view = nullptr,
+                    .sampled_image_index = 0,
+                    .owns_sampled_image_index = false,
+                    .frames_remaining = max_frames_in_flight,
+                });
+            }
+            ts.full_image = {};
+            ts.state = texture_stream_state::failed;
+            ts.dds_data = {};
+        }
+
+        void release_streamed_textures()
+        {
+            // Called once per frame after waiting on the current frame's fence, so after max_frames_in_flight calls no frame can be using a release.
+            for (size_t i{0}; i < texture_releases.size();)
+            {
+                if (texture_releases[i].frames_remaining > 0)
                 {
-                    if (const VkResult res = vkDeviceWaitIdle(device); res != VK_SUCCESS)
-                    {
-                        l->error(std::format("Failed to wait device to be idle to reset asset: {}",
-                                             static_cast<uint8_t>(res)));
-                        return result::error;
-                    }
+                    texture_releases[i].frames_remaining -= 1;
+                    i += 1;
+                    continue;
                 }
-                material_buffer.has_material = false;
-                for (const VkSampler& sampler : samplers)
+                destroy_texture_release(texture_releases[i]);
+                texture_releases[i] = texture_releases.back();
+                texture_releases.pop_back();
+            }
+        }
+
+        [[nodiscard]] float texture_stream_camera_distance(const texture_stream& ts) const
+        {
+            float closest{(std::numeric_limits<float>::max)()};
+            for (const size_t go_index : ts.graphic_object_indices)
+            {
+                if (go_index >= graphic_object_positions.size()) continue;
+                const auto& p = graphic_object_positions[go_index];
+                const float dx = p[0] - scene_data.camera_position[0];
+                const float dy = p[1] - scene_data.camera_position[1];
+                const float dz = p[2] - scene_data.camera_position[2];
+                closest = std::min(closest, dx * dx + dy * dy + dz * dz);
+            }
+            return closest == (std::numeric_limits<float>::max)() ? closest : std::sqrt(closest);
+        }
+
+        [[nodiscard]] bool texture_stream_fits_budget(const size_t size) const
+        {
+            VmaBudget budgets[VK_MAX_MEMORY_HEAPS]{};
+            vmaGetHeapBudgets(allocator, budgets);
+            for (uint32_t heap_index{0}; heap_index < physical_device_memory_properties.memoryHeapCount; heap_index++)
+            {
+                if (!(physical_device_memory_properties.memoryHeaps[heap_index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+                const auto allowed = static_cast<VkDeviceSize>(static_cast<double>(budgets[heap_index].budget) * static_cast<double>(cfg.texture_streaming_budget));
+                if (budgets[heap_index].usage + size <= allowed) return true;
+            }
+            return false;
+        }
+
+        result begin_texture_stream(texture_stream& ts)
+        {
+            VkImageCreateInfo image_create_info = dds::getVulkanImageCreateInfo(&ts.dds_data);
+            image_create_info.format = ts.format;
+            image_create_info.mipLevels = ts.num_mips;
+            image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            image_create_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+            VmaAllocationCreateInfo image_alloc_info{};
+            image_alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+            image_alloc_info.requiredFlags = static_cast<VkMemoryPropertyFlags>(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            ts.full_image = {};
+            if (const auto res = vmaCreateImage(allocator, &image_create_info, &image_alloc_info, &ts.full_image.image, &ts.full_image.allocation, nullptr); res != VK_SUCCESS)
+            {
+                l->error(std::format("Error creating streamed dds image {}: {}", ts.name, string_VkResult(res)));
+                return result::create_failed;
+            }
+            ts.full_image.graphics_created_bitmask |= graphics_created_bit_dds_image;
+            ts.full_image.image_extent = image_create_info.extent;
+            ts.full_image.image_format = ts.format;
+            {
+                const std::string object_name = std::format("rosy streamed img {}", ts.name);
+                VkDebugUtilsObjectNameInfoEXT debug_name{};
+                debug_name.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+                debug_name.pNext = nullptr;
+                debug_name.objectType = VK_OBJECT_TYPE_IMAGE;
+                debug_name.objectHandle = reinterpret_cast<uint64_t>(ts.full_image.image);
+                debug_name.pObjectName = object_name.c_str();
+                if (const auto res = vkSetDebugUtilsObjectNameEXT(device, &debug_name); res != VK_SUCCESS)
                 {
-                    vkDestroySampler(device, sampler, nullptr);
+                    l->error(std::format("Error creating streamed dds image debug object name {}", ts.name));
+                    return result::create_failed;
                 }
-                samplers.clear();
-                for (const VkImageView& image_view : image_views)
+            }
+            ts.state = texture_stream_state::streaming;
+            return result::ok;
+        }
+
+        result reserve_texture_staging_buffer(frame_data& fd, const size_t size) const
+        {
+            // The frame's fence has been waited on, so the previous upload out of this staging buffer has completed.
+            if (fd.frame_graphics_created_bitmask & graphics_created_bit_texture_staging_buffer)
+            {
+                if (fd.texture_staging_buffer.info.size >= size) return result::ok;
+                vmaDestroyBuffer(allocator, fd.texture_staging_buffer.buffer, fd.texture_staging_buffer.allocation);
+                fd.frame_graphics_created_bitmask &= ~graphics_created_bit_texture_staging_buffer;
+            }
+
+            VkBufferCreateInfo buffer_info{};
+            buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_info.pNext = nullptr;
+            buffer_info.size = std::max(size, cfg.texture_streaming_bytes_per_frame);
+            buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+            VmaAllocationCreateInfo vma_alloc_info{};
+            vma_alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+            vma_alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+
+            if (const VkResult res = vmaCreateBuffer(allocator, &buffer_info, &vma_alloc_info, &fd.texture_staging_buffer.buffer, &fd.texture_staging_buffer.allocation,
+                                                     &fd.texture_staging_buffer.info); res != VK_SUCCESS)
+            {
+                l->error(std::format("Error creating texture streaming staging buffer: {} {}", static_cast<uint8_t>(res), string_VkResult(res)));
+                return result::error;
+            }
+            fd.frame_graphics_created_bitmask |= graphics_created_bit_texture_staging_buffer;
+            {
+                VkDebugUtilsObjectNameInfoEXT debug_name{};
+                debug_name.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+                debug_name.pNext = nullptr;
+                debug_name.objectType = VK_OBJECT_TYPE_BUFFER;
+                debug_name.objectHandle = reinterpret_cast<uint64_t>(fd.texture_staging_buffer.buffer);
+                debug_name.pObjectName = "rosy texture streaming staging buffer";
+                if (const VkResult res = vkSetDebugUtilsObjectNameEXT(device, &debug_name); res != VK_SUCCESS)
+                {
+                    l->error(std::format("Error creating texture streaming staging buffer name: {}", static_cast<uint8_t>(res)));
+                    return result::error;
+                }
+            }
+            return result::ok;
+        }
+
+        void record_mip_barrier(const VkCommandBuffer cmd, const VkImage image, const uint32_t base_mip, const uint32_t num_mips, const VkImageLayout old_layout,
+                                const VkImageLayout new_layout) const
+        {
+            const VkImageSubresourceRange subresource_range{
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = base_mip,
+                .levelCount = num_mips,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            };
+
+            const VkImageMemoryBarrier2 image_barrier = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .pNext = nullptr,
+                .srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT,
+                .oldLayout = old_layout,
+                .newLayout = new_layout,
+                .srcQueueFamilyIndex = 0,
+                .dstQueueFamilyIndex = 0,
+                .image = image,
+                .subresourceRange = subresource_range,
+            };
+
+            const VkDependencyInfo dependency_info{
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = nullptr,
+                .dependencyFlags = 0,
+                .memoryBarrierCount = 0,
+                .pMemoryBarriers = nullptr,
+                .bufferMemoryBarrierCount = 0,
+                .pBufferMemoryBarriers = nullptr,
+                .imageMemoryBarrierCount = 1,
+                .pImageMemoryBarriers = &image_barrier,
+            };
+            vkCmdPipelineBarrier2(cmd, &dependency_info);
+        }
+
+        void record_material_buffer_barrier(const VkCommandBuffer cmd) const
+        {
+            const VkBufferMemoryBarrier2 buffer_barrier{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .pNext = nullptr,
+                .srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                .dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT,
+                .srcQueueFamilyIndex = 0,
+                .dstQueueFamilyIndex = 0,
+                .buffer = material_buffer.material_buffer.buffer,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE,
+            };
+            const VkDependencyInfo dependency_info{
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = nullptr,
+                .dependencyFlags = 0,
+                .memoryBarrierCount = 0,
+                .pMemoryBarriers = nullptr,
+                .bufferMemoryBarrierCount = 1,
+                .pBufferMemoryBarriers = &buffer_barrier,
+                .imageMemoryBarrierCount = 0,
+                .pImageMemoryBarriers = nullptr,
+            };
+            vkCmdPipelineBarrier2(cmd, &dependency_info);
+        }
+
+        result complete_texture_stream(const VkCommandBuffer cmd, texture_stream& ts)
+        {
+            // Every mip of the full image has been recorded for upload, swap it in behind a new descriptor. The mip tail's descriptor may still
+            // be in use by frames in flight so it is never rewritten, instead the materials are pointed at the new descriptor.
+            VkImageViewCreateInfo image_view_info{};
+            image_view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            image_view_info.pNext = nullptr;
+            image_view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            image_view_info.image = ts.full_image.image;
+            image_view_info.format = ts.format;
+            image_view_info.subresourceRange.baseMipLevel = 0;
+            image_view_info.subresourceRange.levelCount = ts.num_mips;
+            image_view_info.subresourceRange.baseArrayLayer = 0;
+            image_view_info.subresourceRange.layerCount = 1;
+            image_view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            VkImageView image_view{};
+            if (const VkResult res = vkCreateImageView(device, &image_view_info, nullptr, &image_view); res != VK_SUCCESS)
+            {
+                l->error(std::format("streamed dds image view creation failure: {} {} for {}", static_cast<uint8_t>(res), string_VkResult(res), ts.name));
+                return result::create_failed;
+            }
+            {
+                const auto obj_name = std::format("rosy streamed img view {}", ts.name);
+                VkDebugUtilsObjectNameInfoEXT debug_name{};
+                debug_name.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+                debug_name.pNext = nullptr;
+                debug_name.objectType = VK_OBJECT_TYPE_IMAGE_VIEW;
+                debug_name.objectHandle = reinterpret_cast<uint64_t>(image_view);
+                debug_name.pObjectName = obj_name.c_str();
+                if (const VkResult res = vkSetDebugUtilsObjectNameEXT(device, &debug_name); res != VK_SUCCESS)
                 {
+                    l->error(std::format("Error creating streamed dds image view name: {} {} for {}", static_cast<uint8_t>(res), string_VkResult(res), ts.name));
                     vkDestroyImageView(device, image_view, nullptr);
+                    return result::error;
                 }
-                image_views.clear();
-                for (auto& [gfx_created_bitmask, image, image_view, allocation, image_extent, image_format] : dds_textures)
+            }
+
+            uint32_t new_sampled_image_index{0};
+            if (const result res = desc_sampled_images->allocator.allocate(&new_sampled_image_index); res != result::ok)
+            {
+                l->error(std::format("Error allocating streamed texture descriptor index: {} for {}", static_cast<uint8_t>(res), ts.name));
+                vkDestroyImageView(device, image_view, nullptr);
+                return result::create_failed;
+            }
+            {
+                VkDescriptorImageInfo info{};
+                info.sampler = nullptr;
+                info.imageView = image_view;
+                info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+                VkWriteDescriptorSet write{};
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstBinding = desc_sampled_images->binding;
+                write.dstArrayElement = new_sampled_image_index;
+                write.dstSet = descriptor_set;
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                write.pImageInfo = &info;
+
+                vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+            }
+
+            if (material_buffer.has_material)
+            {
+                bool barrier_recorded{false};
+                for (size_t material_index{0}; material_index < gpu_materials.size(); material_index++)
                 {
-                    if (gfx_created_bitmask & graphics_created_bit_dds_image)
+                    gpu_material& m = gpu_materials[material_index];
+                    bool changed{false};
+                    for (uint32_t* sampled_image_index : {&m.color_sampled_image_index, &m.normal_sampled_image_index, &m.metallic_sampled_image_index, &m.mixmap_sampled_image_index})
                     {
-                        vmaDestroyImage(allocator, image, allocation);
+                        if (*sampled_image_index != ts.sampled_image_index) continue;
+                        *sampled_image_index = new_sampled_image_index;
+                        changed = true;
                     }
-                    if (gfx_created_bitmask & graphics_created_bit_dds_image_view)
+                    if (!changed) continue;
+                    if (!barrier_recorded)
                     {
-                        vkDestroyImageView(device, image_view, nullptr);
+                        record_material_buffer_barrier(cmd);
+                        barrier_recorded = true;
                     }
+                    vkCmdUpdateBuffer(cmd, material_buffer.material_buffer.buffer, sizeof(gpu_material) * material_index, sizeof(gpu_material), &m);
                 }
-                dds_textures.clear();
-
-                if (graphics_created_bitmask & graphics_created_bit_index_buffer)
-                {
-                    vmaDestroyBuffer(allocator, index_buffer.buffer, index_buffer.allocation);
-                    graphics_created_bitmask &= ~graphics_created_bit_index_buffer;
-                }
+                if (barrier_recorded) record_material_buffer_barrier(cmd);
+            }
 
-                if (graphics_created_bitmask & graphics_created_bit_vertex_buffer)
-                {
-                    vmaDestroyBuffer(allocator, vertex_buffer.buffer, vertex_buffer.allocation);
-                    graphics_created_bitmask &= ~graphics_created_bit_vertex_buffer;
-                }
+            texture_releases.push_back({
+                .image = dds_textures[ts.texture_index],
+                .sampled_view = image_views[ts.texture_index],
+                .sampled_image_index = ts.sampled_image_index,
+                .frames_remaining = max_frames_in_flight,
+            });
+            dds_textures[ts.texture_index] = ts.full_image;
+            image_views[ts.texture_index] = image_view;
+            ts.sampled_image_index = new_sampled_image_index;
+            ts.state = texture_stream_state::resident;
+            ts.dds_data = {};
+            l->debug(std::format("Texture {} is fully resident with {} mips", ts.name, ts.num_mips));
+            return result::ok;
+        }
 
-                if (graphics_created_bitmask & graphics_created_bit_materials_buffer)
-                {
-                    vmaDestroyBuffer(allocator, material_buffer.material_buffer.buffer, material_buffer.material_buffer.allocation);
-                    graphics_created_bitmask &= ~graphics_created_bit_materials_buffer;
-                }
+        void stream_textures(const VkCommandBuffer cmd, frame_data& fd)
+        {
+            release_streamed_textures();
 
-                if (graphics_created_bitmask & graphics_created_bit_pipeline_layout)
+            // A texture already streaming is finished first, otherwise the pending texture closest to the camera is started.
+            texture_stream* ts{nullptr};
+            for (texture_stream& candidate : texture_streams)
+            {
+                if (candidate.state == texture_stream_state::streaming)
                 {
-                    vkDestroyPipelineLayout(device, scene_layout, nullptr);
-                    graphics_created_bitmask &= ~graphics_created_bit_pipeline_layout;
+                    ts = &candidate;
+                    break;
                 }
+                if (candidate.state != texture_stream_state::pending) continue;
+                candidate.camera_distance = texture_stream_camera_distance(candidate);
+                if (ts == nullptr || candidate.camera_distance < ts->camera_distance) ts = &candidate;
+            }
+            if (ts == nullptr) return;
 
-                if (graphics_created_bitmask & graphics_created_bit_shaders)
+            if (ts->state == texture_stream_state::pending)
+            {
+                if (!texture_stream_fits_budget(ts->full_chain_size))
                 {
-                    for (const VkShaderEXT shader : scene_shaders)
+                    if (!texture_streaming_over_budget)
                     {
-                        vkDestroyShaderEXT(device, shader, nullptr);
+                        l->warn(std::format("Texture streaming paused at {}, it would exceed the VRAM budget", ts->name));
+                        texture_streaming_over_budget = true;
                     }
-                    graphics_created_bitmask &= ~graphics_created_bit_shaders;
+                    return;
                 }
-                gpu_meshes.clear();
+                texture_streaming_over_budget = false;
+            }
+            // Streaming only sharpens textures, a texture that fails to stream is drawn with its mip tail and the frame goes on.
+            if (const auto res = stream_texture(cmd, fd, *ts); res != result::ok)
+            {
+                l->error(std::format("Error streaming texture {}, it keeps its mip tail: {}", ts->name, static_cast<uint8_t>(res)));
+                abandon_texture_stream(*ts);
             }
+        }
 
-            // *** SETTING IMAGES *** //
+        result stream_texture(const VkCommandBuffer cmd, frame_data& fd, texture_stream& ts)
+        {
+            if (ts.state == texture_stream_state::pending)
+            {
+                if (const auto res = begin_texture_stream(ts); res != result::ok) return res;
+            }
 
-            std::vector<uint32_t> color_image_sampler_desc_index;
-            for (const auto& img : a.images)
+            // Copy the next mips, smallest first, up to the per frame byte budget but always at least one mip.
+            const int32_t last_mip = ts.next_mip;
+            int32_t first_mip = last_mip;
+            size_t upload_size{0};
+            while (first_mip >= 0)
             {
-                allocated_image new_dds_img{};
+                const size_t mip_size = ts.dds_data.mipmaps[static_cast<size_t>(first_mip)].size();
+                if (upload_size > 0 && upload_size + mip_size > cfg.texture_streaming_bytes_per_frame) break;
+                upload_size += mip_size;
+                first_mip -= 1;
+            }
+            first_mip += 1;
 
-                std::string input_filename{img.name.begin(), img.name.end()};
-                std::filesystem::path dds_img_path{input_filename};
+            if (const auto res = reserve_texture_staging_buffer(fd, upload_size); res != result::ok) return res;
 
-                uint32_t num_mip_maps{0};
-                dds::Image dds_lib_image;
-                if (const auto res = dds::readFile(input_filename, &dds_lib_image); res != dds::Success)
+            std::vector<VkBufferImageCopy> regions;
+            regions.reserve(static_cast<size_t>(last_mip - first_mip + 1));
+            {
+                size_t buffer_offset{0};
+                for (int32_t mip{first_mip}; mip <= last_mip; mip++)
                 {
-                    l->warn(std::format("Failed to read dds lib data for {}, is it unused?", input_filename));
-                    continue;
+                    const auto& m = ts.dds_data.mipmaps[static_cast<size_t>(mip)];
+                    memcpy(static_cast<char*>(fd.texture_staging_buffer.info.pMappedData) + buffer_offset, static_cast<void*>(m.data()), m.size());
+
+                    VkBufferImageCopy copy_region{};
+                    copy_region.bufferOffset = buffer_offset;
+                    copy_region.bufferRowLength = 0;
+                    copy_region.bufferImageHeight = 0;
+                    copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                    copy_region.imageSubresource.mipLevel = static_cast<uint32_t>(mip);
+                    copy_region.imageSubresource.baseArrayLayer = 0;
+                    copy_region.imageSubresource.layerCount = 1;
+                    copy_region.imageExtent = mip_extent(ts.full_image.image_extent, static_cast<uint32_t>(mip));
+                    regions.push_back(copy_region);
+                    buffer_offset += m.size();
                 }
+            }
 
-                VkImageCreateInfo dds_img_create_info = dds::getVulkanImageCreateInfo(&dds_lib_image);
-                VkImageViewCreateInfo dds_img_view_create_info = dds::getVulkanImageViewCreateInfo(&dds_lib_image);
+            const auto base_mip = static_cast<uint32_t>(first_mip);
+            const auto num_mips = static_cast<uint32_t>(regions.size());
+            record_mip_barrier(cmd, ts.full_image.image, base_mip, num_mips, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkCmdCopyBufferToImage(cmd, fd.texture_staging_buffer.buffer, ts.full_image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_mips, regions.data());
+            record_mip_barrier(cmd, ts.full_image.image, base_mip, num_mips, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            ts.next_mip = first_mip - 1;
 
-                VkExtent3D dds_image_size = dds_img_create_info.extent;
-                num_mip_maps = dds_img_create_info.mipLevels;
+            if (ts.next_mip < 0) return complete_texture_stream(cmd, ts);
+            return result::ok;
+        }
 
-                size_t dds_image_data_size{0};
-                for (const auto& m : dds_lib_image.mipmaps)
+        void destroy_mesh_streams()
+        {
+            // The device must be idle, nothing here waits for frames in flight.
+            if (vertex_pool != nullptr)
+            {
+                vmaClearVirtualBlock(vertex_pool);
+                vmaDestroyVirtualBlock(vertex_pool);
+                vertex_pool = nullptr;
+            }
+            if (index_pool != nullptr)
+            {
+                vmaClearVirtualBlock(index_pool);
+                vmaDestroyVirtualBlock(index_pool);
+                index_pool = nullptr;
+            }
+            mesh_streams.clear();
+            mesh_stream_asset = nullptr;
+            mesh_cells.clear();
+            mesh_cell_order.clear();
+            mesh_releases.clear();
+            mesh_streaming = false;
+            mesh_streaming_over_budget = false;
+            largest_mesh_stream_size = 0;
+        }
+
+        void evict_mesh(const size_t mesh_index)
+        {
+            mesh_stream& ms = mesh_streams[mesh_index];
+            if (ms.vertex_allocation == nullptr) return;
+            gpu_meshes[mesh_index].resident = false;
+            mesh_releases.push_back({
+                .vertex_allocation = ms.vertex_allocation,
+                .index_allocation = ms.index_allocation,
+                .frames_remaining = max_frames_in_flight,
+            });
+            ms.vertex_allocation = nullptr;
+            ms.index_allocation = nullptr;
+        }
+
+        void release_streamed_meshes()
+        {
+            // Called once per frame after waiting on the current frame's fence, like release_streamed_textures.
+            for (size_t i{0}; i < mesh_releases.size();)
+            {
+                if (mesh_releases[i].frames_remaining > 0)
                 {
-                    dds_image_data_size += m.size();
+                    mesh_releases[i].frames_remaining -= 1;
+                    i += 1;
+                    continue;
                 }
-                std::string dds_image_name = dds_img_path.filename().string();
+                vmaVirtualFree(vertex_pool, mesh_releases[i].vertex_allocation);
+                vmaVirtualFree(index_pool, mesh_releases[i].index_allocation);
+                mesh_releases[i] = mesh_releases.back();
+                mesh_releases.pop_back();
+            }
+        }
+
+        [[nodiscard]] float mesh_cell_camera_distance(const mesh_cell& cell) const
+        {
+            if (cell.pinned) return 0.f;
+            const float dx = std::max({cell.bounds_min[0] - scene_data.camera_position[0], 0.f, scene_data.camera_position[0] - cell.bounds_max[0]});
+            const float dz = std::max({cell.bounds_min[1] - scene_data.camera_position[2], 0.f, scene_data.camera_position[2] - cell.bounds_max[1]});
+            return std::sqrt(dx * dx + dz * dz);
+        }
+
+        // The xz bounds of the mesh's object space bounds under the transform.
+        [[nodiscard]] static std::pair<std::array<float, 2>, std::array<float, 2>> world_xz_bounds(const std::array<float, 16>& transform, const mesh_stream& ms)
+        {
+            std::array<float, 2> world_min{};
+            std::array<float, 2> world_max{};
+            for (size_t axis{0}; axis < 2; axis++)
+            {
+                const size_t row = axis * 2; // x or z
+                float center = transform[12 + row];
+                float extent{0.f};
+                for (size_t column{0}; column < 3; column++)
                 {
-                    new_dds_img.image_extent = dds_image_size;
+                    const float m = transform[column * 4 + row];
+                    center += m * (ms.bounds_min[column] + ms.bounds_max[column]) * 0.5f;
+                    extent += std::abs(m) * (ms.bounds_max[column] - ms.bounds_min[column]) * 0.5f;
+                }
+                world_min[axis] = center - extent;
+                world_max[axis] = center + extent;
+            }
+            return {world_min, world_max};
+        }
 
-                    new_dds_img.image_format = dds::getVulkanFormat(dds_lib_image.format, dds_lib_image.supportsAlpha);
-                    if (img.image_type == rosy_asset::image_type_color)
+        result build_mesh_cells(const std::vector<graphics_object>& graphics_objects, const size_t dynamic_objects_offset)
+        {
+            mesh_cells.clear();
+            mesh_cell_order.clear();
+            if (!mesh_streaming) return result::ok;
+            for (size_t mesh_index{0}; mesh_index < mesh_streams.size(); mesh_index++)
+            {
+                mesh_streams[mesh_index].wanted_cells = 0;
+                evict_mesh(mesh_index);
+            }
+
+            mesh_cells.push_back({.pinned = true});
+            {
+                std::unordered_map<uint64_t, size_t> cell_lookup;
+                const float cell_size = cfg.mesh_streaming_cell_size;
+                for (size_t go_index{0}; go_index < graphics_objects.size(); go_index++)
+                {
+                    const graphics_object& go = graphics_objects[go_index];
+                    size_t cell_index{0};
+                    if (go_index < dynamic_objects_offset)
                     {
-                        new_dds_img.image_format = VK_FORMAT_BC7_SRGB_BLOCK;
+                        // An object goes in the cell under the center of its meshes' world xz bounds, and the cell grows to cover those
+                        // bounds, so an object whose origin is away from its geometry still streams in when its geometry comes near.
+                        std::array<float, 2> object_min{go.transform[12], go.transform[14]};
+                        std::array<float, 2> object_max{go.transform[12], go.transform[14]};
+                        bool has_bounds{false};
+                        for (const surface_graphics_data& sd : go.surface_data)
+                        {
+                            if (sd.mesh_index >= mesh_streams.size() || mesh_streams[sd.mesh_index].positions.empty()) continue;
+                            const auto [mesh_min, mesh_max] = world_xz_bounds(go.transform, mesh_streams[sd.mesh_index]);
+                            for (size_t axis{0}; axis < 2; axis++)
+                            {
+                                object_min[axis] = has_bounds ? std::min(object_min[axis], mesh_min[axis]) : mesh_min[axis];
+                                object_max[axis] = has_bounds ? std::max(object_max[axis], mesh_max[axis]) : mesh_max[axis];
+                            }
+                            has_bounds = true;
+                        }
+                        const auto cell_x = static_cast<int32_t>(std::floor((object_min[0] + object_max[0]) * 0.5f / cell_size));
+                        const auto cell_z = static_cast<int32_t>(std::floor((object_min[1] + object_max[1]) * 0.5f / cell_size));
+                        const uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(cell_x)) << 32 | static_cast<uint32_t>(cell_z);
+                        if (const auto it = cell_lookup.find(key); it != cell_lookup.end())
+                        {
+                            cell_index = it->second;
+                        }
+                        else
+                        {
+                            cell_index = mesh_cells.size();
+                            cell_lookup.emplace(key, cell_index);
+                            mesh_cells.push_back({
+                                .bounds_min = {static_cast<float>(cell_x) * cell_size, static_cast<float>(cell_z) * cell_size},
+                                .bounds_max = {static_cast<float>(cell_x + 1) * cell_size, static_cast<float>(cell_z + 1) * cell_size},
+                            });
+                        }
+                        mesh_cell& cell = mesh_cells[cell_index];
+                        for (size_t axis{0}; axis < 2; axis++)
+                        {
+                            cell.bounds_min[axis] = std::min(cell.bounds_min[axis], object_min[axis]);
+                            cell.bounds_max[axis] = std::max(cell.bounds_max[axis], object_max[axis]);
+                        }
                     }
-                    else if (img.image_type == rosy_asset::image_type_normal_map)
+                    for (const surface_graphics_data& sd : go.surface_data)
+                    {
+                        if (sd.mesh_index >= mesh_streams.size())
+                        {
+                            l->error(std::format("Graphics object {} draws mesh {} of {}", go_index, sd.mesh_index, mesh_streams.size()));
+                            return result::invalid_argument;
+                        }
+                        if (std::vector<size_t>& meshes = mesh_cells[cell_index].mesh_indices; std::ranges::find(meshes, sd.mesh_index) == meshes.end())
+                        {
+                            meshes.push_back(sd.mesh_index);
+                        }
+                    }
+                }
+            }
+
+            mesh_cell_order.reserve(mesh_cells.size());
+            for (size_t cell_index{0}; cell_index < mesh_cells.size(); cell_index++) mesh_cell_order.push_back(cell_index);
+            mesh_cells[0].wanted = true;
+            for (const size_t mesh_index : mesh_cells[0].mesh_indices) mesh_streams[mesh_index].wanted_cells += 1;
+            l->info(std::format("Streaming {} meshes across {} cells", mesh_streams.size(), mesh_cells.size() - 1));
+            return result::ok;
+        }
+
+        result reserve_mesh_staging_buffer(frame_data& fd, const size_t size) const
+        {
+            // The frame's fence has been waited on, so the previous upload out of this staging buffer has completed.
+            if (fd.frame_graphics_created_bitmask & graphics_created_bit_mesh_staging_buffer)
+            {
+                if (fd.mesh_staging_buffer.info.size >= size) return result::ok;
+                vmaDestroyBuffer(allocator, fd.mesh_staging_buffer.buffer, fd.mesh_staging_buffer.allocation);
+                fd.frame_graphics_created_bitmask &= ~graphics_created_bit_mesh_staging_buffer;
+            }
+
+            VkBufferCreateInfo buffer_info{};
+            buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_info.pNext = nullptr;
+            buffer_info.size = size;
+            buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+            VmaAllocationCreateInfo vma_alloc_info{};
+            vma_alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
+            vma_alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+
+            if (const VkResult res = vmaCreateBuffer(allocator, &buffer_info, &vma_alloc_info, &fd.mesh_staging_buffer.buffer, &fd.mesh_staging_buffer.allocation,
+                                                     &fd.mesh_staging_buffer.info); res != VK_SUCCESS)
+            {
+                l->error(std::format("Error creating mesh streaming staging buffer: {} {}", static_cast<uint8_t>(res), string_VkResult(res)));
+                return result::error;
+            }
+            fd.frame_graphics_created_bitmask |= graphics_created_bit_mesh_staging_buffer;
+            {
+                VkDebugUtilsObjectNameInfoEXT debug_name{};
+                debug_name.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+                debug_name.pNext = nullptr;
+                debug_name.objectType = VK_OBJECT_TYPE_BUFFER;
+                debug_name.objectHandle = reinterpret_cast<uint64_t>(fd.mesh_staging_buffer.buffer);
+                debug_name.pObjectName = "rosy mesh streaming staging buffer";
+                if (const VkResult res = vkSetDebugUtilsObjectNameEXT(device, &debug_name); res != VK_SUCCESS)
+                {
+                    l->error(std::format("Error creating mesh streaming staging buffer name: {}", static_cast<uint8_t>(res)));
+                    return result::error;
+                }
+            }
+            return result::ok;
+        }
+
+        void record_mesh_pool_barrier(const VkCommandBuffer cmd) const
+        {
+            const std::array<VkBufferMemoryBarrier2, 2> buffer_barriers{
+                {
+                    {
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                        .pNext = nullptr,
+                        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                        .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                        .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
+                        .srcQueueFamilyIndex = 0,
+                        .dstQueueFamilyIndex = 0,
+                        .buffer = vertex_buffer.buffer,
+                        .offset = 0,
+                        .size = VK_WHOLE_SIZE,
+                    },
+                    {
+                        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                        .pNext = nullptr,
+                        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                        .dstStageMask = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+                        .dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT,
+                        .srcQueueFamilyIndex = 0,
+                        .dstQueueFamilyIndex = 0,
+                        .buffer = index_buffer.buffer,
+                        .offset = 0,
+                        .size = VK_WHOLE_SIZE,
+                    },
+                }
+            };
+            const VkDependencyInfo dependency_info{
+                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .pNext = nullptr,
+                .dependencyFlags = 0,
+                .memoryBarrierCount = 0,
+                .pMemoryBarriers = nullptr,
+                .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers.size()),
+                .pBufferMemoryBarriers = buffer_barriers.data(),
+                .imageMemoryBarrierCount = 0,
+                .pImageMemoryBarriers = nullptr,
+            };
+            vkCmdPipelineBarrier2(cmd, &dependency_info);
+        }
+
+        // Whether rendering another frame would upload or release streamed textures or meshes, streaming only advances while frames are rendered.
+        // Streaming paused over its budget waits for the camera to move.
+        [[nodiscard]] bool streaming_pending() const
+        {
+            if (!texture_releases.empty() || !mesh_releases.empty()) return true;
+            if (!texture_streaming_over_budget)
+            {
+                for (const texture_stream& ts : texture_streams)
+                {
+                    if (ts.state == texture_stream_state::pending || ts.state == texture_stream_state::streaming) return true;
+                }
+            }
+            if (mesh_streaming && !mesh_streaming_over_budget)
+            {
+                for (const mesh_cell& cell : mesh_cells)
+                {
+                    if (!cell.wanted) continue;
+                    for (const size_t mesh_index : cell.mesh_indices)
+                    {
+                        if (!gpu_meshes[mesh_index].resident) return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        result stream_meshes(const VkCommandBuffer cmd, frame_data& fd)
+        {
+            if (!mesh_streaming) return result::ok;
+            release_streamed_meshes();
+
+            {
+                // Cells are wanted inside the load distance and let go past the unload distance, in between they keep their state so a
+                // camera sitting on a cell's edge doesn't load and evict it every other frame. A mesh is evicted as soon as no wanted cell uses it.
+                for (mesh_cell& cell : mesh_cells)
+                {
+                    cell.camera_distance = mesh_cell_camera_distance(cell);
+                    if (!cell.wanted && cell.camera_distance <= cfg.mesh_streaming_load_distance)
+                    {
+                        cell.wanted = true;
+                        for (const size_t mesh_index : cell.mesh_indices) mesh_streams[mesh_index].wanted_cells += 1;
+                    }
+                    else if (cell.wanted && !cell.pinned && cell.camera_distance > cfg.mesh_streaming_unload_distance)
+                    {
+                        cell.wanted = false;
+                        for (const size_t mesh_index : cell.mesh_indices)
+                        {
+                            mesh_streams[mesh_index].wanted_cells -= 1;
+                            if (mesh_streams[mesh_index].wanted_cells == 0) evict_mesh(mesh_index);
+                        }
+                    }
+                }
+                std::ranges::sort(mesh_cell_order, [this](const size_t a, const size_t b)
+                {
+                    return mesh_cells[a].camera_distance < mesh_cells[b].camera_distance;
+                });
+            }
+
+            if (const auto res = reserve_mesh_staging_buffer(fd, std::max(cfg.mesh_streaming_bytes_per_frame, largest_mesh_stream_size)); res != result::ok) return res;
+
+            // Copy the missing meshes of the nearest wanted cells up to the per frame byte budget, but always at least one mesh.
+            mesh_vertex_copies.clear();
+            mesh_index_copies.clear();
+            size_t upload_size{0};
+            bool upload_full{false};
+            for (const size_t cell_index : mesh_cell_order)
+            {
+                const mesh_cell& cell = mesh_cells[cell_index];
+                if (!cell.wanted) continue;
+                for (const size_t mesh_index : cell.mesh_indices)
+                {
+                    if (gpu_meshes[mesh_index].resident) continue;
+                    mesh_stream& ms = mesh_streams[mesh_index];
+                    const size_t vertex_size = ms.positions.size() * sizeof(rosy_asset::position);
+                    const size_t index_size = ms.indices.size() * sizeof(uint32_t);
+                    if (upload_size > 0 && upload_size + vertex_size + index_size > cfg.mesh_streaming_bytes_per_frame)
+                    {
+                        upload_full = true;
+                        break;
+                    }
+
+                    VkDeviceSize vertex_offset{0};
+                    VkDeviceSize index_offset{0};
+                    {
+                        VmaVirtualAllocationCreateInfo vertex_alloc_info{};
+                        vertex_alloc_info.size = vertex_size;
+                        vertex_alloc_info.alignment = 16;
+                        VmaVirtualAllocationCreateInfo index_alloc_info{};
+                        index_alloc_info.size = index_size;
+                        index_alloc_info.alignment = sizeof(uint32_t);
+                        if (vmaVirtualAllocate(vertex_pool, &vertex_alloc_info, &ms.vertex_allocation, &vertex_offset) != VK_SUCCESS)
+                        {
+                            ms.vertex_allocation = nullptr;
+                        }
+                        else if (vmaVirtualAllocate(index_pool, &index_alloc_info, &ms.index_allocation, &index_offset) != VK_SUCCESS)
+                        {
+                            vmaVirtualFree(vertex_pool, ms.vertex_allocation);
+                            ms.vertex_allocation = nullptr;
+                            ms.index_allocation = nullptr;
+                        }
+                    }
+                    if (ms.vertex_allocation == nullptr)
+                    {
+                        // The wanted cells hold more geometry than the pools, the farther cells wait until nearer ones are evicted.
+                        if (!mesh_streaming_over_budget && mesh_releases.empty())
+                        {
+                            l->warn(std::format("Mesh streaming paused at mesh {}, the wanted cells do not fit the vertex and index pools", mesh_index));
+                            mesh_streaming_over_budget = true;
+                        }
+                        upload_full = true;
+                        break;
+                    }
+                    mesh_streaming_over_budget = false;
+
+                    auto* staging = static_cast<char*>(fd.mesh_staging_buffer.info.pMappedData);
+                    memcpy(staging + upload_size, ms.positions.data(), vertex_size);
+                    mesh_vertex_copies.push_back({.srcOffset = upload_size, .dstOffset = vertex_offset, .size = vertex_size});
+                    upload_size += vertex_size;
+                    memcpy(staging + upload_size, ms.indices.data(), index_size);
+                    mesh_index_copies.push_back({.srcOffset = upload_size, .dstOffset = index_offset, .size = index_size});
+                    upload_size += index_size;
+
+                    gpu_meshes[mesh_index] = {
+                        .vertex_buffer_offset = vertex_offset,
+                        .index_offset = static_cast<uint32_t>(index_offset / sizeof(uint32_t)),
+                        .num_indices = static_cast<uint32_t>(ms.indices.size()),
+                        .resident = true,
+                    };
+                }
+                if (upload_full) break;
+            }
+            if (mesh_vertex_copies.empty()) return result::ok;
+
+            // Pool ranges are only reused after every frame that drew from them has completed, so only the copies need ordering before the draws.
+            vkCmdCopyBuffer(cmd, fd.mesh_staging_buffer.buffer, vertex_buffer.buffer, static_cast<uint32_t>(mesh_vertex_copies.size()), mesh_vertex_copies.data());
+            vkCmdCopyBuffer(cmd, fd.mesh_staging_buffer.buffer, index_buffer.buffer, static_cast<uint32_t>(mesh_index_copies.size()), mesh_index_copies.data());
+            record_mesh_pool_barrier(cmd);
+            if (l->level == rosy_logger::log_level::debug)
+            {
+                l->debug(std::format("Streamed {} meshes, {} bytes", mesh_vertex_copies.size(), upload_size));
+            }
+            return result::ok;
+        }
+
+        result set_asset(const std::shared_ptr<const rosy_asset::asset>& new_asset)
+        {
+            const rosy_asset::asset& a = *new_asset;
+            {
+                // Clear any existing asset resources
+
+                if (graphics_created_bitmask & graphics_created_bit_device)
+                {
+                    if (const VkResult res = vkDeviceWaitIdle(device); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Failed to wait device to be idle to reset asset: {}",
+                                             static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
+                }
+                material_buffer.has_material = false;
+                for (const VkSampler& sampler : samplers)
+                {
+                    vkDestroySampler(device, sampler, nullptr);
+                }
+                samplers.clear();
+                destroy_texture_streams();
+                destroy_mesh_streams();
+                for (const VkImageView& image_view : image_views)
+                {
+                    vkDestroyImageView(device, image_view, nullptr);
+                }
+                image_views.clear();
+                for (auto& [gfx_created_bitmask, image, image_view, allocation, image_extent, image_format] : dds_textures)
+                {
+                    if (gfx_created_bitmask & graphics_created_bit_dds_image)
+                    {
+                        vmaDestroyImage(allocator, image, allocation);
+                    }
+                    if (gfx_created_bitmask & graphics_created_bit_dds_image_view)
+                    {
+                        vkDestroyImageView(device, image_view, nullptr);
+                    }
+                }
+                dds_textures.clear();
+
+                if (graphics_created_bitmask & graphics_created_bit_index_buffer)
+                {
+                    vmaDestroyBuffer(allocator, index_buffer.buffer, index_buffer.allocation);
+                    graphics_created_bitmask &= ~graphics_created_bit_index_buffer;
+                }
+
+                if (graphics_created_bitmask & graphics_created_bit_vertex_buffer)
+                {
+                    vmaDestroyBuffer(allocator, vertex_buffer.buffer, vertex_buffer.allocation);
+                    graphics_created_bitmask &= ~graphics_created_bit_vertex_buffer;
+                }
+
+                if (graphics_created_bitmask & graphics_created_bit_materials_buffer)
+                {
+                    vmaDestroyBuffer(allocator, material_buffer.material_buffer.buffer, material_buffer.material_buffer.allocation);
+                    graphics_created_bitmask &= ~graphics_created_bit_materials_buffer;
+                }
+
+                if (graphics_created_bitmask & graphics_created_bit_pipeline_layout)
+                {
+                    vkDestroyPipelineLayout(device, scene_layout, nullptr);
+                    graphics_created_bitmask &= ~graphics_created_bit_pipeline_layout;
+                }
+
+                if (graphics_created_bitmask & graphics_created_bit_shaders)
+                {
+                    for (const VkShaderEXT shader : scene_shaders)
+                    {
+                        vkDestroyShaderEXT(device, shader, nullptr);
+                    }
+                    graphics_created_bitmask &= ~graphics_created_bit_shaders;
+                }
+                gpu_meshes.clear();
+            }
+
+            // *** SETTING IMAGES *** //
+
+            std::vector<uint32_t> color_image_sampler_desc_index;
+            texture_streams.reserve(a.images.size());
+            for (const auto& img : a.images)
+            {
+                allocated_image new_dds_img{};
+
+                std::string input_filename{img.name.begin(), img.name.end()};
+                std::filesystem::path dds_img_path{input_filename};
+
+                uint32_t num_mip_maps{0};
+                dds::Image dds_lib_image;
+                if (const auto res = dds::readFile(input_filename, &dds_lib_image); res != dds::Success)
+                {
+                    l->warn(std::format("Failed to read dds lib data for {}, is it unused?", input_filename));
+                    continue;
+                }
+
+                VkImageCreateInfo dds_img_create_info = dds::getVulkanImageCreateInfo(&dds_lib_image);
+                VkImageViewCreateInfo dds_img_view_create_info = dds::getVulkanImageViewCreateInfo(&dds_lib_image);
+
+                num_mip_maps = std::min(dds_img_create_info.mipLevels, static_cast<uint32_t>(dds_lib_image.mipmaps.size()));
+
+                // Only the mip tail is uploaded now, the image created here holds just those mips and larger mips are streamed into a full size image later.
+                const uint32_t tail_mip = texture_stream_tail_mip(dds_img_create_info.extent, num_mip_maps, cfg.texture_streaming_tail_size);
+                const uint32_t num_tail_mips = num_mip_maps - tail_mip;
+                const VkExtent3D dds_image_size = mip_extent(dds_img_create_info.extent, tail_mip);
+                dds_img_create_info.extent = dds_image_size;
+                dds_img_create_info.mipLevels = num_tail_mips;
+                dds_img_view_create_info.subresourceRange.levelCount = num_tail_mips;
+
+                size_t dds_image_data_size{0};
+                for (uint32_t mip{tail_mip}; mip < num_mip_maps; mip++)
+                {
+                    dds_image_data_size += dds_lib_image.mipmaps[mip].size();
+                }
+                std::string dds_image_name = dds_img_path.filename().string();
+                {
+                    new_dds_img.image_extent = dds_image_size;
+
+                    new_dds_img.image_format = dds::getVulkanFormat(dds_lib_image.format, dds_lib_image.supportsAlpha);
+                    if (img.image_type == rosy_asset::image_type_color)
+                    {
+                        new_dds_img.image_format = VK_FORMAT_BC7_SRGB_BLOCK;
+                    }
+                    else if (img.image_type == rosy_asset::image_type_normal_map)
                     {
                         new_dds_img.image_format = VK_FORMAT_BC7_UNORM_BLOCK;
                     }
@@ -3744,8 +4730,9 @@ namespace
                     if (dds_staging_buffer.info.pMappedData != nullptr)
                     {
                         size_t offset{0};
-                        for (const auto& m : dds_lib_image.mipmaps)
+                        for (uint32_t mip{tail_mip}; mip < num_mip_maps; mip++)
                         {
+                            const auto& m = dds_lib_image.mipmaps[mip];
                             if (offset + m.size() > dds_staging_buffer.info.size)
                             {
                                 l->error(std::format("Error mip mapping buffer overflow. buffer size {}  copy size: {} for {}", dds_staging_buffer.info.size, offset + m.size(), dds_image_name));
@@ -3787,7 +4774,7 @@ namespace
                                 const VkImageSubresourceRange subresource_range{
                                     .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                                     .baseMipLevel = 0,
-                                    .levelCount = dds_lib_image.numMips,
+                                    .levelCount = num_tail_mips,
                                     .baseArrayLayer = 0,
                                     .layerCount = 1,
                                 };
@@ -3824,22 +4811,19 @@ namespace
                         {
                             std::vector<VkBufferImageCopy> regions;
                             size_t buffer_offset{0};
-                            VkExtent3D current_extent = new_dds_img.image_extent;
-                            for (size_t mip{0}; mip < dds_lib_image.numMips; mip++)
+                            for (uint32_t mip{tail_mip}; mip < num_mip_maps; mip++)
                             {
                                 VkBufferImageCopy copy_region{};
                                 copy_region.bufferOffset = static_cast<uint32_t>(buffer_offset);
                                 copy_region.bufferRowLength = 0;
                                 copy_region.bufferImageHeight = 0;
                                 copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                                copy_region.imageSubresource.mipLevel = static_cast<uint32_t>(mip);
+                                copy_region.imageSubresource.mipLevel = mip - tail_mip;
                                 copy_region.imageSubresource.baseArrayLayer = 0;
                                 copy_region.imageSubresource.layerCount = 1;
-                                copy_region.imageExtent = current_extent;
+                                copy_region.imageExtent = mip_extent(new_dds_img.image_extent, mip - tail_mip);
                                 regions.push_back(copy_region);
                                 buffer_offset += dds_lib_image.mipmaps[mip].size();
-                                current_extent.height /= 2;
-                                current_extent.width /= 2;
                             }
 
                             vkCmdCopyBufferToImage(immediate_command_buffer, dds_staging_buffer.buffer, new_dds_img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()),
@@ -3851,7 +4835,7 @@ namespace
                             const VkImageSubresourceRange subresource_range{
                                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                                 .baseMipLevel = 0,
-                                .levelCount = dds_lib_image.numMips,
+                                .levelCount = num_tail_mips,
                                 .baseArrayLayer = 0,
                                 .layerCount = 1,
                             };
@@ -3933,7 +4917,7 @@ namespace
                     image_view_info.image = new_dds_img.image;
                     image_view_info.format = new_dds_img.image_format;
                     image_view_info.subresourceRange.baseMipLevel = 0;
-                    image_view_info.subresourceRange.levelCount = num_mip_maps;
+                    image_view_info.subresourceRange.levelCount = num_tail_mips;
                     image_view_info.subresourceRange.baseArrayLayer = 0;
                     image_view_info.subresourceRange.layerCount = 1;
                     image_view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -3990,6 +4974,19 @@ namespace
                     assert(image_views.size() == color_image_sampler_desc_index.size());
                 }
 
+                if (tail_mip > 0)
+                {
+                    texture_stream ts{};
+                    ts.texture_index = dds_textures.size();
+                    ts.sampled_image_index = color_image_sampler_desc_index.back();
+                    ts.name = dds_image_name;
+                    ts.format = new_dds_img.image_format;
+                    ts.num_mips = num_mip_maps;
+                    ts.next_mip = static_cast<int32_t>(num_mip_maps) - 1;
+                    for (uint32_t mip{0}; mip < num_mip_maps; mip++) ts.full_chain_size += dds_lib_image.mipmaps[mip].size();
+                    ts.dds_data = std::move(dds_lib_image);
+                    texture_streams.push_back(std::move(ts));
+                }
                 dds_textures.push_back(new_dds_img);
             }
 
@@ -4152,6 +5149,25 @@ namespace
                     materials.push_back(new_mat);
                 }
 
+                {
+                    // Map materials to the streamed textures they sample so streaming can be prioritized by the objects using them.
+                    material_texture_streams.clear();
+                    material_texture_streams.resize(a.materials.size());
+                    for (size_t material_index{0}; material_index < a.materials.size(); material_index++)
+                    {
+                        const rosy_asset::material& m = a.materials[material_index];
+                        for (const uint32_t image_index : {m.color_image_index, m.normal_image_index, m.metallic_image_index, m.mixmap_image_index})
+                        {
+                            for (size_t stream_index{0}; stream_index < texture_streams.size(); stream_index++)
+                            {
+                                if (texture_streams[stream_index].texture_index != image_index) continue;
+                                material_texture_streams[material_index].push_back(stream_index);
+                            }
+                        }
+                    }
+                    gpu_materials = materials;
+                }
+
                 if (const size_t material_buffer_size = materials.size() * sizeof(gpu_material); material_buffer_size >= sizeof(gpu_material))
                 {
                     {
@@ -4334,16 +5350,23 @@ namespace
                     gpu_meshes.push_back(gpu_mesh);
                 }
 
+                // Geometry that fits the pools is uploaded whole, larger levels get pool sized buffers that meshes are streamed into.
+                mesh_streaming = cfg.mesh_streaming_cell_size > 0.f &&
+                    (total_vertex_buffer_size > cfg.mesh_streaming_vertex_pool_size || total_index_buffer_size > cfg.mesh_streaming_index_pool_size);
+                const size_t vertex_pool_size = mesh_streaming ? cfg.mesh_streaming_vertex_pool_size : total_vertex_buffer_size;
+                const size_t index_pool_size = mesh_streaming ? cfg.mesh_streaming_index_pool_size : total_index_buffer_size;
+
                 {
                     VkBufferCreateInfo buffer_info{};
                     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
                     buffer_info.pNext = nullptr;
-                    buffer_info.size = total_vertex_buffer_size;
+                    buffer_info.size = vertex_pool_size;
                     buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 
                     VmaAllocationCreateInfo vma_alloc_info{};
                     vma_alloc_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-                    vma_alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                    // Pools are only written by copies, keeping them out of host visible memory leaves the whole device heap to choose from.
+                    vma_alloc_info.flags = mesh_streaming ? 0 : VMA_ALLOCATION_CREATE_MAPPED_BIT |
                         VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
 
                     if (
@@ -4385,12 +5408,12 @@ namespace
                     VkBufferCreateInfo buffer_info{};
                     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
                     buffer_info.pNext = nullptr;
-                    buffer_info.size = total_index_buffer_size;
+                    buffer_info.size = index_pool_size;
                     buffer_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 
                     VmaAllocationCreateInfo vma_alloc_info{};
                     vma_alloc_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-                    vma_alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                    vma_alloc_info.flags = mesh_streaming ? 0 : VMA_ALLOCATION_CREATE_MAPPED_BIT |
                         VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
 
                     if (
@@ -4419,144 +5442,194 @@ namespace
                     }
                 }
 
-                // *** SETTING STAGING BUFFER *** //
-                allocated_buffer staging{};
+                if (mesh_streaming)
                 {
-                    VkBufferCreateInfo buffer_info{};
-                    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-                    buffer_info.pNext = nullptr;
-                    buffer_info.size = total_vertex_buffer_size + total_index_buffer_size;
-                    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-
-                    VmaAllocationCreateInfo vma_alloc_info{};
-                    vma_alloc_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-                    vma_alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
-                        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
-
-                    if (const VkResult res = vmaCreateBuffer(allocator, &buffer_info, &vma_alloc_info, &staging.buffer,
-                                                             &staging.allocation, &staging.info); res != VK_SUCCESS)
+                    // Nothing is uploaded now, stream_meshes copies meshes into ranges of the pools as the cells using them come near.
+                    VmaVirtualBlockCreateInfo vertex_pool_info{};
+                    vertex_pool_info.size = vertex_pool_size;
+                    if (const VkResult res = vmaCreateVirtualBlock(&vertex_pool_info, &vertex_pool); res != VK_SUCCESS)
                     {
-                        l->error(std::format("Error creating staging buffer: {}", static_cast<uint8_t>(res)));
+                        l->error(std::format("Error creating vertex pool: {}", string_VkResult(res)));
                         return result::error;
                     }
+                    VmaVirtualBlockCreateInfo index_pool_info{};
+                    index_pool_info.size = index_pool_size;
+                    if (const VkResult res = vmaCreateVirtualBlock(&index_pool_info, &index_pool); res != VK_SUCCESS)
                     {
-                        const auto object_name = std::format("rosy vertex buffer staging {}", 0);
-                        VkDebugUtilsObjectNameInfoEXT debug_name{};
-                        debug_name.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
-                        debug_name.pNext = nullptr;
-                        debug_name.objectType = VK_OBJECT_TYPE_BUFFER;
-                        debug_name.objectHandle = reinterpret_cast<uint64_t>(staging.buffer);
-                        debug_name.pObjectName = object_name.c_str();
-                        if (const VkResult res = vkSetDebugUtilsObjectNameEXT(device, &debug_name); res != VK_SUCCESS)
+                        l->error(std::format("Error creating index pool: {}", string_VkResult(res)));
+                        return result::error;
+                    }
+                    mesh_streams.reserve(a.meshes.size());
+                    mesh_releases.reserve(a.meshes.size());
+                    mesh_vertex_copies.reserve(a.meshes.size());
+                    mesh_index_copies.reserve(a.meshes.size());
+                    mesh_stream_asset = new_asset;
+                    for (size_t mesh_index{0}; mesh_index < a.meshes.size(); mesh_index++)
+                    {
+                        const auto& mesh = a.meshes[mesh_index];
+                        mesh_stream ms{.positions = mesh.positions, .indices = mesh.indices};
+                        if (!mesh.positions.empty())
                         {
-                            l->error(std::format("Error creating staging buffer name: {}", static_cast<uint8_t>(res)));
-                            return result::error;
+                            ms.bounds_min = mesh.positions[0].vertex;
+                            ms.bounds_max = mesh.positions[0].vertex;
+                            for (const rosy_asset::position& p : mesh.positions)
+                            {
+                                for (size_t axis{0}; axis < 3; axis++)
+                                {
+                                    ms.bounds_min[axis] = std::min(ms.bounds_min[axis], p.vertex[axis]);
+                                    ms.bounds_max[axis] = std::max(ms.bounds_max[axis], p.vertex[axis]);
+                                }
+                            }
                         }
+                        mesh_streams.push_back(ms);
+                        largest_mesh_stream_size = std::max(largest_mesh_stream_size, mesh.positions.size() * sizeof(rosy_asset::position) + mesh.indices.size() * sizeof(uint32_t));
+                        // Meshes without geometry have nothing to stream and nothing to draw.
+                        gpu_meshes[mesh_index].resident = mesh.positions.empty() || mesh.indices.empty();
                     }
+                    l->info(std::format("Level geometry of {} vertex and {} index bytes is streamed through {} and {} byte pools", total_vertex_buffer_size,
+                                        total_index_buffer_size, vertex_pool_size, index_pool_size));
                 }
-
+                else
                 {
-                    size_t current_vertex_offset{0};
-                    for (const auto& mesh : a.meshes)
+                    // *** SETTING STAGING BUFFER *** //
+                    allocated_buffer staging{};
                     {
-                        const size_t vertex_buffer_size = mesh.positions.size() * sizeof(rosy_asset::position);
+                        VkBufferCreateInfo buffer_info{};
+                        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+                        buffer_info.pNext = nullptr;
+                        buffer_info.size = total_vertex_buffer_size + total_index_buffer_size;
+                        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+                        VmaAllocationCreateInfo vma_alloc_info{};
+                        vma_alloc_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+                        vma_alloc_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+
+                        if (const VkResult res = vmaCreateBuffer(allocator, &buffer_info, &vma_alloc_info, &staging.buffer,
+                                                                 &staging.allocation, &staging.info); res != VK_SUCCESS)
+                        {
+                            l->error(std::format("Error creating staging buffer: {}", static_cast<uint8_t>(res)));
+                            return result::error;
+                        }
+                        {
+                            const auto object_name = std::format("rosy vertex buffer staging {}", 0);
+                            VkDebugUtilsObjectNameInfoEXT debug_name{};
+                            debug_name.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+                            debug_name.pNext = nullptr;
+                            debug_name.objectType = VK_OBJECT_TYPE_BUFFER;
+                            debug_name.objectHandle = reinterpret_cast<uint64_t>(staging.buffer);
+                            debug_name.pObjectName = object_name.c_str();
+                            if (const VkResult res = vkSetDebugUtilsObjectNameEXT(device, &debug_name); res != VK_SUCCESS)
+                            {
+                                l->error(std::format("Error creating staging buffer name: {}", static_cast<uint8_t>(res)));
+                                return result::error;
+                            }
+                        }
+                    }
 
-                        if (staging.info.pMappedData != nullptr)
-                            memcpy(
-                                static_cast<char*>(staging.info.pMappedData) + current_vertex_offset,
-                                mesh.positions.data(),
-                                vertex_buffer_size);
-                        current_vertex_offset += vertex_buffer_size;
+                    {
+                        size_t current_vertex_offset{0};
+                        for (const auto& mesh : a.meshes)
+                        {
+                            const size_t vertex_buffer_size = mesh.positions.size() * sizeof(rosy_asset::position);
+
+                            if (staging.info.pMappedData != nullptr)
+                                memcpy(
+                                    static_cast<char*>(staging.info.pMappedData) + current_vertex_offset,
+                                    mesh.positions.data(),
+                                    vertex_buffer_size);
+                            current_vertex_offset += vertex_buffer_size;
+                        }
                     }
-                }
 
-                {
-                    size_t current_index_offset{0};
-                    for (const auto& mesh : a.meshes)
                     {
-                        const size_t index_buffer_size = mesh.indices.size() * sizeof(uint32_t);
+                        size_t current_index_offset{0};
+                        for (const auto& mesh : a.meshes)
+                        {
+                            const size_t index_buffer_size = mesh.indices.size() * sizeof(uint32_t);
 
-                        if (staging.info.pMappedData != nullptr)
-                            memcpy(
-                                static_cast<char*>(staging.info.pMappedData) + total_vertex_buffer_size +
-                                current_index_offset, mesh.indices.data(), index_buffer_size);
-                        current_index_offset += index_buffer_size;
+                            if (staging.info.pMappedData != nullptr)
+                                memcpy(
+                                    static_cast<char*>(staging.info.pMappedData) + total_vertex_buffer_size +
+                                    current_index_offset, mesh.indices.data(), index_buffer_size);
+                            current_index_offset += index_buffer_size;
+                        }
                     }
-                }
 
-                if (VkResult res = vkResetFences(device, 1, &immediate_fence); res != VK_SUCCESS)
-                {
-                    l->error(std::format("Error resetting immediate fence: {}", static_cast<uint8_t>(res)));
-                    return result::error;
-                }
+                    if (VkResult res = vkResetFences(device, 1, &immediate_fence); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Error resetting immediate fence: {}", static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
 
-                if (VkResult res = vkResetCommandBuffer(immediate_command_buffer, 0); res != VK_SUCCESS)
-                {
-                    l->error(std::format("Error resetting immediate command buffer: {}", static_cast<uint8_t>(res)));
-                    return result::error;
-                }
+                    if (VkResult res = vkResetCommandBuffer(immediate_command_buffer, 0); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Error resetting immediate command buffer: {}", static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
 
-                VkCommandBufferBeginInfo begin_info = {};
-                begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-                begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                    VkCommandBufferBeginInfo begin_info = {};
+                    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-                if (VkResult res = vkBeginCommandBuffer(immediate_command_buffer, &begin_info); res != VK_SUCCESS)
-                {
-                    l->error(std::format("Error beginning immediate command buffer: {}", static_cast<uint8_t>(res)));
-                    return result::error;
-                }
+                    if (VkResult res = vkBeginCommandBuffer(immediate_command_buffer, &begin_info); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Error beginning immediate command buffer: {}", static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
 
-                {
-                    VkBufferCopy vertex_copy{};
-                    vertex_copy.dstOffset = 0;
-                    vertex_copy.srcOffset = 0;
-                    vertex_copy.size = total_vertex_buffer_size;
+                    {
+                        VkBufferCopy vertex_copy{};
+                        vertex_copy.dstOffset = 0;
+                        vertex_copy.srcOffset = 0;
+                        vertex_copy.size = total_vertex_buffer_size;
 
-                    vkCmdCopyBuffer(immediate_command_buffer, staging.buffer, vertex_buffer.buffer, 1, &vertex_copy);
+                        vkCmdCopyBuffer(immediate_command_buffer, staging.buffer, vertex_buffer.buffer, 1, &vertex_copy);
 
-                    VkBufferCopy index_copy{};
-                    index_copy.dstOffset = 0;
-                    index_copy.srcOffset = total_vertex_buffer_size;
-                    index_copy.size = total_index_buffer_size;
+                        VkBufferCopy index_copy{};
+                        index_copy.dstOffset = 0;
+                        index_copy.srcOffset = total_vertex_buffer_size;
+                        index_copy.size = total_index_buffer_size;
 
-                    vkCmdCopyBuffer(immediate_command_buffer, staging.buffer, index_buffer.buffer, 1, &index_copy);
-                }
+                        vkCmdCopyBuffer(immediate_command_buffer, staging.buffer, index_buffer.buffer, 1, &index_copy);
+                    }
 
-                if (VkResult res = vkEndCommandBuffer(immediate_command_buffer); res != VK_SUCCESS)
-                {
-                    l->error(std::format("Error ending immediate command buffer: {}", static_cast<uint8_t>(res)));
-                    return result::error;
-                }
+                    if (VkResult res = vkEndCommandBuffer(immediate_command_buffer); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Error ending immediate command buffer: {}", static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
 
-                VkCommandBufferSubmitInfo cmd_buffer_submit_info = {};
-                cmd_buffer_submit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
-                cmd_buffer_submit_info.pNext = nullptr;
-                cmd_buffer_submit_info.commandBuffer = immediate_command_buffer;
-                cmd_buffer_submit_info.deviceMask = 0;
-                VkSubmitInfo2 submit_info = {};
-                submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
-                submit_info.pNext = nullptr;
+                    VkCommandBufferSubmitInfo cmd_buffer_submit_info = {};
+                    cmd_buffer_submit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+                    cmd_buffer_submit_info.pNext = nullptr;
+                    cmd_buffer_submit_info.commandBuffer = immediate_command_buffer;
+                    cmd_buffer_submit_info.deviceMask = 0;
+                    VkSubmitInfo2 submit_info = {};
+                    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+                    submit_info.pNext = nullptr;
 
-                submit_info.waitSemaphoreInfoCount = 0;
-                submit_info.pWaitSemaphoreInfos = nullptr;
-                submit_info.signalSemaphoreInfoCount = 0;
-                submit_info.pSignalSemaphoreInfos = nullptr;
-                submit_info.commandBufferInfoCount = 1;
-                submit_info.pCommandBufferInfos = &cmd_buffer_submit_info;
+                    submit_info.waitSemaphoreInfoCount = 0;
+                    submit_info.pWaitSemaphoreInfos = nullptr;
+                    submit_info.signalSemaphoreInfoCount = 0;
+                    submit_info.pSignalSemaphoreInfos = nullptr;
+                    submit_info.commandBufferInfoCount = 1;
+                    submit_info.pCommandBufferInfos = &cmd_buffer_submit_info;
 
-                if (VkResult res = vkQueueSubmit2(present_queue, 1, &submit_info, immediate_fence); res != VK_SUCCESS)
-                {
-                    l->error(std::format("Error submitting immediate command to present queue: {}",
-                                         static_cast<uint8_t>(res)));
-                    return result::error;
-                }
+                    if (VkResult res = vkQueueSubmit2(present_queue, 1, &submit_info, immediate_fence); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Error submitting immediate command to present queue: {}",
+                                             static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
 
-                if (VkResult res = vkWaitForFences(device, 1, &immediate_fence, true, 9999999999); res != VK_SUCCESS)
-                {
-                    l->error(std::format("Error waiting for immediate fence: {}", static_cast<uint8_t>(res)));
-                    return result::error;
+                    if (VkResult res = vkWaitForFences(device, 1, &immediate_fence, true, 9999999999); res != VK_SUCCESS)
+                    {
+                        l->error(std::format("Error waiting for immediate fence: {}", static_cast<uint8_t>(res)));
+                        return result::error;
+                    }
+                    vmaDestroyBuffer(allocator, staging.buffer, staging.allocation);
                 }
-                vmaDestroyBuffer(allocator, staging.buffer, staging.allocation);
             }
 
             {
@@ -4688,7 +5761,7 @@ namespace
             return result::ok;
         }
 
-        result set_graphic_objects(std::vector<graphics_object> graphics_objects)
+        result set_graphic_objects(std::vector<graphics_object> graphics_objects, const size_t dynamic_objects_offset)
         {
             if (graphics_objects.empty())
             {
@@ -4698,6 +5771,8 @@ namespace
             shadow_casting_graphics.clear();
             opaque_graphics.clear();
             blended_graphics.clear();
+            dynamic_graphic_objects.clear();
+            for (std::vector<graphics_object_range>& pending_ranges : pending_graphic_object_ranges) pending_ranges.clear();
 
             {
                 // Clear any previously uploaded graphic object buffers
@@ -4713,6 +5788,35 @@ namespace
                 }
             }
 
+            {
+                // Record which graphic objects use each streamed texture so the closest ones stream first.
+                graphic_object_positions.clear();
+                graphic_object_positions.reserve(graphics_objects.size());
+                for (texture_stream& ts : texture_streams) ts.graphic_object_indices.clear();
+                for (size_t go_index{0}; go_index < graphics_objects.size(); go_index++)
+                {
+                    const graphics_object& go = graphics_objects[go_index];
+                    graphic_object_positions.push_back({go.transform[12], go.transform[13], go.transform[14]});
+                    for (const auto& sd : go.surface_data)
+                    {
+                        if (sd.material_index >= material_texture_streams.size()) continue;
+                        for (const size_t stream_index : material_texture_streams[sd.material_index])
+                        {
+                            if (std::vector<size_t>& users = texture_streams[stream_index].graphic_object_indices; std::ranges::find(users, go_index) == users.end())
+                            {
+                                users.push_back(go_index);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (const auto res = build_mesh_cells(graphics_objects, dynamic_objects_offset); res != result::ok)
+            {
+                l->error("Error building mesh streaming cells");
+                return res;
+            }
+
             std::vector<graphic_object_data> go_data{};
             go_data.reserve(graphics_objects.size());
             for (const auto& go : graphics_objects)
@@ -4922,7 +6026,35 @@ namespace
 
         result update_graphic_objects(const graphics_object_update& new_graphics_objects_update)
         {
-            graphics_object_update_data = new_graphics_objects_update;
+            // Only the dirty ranges are copied. Every frame has its own graphics object buffer so each one is queued the change and
+            // brought up to date the next time it is the frame being updated.
+            dynamic_graphic_objects_offset = new_graphics_objects_update.offset;
+            dynamic_graphic_objects.resize(new_graphics_objects_update.graphic_objects.size());
+            for (const auto& [first, count] : new_graphics_objects_update.dirty_ranges)
+            {
+                if (first + count > dynamic_graphic_objects.size())
+                {
+                    l->error(std::format("graphics object update range {} + {} is past the {} dynamic graphics objects", first, count, dynamic_graphic_objects.size()));
+                    return result::overflow;
+                }
+                for (size_t i{first}; i < first + count; i++)
+                {
+                    const graphics_object_transform& go = new_graphics_objects_update.graphic_objects[i];
+                    dynamic_graphic_objects[i] = {
+                        .transform = go.transform,
+                        .to_object_space_transform = go.to_object_space_transform,
+                        .normal_transform = go.normal_transform,
+                    };
+                    if (const size_t go_index = dynamic_graphic_objects_offset + i; go_index < graphic_object_positions.size())
+                    {
+                        graphic_object_positions[go_index] = {go.transform[12], go.transform[13], go.transform[14]};
+                    }
+                }
+                for (size_t frame{0}; frame < swapchain_image_count; frame++)
+                {
+                    pending_graphic_object_ranges[frame].push_back({.first = first, .count = count});
+                }
+            }
             return result::ok;
         }
 
@@ -4984,6 +6116,12 @@ namespace
                     l->error(std::format("Error begin recording command buffer: {}", static_cast<uint8_t>(res)));
                     return result::graphics_frame_failure;
                 }
+                stream_textures(cf.command_buffer, frame_datas[current_frame]);
+                if (const auto res = stream_meshes(cf.command_buffer, frame_datas[current_frame]); res != result::ok)
+                {
+                    l->error(std::format("Error streaming meshes: {}", static_cast<uint8_t>(res)));
+                    return result::graphics_frame_failure;
+                }
                 {
                     {
                         vkCmdSetRasterizerDiscardEnableEXT(cf.command_buffer, VK_FALSE);
@@ -5063,8 +6201,28 @@ namespace
                 }
                 size_t frame_to_update = static_cast<size_t>(current_frame + 1);
                 if (frame_to_update >= swapchain_image_count) frame_to_update = 0;
+                std::vector<graphics_object_range>& pending_ranges = pending_graphic_object_ranges[frame_to_update];
                 {
-                    std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+                    // Ranges queued over several updates may overlap, merge them so nothing is written twice.
+                    std::ranges::sort(pending_ranges, {}, &graphics_object_range::first);
+                    size_t merged{0};
+                    for (size_t i{0}; i < pending_ranges.size(); i++)
+                    {
+                        if (merged > 0 && pending_ranges[merged - 1].first + pending_ranges[merged - 1].count >= pending_ranges[i].first)
+                        {
+                            const size_t end = std::max(pending_ranges[merged - 1].first + pending_ranges[merged - 1].count, pending_ranges[i].first + pending_ranges[i].count);
+                            pending_ranges[merged - 1].count = end - pending_ranges[merged - 1].first;
+                            continue;
+                        }
+                        pending_ranges[merged] = pending_ranges[i];
+                        merged += 1;
+                    }
+                    pending_ranges.resize(merged);
+                }
+                {
+                    // At most the scene buffer and the dynamic graphics objects' range.
+                    std::array<VkBufferMemoryBarrier2, 2> buffer_barriers{};
+                    uint32_t num_buffer_barriers{0};
                     {
                         VkBufferMemoryBarrier2 buffer_barrier{
                             .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
@@ -5079,9 +6237,9 @@ namespace
                             .offset = 0,
                             .size = sizeof(gpu_scene_data),
                         };
-                        buffer_barriers.push_back(buffer_barrier);
+                        buffer_barriers[num_buffer_barriers++] = buffer_barrier;
                     }
-                    if (!graphics_object_update_data.graphic_objects.empty())
+                    if (!pending_ranges.empty())
                     {
                         VkBufferMemoryBarrier2 buffer_barrier{
                             .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
@@ -5093,10 +6251,10 @@ namespace
                             .srcQueueFamilyIndex = 0,
                             .dstQueueFamilyIndex = 0,
                             .buffer = frame_datas[frame_to_update].graphic_objects_buffer.go_buffer.buffer,
-                            .offset = graphics_object_update_data.offset,
-                            .size = sizeof(graphic_object_data),
+                            .offset = sizeof(graphic_object_data) * (dynamic_graphic_objects_offset + pending_ranges.front().first),
+                            .size = sizeof(graphic_object_data) * (pending_ranges.back().first + pending_ranges.back().count - pending_ranges.front().first),
                         };
-                        buffer_barriers.push_back(buffer_barrier);
+                        buffer_barriers[num_buffer_barriers++] = buffer_barrier;
                     }
 
                     const VkDependencyInfo dependency_info{
@@ -5105,7 +6263,7 @@ namespace
                         .dependencyFlags = 0,
                         .memoryBarrierCount = 0,
                         .pMemoryBarriers = nullptr,
-                        .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers.size()),
+                        .bufferMemoryBarrierCount = num_buffer_barriers,
                         .pBufferMemoryBarriers = buffer_barriers.data(),
                         .imageMemoryBarrierCount = 0,
                         .pImageMemoryBarriers = nullptr,
@@ -5118,23 +6276,21 @@ namespace
                     vkCmdUpdateBuffer(cf.command_buffer, frame_datas[frame_to_update].scene_buffer.scene_buffer.buffer,
                                       0, sizeof(gpu_scene_data), &scene_data);
                 }
-                if (!graphics_object_update_data.graphic_objects.empty())
                 {
-                    std::vector<graphic_object_data> updated;
-                    updated.reserve(graphics_object_update_data.graphic_objects.size());
-                    for (const auto& gou : graphics_object_update_data.graphic_objects)
+                    // Update only the dynamic graphics objects that changed, vkCmdUpdateBuffer is limited to 65536 bytes per call.
+                    constexpr size_t max_objects_per_update = 65'536 / sizeof(graphic_object_data);
+                    for (const auto& [first, count] : pending_ranges)
                     {
-                        updated.push_back({
-                            .transform = gou.transform,
-                            .to_object_space_transform = gou.to_object_space_transform,
-                            .normal_transform = gou.normal_transform,
-                        });
+                        for (size_t start{first}; start < first + count; start += max_objects_per_update)
+                        {
+                            const size_t num_objects = std::min(max_objects_per_update, first + count - start);
+                            vkCmdUpdateBuffer(cf.command_buffer, frame_datas[frame_to_update].graphic_objects_buffer.go_buffer.buffer,
+                                              sizeof(graphic_object_data) * (dynamic_graphic_objects_offset + start),
+                                              sizeof(graphic_object_data) * num_objects, dynamic_graphic_objects.data() + start);
+                        }
                     }
-                    vkCmdUpdateBuffer(cf.command_buffer, frame_datas[frame_to_update].graphic_objects_buffer.go_buffer.buffer, sizeof(graphic_object_data) * graphics_object_update_data.offset,
-                                      sizeof(graphic_object_data) * updated.size(), updated.data());
                     // Clear out state so that we avoid unnecessary updates.
-                    graphics_object_update_data.offset = 0;
-                    graphics_object_update_data.graphic_objects.clear();
+                    pending_ranges.clear();
                 }
                 vkCmdEndDebugUtilsLabelEXT(cf.command_buffer);
             }
@@ -5271,6 +6427,7 @@ namespace
                                  index_count, start_index, blended] : shadow_casting_graphics)
                         {
                             auto& gpu_mesh = gpu_meshes[mesh_index];
+                            if (!gpu_mesh.resident) continue;
                             gpu_shadow_push_constants pc{
                                 .scene_buffer = cf.scene_buffer.scene_buffer_address,
                                 .vertex_buffer = vertex_buffer_address + gpu_mesh.vertex_buffer_offset,
@@ -5635,6 +6792,7 @@ namespace
                                 for (auto& [mesh_index, graphic_objects_offset, graphics_object_index, material_index, index_count, start_index, blended] : opaque_graphics)
                                 {
                                     auto& gpu_mesh = gpu_meshes[mesh_index];
+                                    if (!gpu_mesh.resident) continue;
                                     if (mesh_index != current_mesh_index)
                                     {
                                         current_mesh_index = mesh_index;
@@ -5674,6 +6832,7 @@ namespace
                                 for (auto& [mesh_index, graphic_objects_offset, graphics_object_index, material_index, index_count, start_index, blended] : blended_graphics)
                                 {
                                     auto& gpu_mesh = gpu_meshes[mesh_index];
+                                    if (!gpu_mesh.resident) continue;
                                     if (mesh_index != current_mesh_index)
                                     {
                                         current_mesh_index = mesh_index;
@@ -6097,14 +7256,6 @@ namespace
                 ImGui::EndTabBar();
             }
             ImGui::End();
-            {
-                // Update necessary states
-                if (rls->mob_read.clear_edits)
-                {
-                    du->wls->mob_edit.submitted = false;
-                    du->wls->mob_edit.updated = false;
-                }
-            }
 
             return result::ok;
         }
@@ -6139,6 +7290,14 @@ result graphics::init(SDL_Window* new_window, const std::shared_ptr<rosy_logger:
         }
         gd->l = new_log;
         gd->window = new_window;
+        int width{0};
+        int height{0};
+        if (!SDL_GetWindowSizeInPixels(new_window, &width, &height))
+        {
+            l->error(std::format("Error getting window size: {}", SDL_GetError()));
+            return result::graphics_init_failure;
+        }
+        gd->window_extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
         if (const auto res = gd->init(cfg); res != result::ok)
         {
             l->error("graphics_device initialization failed");
@@ -6173,14 +7332,13 @@ result graphics::update(const read_level_state& rls, write_level_state* wls) con
 {
     if (rls.editor_state.new_asset != nullptr)
     {
-        const auto a = static_cast<const rosy_asset::asset*>(rls.editor_state.new_asset);
-        l->debug(std::format("Setting asset with {} graphic objects.", rls.go_update.graphic_objects.size()));
+        l->debug(std::format("Setting asset with {} graphic objects.", rls.go_update.full_scene.size()));
         gd->set_wls(wls); // Set writable state, this is a pointer to level data that the UI can write to.
-        if (const auto res = gd->set_asset(*a); res != result::ok)
+        if (const auto res = gd->set_asset(rls.editor_state.new_asset); res != result::ok)
         {
             return res;
         }
-        if (const auto res = gd->set_graphic_objects(rls.go_update.full_scene); res != result::ok)
+        if (const auto res = gd->set_graphic_objects(rls.go_update.full_scene, rls.graphic_objects.static_objects_offset); res != result::ok)
         {
             return res;
         }
@@ -6197,12 +7355,13 @@ result graphics::update(const read_level_state& rls, write_level_state* wls) con
 }
 
 // ReSharper disable once CppMemberFunctionMayBeStatic
-result graphics::render(const engine_stats& stats)
+result graphics::render(const engine_stats& stats, const bool cursor_enabled)
 {
     {
+        // The SDL backend's frame was started on the main thread.
         ImGui_ImplVulkan_NewFrame();
-        ImGui_ImplSDL3_NewFrame();
         ImGui::NewFrame();
+        if (!cursor_enabled) ImGui::SetMouseCursor(ImGuiMouseCursor_None);
     }
     {
         if (const auto res = gd->ui(stats); res != result::ok)
@@ -6214,8 +7373,15 @@ result graphics::render(const engine_stats& stats)
     return gd->render();
 }
 
-result graphics::resize()
+// ReSharper disable once CppMemberFunctionMayBeStatic
+bool graphics::streaming() const
+{
+    return gd->streaming_pending();
+}
+
+result graphics::resize(const uint32_t window_width, const uint32_t window_height)
 {
+    gd->window_extent = {window_width, window_height};
     if (const auto res = gd->resize_swapchain(); res != result::ok)
     {
         return res;
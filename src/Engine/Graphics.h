@@ -16,8 +16,12 @@ namespace rosy
 
         [[nodiscard]] result init(SDL_Window* new_window, const std::shared_ptr<rosy_logger::log>& new_log, config cfg);
         [[nodiscard]] result update(const read_level_state& rls, write_level_state* wls) const;
-        [[nodiscard]] result render(const engine_stats& stats);
-        [[nodiscard]] result resize();
+        // Dear ImGui's SDL backend frame must have been started on the main thread.
+        [[nodiscard]] result render(const engine_stats& stats, bool cursor_enabled);
+        // Whether textures or meshes are still being streamed in or released, which only happens while frames are rendered.
+        [[nodiscard]] bool streaming() const;
+        // Recreates the swapchain for a window this many pixels in size.
+        [[nodiscard]] result resize(uint32_t window_width, uint32_t window_height);
         void deinit();
     };
 }
@@ -0,0 +1,241 @@
+#include "pch.h"
+#include "InputRecording.h"
+#include "BinaryIO.h"
+#include <cstring>
+
+using namespace rosy;
+
+// Input Recording File Format:
+// 1. Header
+// 2. a std::vector<char> of the level path character count given
+// 3. a std::vector<recorded_frame> of the frame count given
+// 4. a std::vector<recorded_event> of the event count given
+
+namespace
+{
+    struct recording_header
+    {
+        uint32_t magic{0};
+        uint32_t version{0};
+        uint32_t endianness{0};
+        uint32_t simulation_tick_rate{0};
+        uint64_t num_level_path_chars{0};
+        uint64_t num_frames{0};
+        uint64_t num_events{0};
+    };
+
+    // The recording is read and written as raw memory.
+    static_assert(std::is_trivially_copyable_v<recorded_frame>);
+    static_assert(std::is_trivially_copyable_v<recorded_event>);
+    static_assert(sizeof(recorded_event) == 28);
+
+    // Most frames pass the level a mouse motion or two.
+    constexpr size_t reserved_events_per_frame{4};
+}
+
+void input_recording::clear()
+{
+    level_path.clear();
+    simulation_tick_rate = 0;
+    frames.clear();
+    events.clear();
+    pending_events = 0;
+}
+
+void input_recording::reserve(const size_t num_frames)
+{
+    frames.reserve(num_frames);
+    events.reserve(num_frames * reserved_events_per_frame);
+}
+
+bool input_recording::is_recorded(const SDL_Event& event)
+{
+    switch (event.type)
+    {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+    case SDL_EVENT_MOUSE_MOTION:
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+    case SDL_EVENT_MOUSE_WHEEL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void input_recording::record_event(const SDL_Event& event)
+{
+    if (!is_recorded(event)) return;
+    recorded_event re{.type = event.type};
+    switch (event.type)
+    {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+        re.code = event.key.key;
+        re.mod = event.key.mod;
+        re.down = static_cast<uint8_t>(event.key.down);
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        re.x = event.motion.x;
+        re.y = event.motion.y;
+        re.xrel = event.motion.xrel;
+        re.yrel = event.motion.yrel;
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        re.code = event.button.button;
+        re.clicks = event.button.clicks;
+        re.down = static_cast<uint8_t>(event.button.down);
+        re.x = event.button.x;
+        re.y = event.button.y;
+        break;
+    default:
+        re.down = static_cast<uint8_t>(event.wheel.direction);
+        re.x = event.wheel.mouse_x;
+        re.y = event.wheel.mouse_y;
+        re.xrel = event.wheel.x;
+        re.yrel = event.wheel.y;
+        break;
+    }
+    events.push_back(re);
+    pending_events += 1;
+}
+
+void input_recording::record_frame(const double dt, const uint32_t viewport_width, const uint32_t viewport_height)
+{
+    frames.push_back({
+        .dt = dt,
+        .viewport_width = viewport_width,
+        .viewport_height = viewport_height,
+        .num_events = pending_events,
+        .reserved = 0,
+    });
+    pending_events = 0;
+}
+
+SDL_Event input_recording::to_sdl_event(const recorded_event& event)
+{
+    SDL_Event e{};
+    e.type = event.type;
+    switch (event.type)
+    {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+        e.key.key = event.code;
+        e.key.mod = event.mod;
+        e.key.down = event.down != 0;
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        e.motion.x = event.x;
+        e.motion.y = event.y;
+        e.motion.xrel = event.xrel;
+        e.motion.yrel = event.yrel;
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        e.button.button = static_cast<Uint8>(event.code);
+        e.button.clicks = event.clicks;
+        e.button.down = event.down != 0;
+        e.button.x = event.x;
+        e.button.y = event.y;
+        break;
+    default:
+        e.wheel.direction = static_cast<SDL_MouseWheelDirection>(event.down);
+        e.wheel.mouse_x = event.x;
+        e.wheel.mouse_y = event.y;
+        e.wheel.x = event.xrel;
+        e.wheel.y = event.yrel;
+        break;
+    }
+    return e;
+}
+
+result input_recording::write(const std::shared_ptr<rosy_logger::log>& l, const std::string& path) const
+{
+    std::ofstream o(path, std::ios::binary | std::ios::trunc);
+    if (!o.is_open())
+    {
+        l->error(std::format("failed to open input recording for writing {}", path));
+        return result::open_failed;
+    }
+    const recording_header header{
+        .magic = input_recording_format,
+        .version = input_recording_version,
+        .endianness = 1, // for std::endian::little
+        .simulation_tick_rate = simulation_tick_rate,
+        .num_level_path_chars = level_path.size(),
+        .num_frames = frames.size(),
+        .num_events = events.size(),
+    };
+    o.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    o.write(level_path.data(), static_cast<std::streamsize>(level_path.size()));
+    o.write(reinterpret_cast<const char*>(frames.data()), static_cast<std::streamsize>(frames.size() * sizeof(recorded_frame)));
+    o.write(reinterpret_cast<const char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(recorded_event)));
+    o.close();
+    if (o.fail())
+    {
+        l->error(std::format("failed to write input recording {}", path));
+        return result::write_failed;
+    }
+    l->info(std::format("wrote input recording {} with {} frames and {} events", path, frames.size(), events.size()));
+    return result::ok;
+}
+
+result input_recording::read(const std::shared_ptr<rosy_logger::log>& l, const std::string& path)
+{
+    clear();
+    std::vector<char> buffer;
+    {
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            l->error(std::format("failed to open input recording {}", path));
+            return result::open_failed;
+        }
+        const std::streamsize file_size = file.tellg();
+        if (file_size < static_cast<std::streamsize>(sizeof(recording_header)))
+        {
+            l->error(std::format("invalid input recording {}", path));
+            return result::read_failed;
+        }
+        buffer.resize(static_cast<size_t>(file_size));
+        file.seekg(0);
+        if (!file.read(buffer.data(), file_size))
+        {
+            l->error(std::format("failed to read input recording {}", path));
+            return result::read_failed;
+        }
+    }
+
+    recording_header header{};
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.magic != input_recording_format || header.version != input_recording_version || header.endianness != 1)
+    {
+        l->error(std::format("input recording {} is version {}, current version is {}", path, header.version, input_recording_version));
+        return result::invalid_state;
+    }
+
+    size_t offset{sizeof(header)};
+    std::vector<char> level_path_chars;
+    if (!read_items(buffer, offset, header.num_level_path_chars, level_path_chars) ||
+        !read_items(buffer, offset, header.num_frames, frames) ||
+        !read_items(buffer, offset, header.num_events, events))
+    {
+        l->error(std::format("input recording {} is truncated", path));
+        clear();
+        return result::read_failed;
+    }
+    uint64_t num_frame_events{0};
+    for (const recorded_frame& f : frames) num_frame_events += f.num_events;
+    if (num_frame_events > events.size())
+    {
+        l->error(std::format("input recording {} has frames with {} events but only {} events", path, num_frame_events, events.size()));
+        clear();
+        return result::read_failed;
+    }
+    level_path.assign(level_path_chars.begin(), level_path_chars.end());
+    simulation_tick_rate = header.simulation_tick_rate;
+    l->info(std::format("read input recording {} of {} with {} frames and {} events", path, level_path, frames.size(), events.size()));
+    return result::ok;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Types.h"
+#include "Logger/Logger.h"
+#include <SDL3/SDL.h>
+
+namespace rosy
+{
+    constexpr uint32_t input_recording_format{0x52534952}; // "RSIR"
+    constexpr uint32_t input_recording_version{1};
+
+    // An SDL event the level handles, keeping only the fields level::process_sdl_event reads.
+    struct recorded_event
+    {
+        uint32_t type{0};
+        uint32_t code{0}; // the key of key events, the button of mouse button events
+        uint16_t mod{0};
+        uint8_t clicks{0};
+        uint8_t down{0}; // whether a key or button went down, or the direction of a wheel event
+        float x{0.f}; // where the cursor was
+        float y{0.f};
+        float xrel{0.f}; // how far the mouse moved, or how far the wheel scrolled
+        float yrel{0.f};
+    };
+
+    // A frame's update, its events are the num_events after the previous frame's.
+    struct recorded_frame
+    {
+        double dt{0.0};
+        uint32_t viewport_width{0};
+        uint32_t viewport_height{0};
+        uint32_t num_events{0};
+        uint32_t reserved{0};
+    };
+
+    // The input a session gave the level, every event that reached level::process_sdl_event and the dt and viewport each frame
+    // updated it with. Played back with the same timing into the same level the session runs the same simulation ticks with the same
+    // input, so its frame timings can be compared between builds. Changes made through the debug UI are not recorded.
+    struct input_recording
+    {
+        std::string level_path{};
+        uint32_t simulation_tick_rate{0};
+        std::vector<recorded_frame> frames;
+        std::vector<recorded_event> events;
+        // Events recorded since the last frame was.
+        uint32_t pending_events{0};
+
+        void clear();
+        // Memory for this many frames and a few events each, recording does not allocate until it runs past them.
+        void reserve(size_t num_frames);
+        // Skips events the level does not handle.
+        void record_event(const SDL_Event& event);
+        // Ends a frame with the events recorded since the last one.
+        void record_frame(double dt, uint32_t viewport_width, uint32_t viewport_height);
+
+        [[nodiscard]] static bool is_recorded(const SDL_Event& event);
+        [[nodiscard]] static SDL_Event to_sdl_event(const recorded_event& event);
+
+        [[nodiscard]] result write(const std::shared_ptr<rosy_logger::log>& l, const std::string& path) const;
+        // Fails with result::invalid_state when the file is from another version.
+        [[nodiscard]] result read(const std::shared_ptr<rosy_logger::log>& l, const std::string& path);
+    };
+}
@@ -2,10 +2,17 @@
 #include "pch.h"
 #include "Level.h"
 #include "Node.h"
+#include "WorkerPool.h"
+#include "Collision.h"
+#include "Navigation.h"
+#include "Picking.h"
+#include "SceneSnapshot.h"
+#include "Steering.h"
 #include "Camera.h"
 #include "Editor.h"
 #include "Asset/Asset.h"
 #include <queue>
+#include <thread>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -21,6 +28,20 @@ constexpr size_t max_node_stack_size = 4'096;
 constexpr size_t max_stack_item_list = 16'384;
 
 const std::string mobs_node_name{"mobs"};
+constexpr float navigation_cell_size{0.5f};
+// While rosy's target follows the cursor a field toward it is built when the button goes down and at most this often in seconds after,
+// rosy steers along the last field built in between.
+constexpr float navigation_field_interval{0.5f};
+// Static objects only block the navigation grid where they stand between these heights above the floor, so rugs and things
+// hanging overhead do not.
+constexpr float navigation_step_height{0.25f};
+constexpr float navigation_clearance{2.f};
+// Mobs collide as upright capsules as wide as the narrower side of their bounds, starting at the step height so they walk over what
+// navigation lets them.
+constexpr float min_mob_collision_radius{0.1f};
+constexpr size_t pick_debugging_records_reserved{256};
+// Room for the sun and picking debug objects drawn on top of the recorded picks.
+constexpr size_t debug_objects_reserved{16};
 
 namespace
 {
@@ -36,7 +57,8 @@ namespace
 
     struct c_mob
     {
-        size_t [[maybe_unused]] index{0};
+        size_t index{0};
+        uint32_t node_index{0}; // the mob's node in the level's node graph
     };
 
     struct c_static
@@ -56,6 +78,10 @@ namespace
         float y{0.f};
         float z{0.f};
         [[maybe_unused]] float t{0.f};
+        // Where the flow field the mob steers along leads, the target itself unless the target moved since the field was built.
+        float field_x{0.f};
+        float field_y{0.f};
+        float field_z{0.f};
     };
 
     struct c_forward
@@ -104,18 +130,6 @@ namespace
         return a;
     }
 
-    std::array<float, 9> mat3_to_array(glm::mat3 m)
-    {
-        std::array<float, 9> a{
-            1.f, 0.f, 0.f,
-            0.f, 1.f, 0.f,
-            0.f, 0.f, 1.f,
-        };
-        const auto pos_r = glm::value_ptr(m);
-        for (size_t i{0}; i < 9; i++) a[i] = pos_r[i];
-        return a;
-    }
-
     glm::mat4 array_to_mat4(const std::array<float, 16>& a)
     {
         glm::mat4 m{1.f};
@@ -140,7 +154,7 @@ namespace
         return v;
     }
 
-    std::array<float, 3> vec3_to_array(glm::vec3 v)
+    [[maybe_unused]] std::array<float, 3> vec3_to_array(glm::vec3 v)
     {
         std::array<float, 3> a{};
         for (size_t i{0}; i < 3; i++) a[i] = v[static_cast<glm::length_t>(i)];
@@ -156,12 +170,123 @@ namespace
 
     struct stack_item
     {
-        node* game_node{nullptr};
+        uint32_t node_index{node_graph::no_parent};
         rosy_asset::node asset_node;
-        glm::mat4 parent_transform{glm::mat4{1.f}};
         bool is_mob{false};
     };
 
+    struct steering_scratch
+    {
+        std::vector<uint32_t> node_indices;
+        std::vector<float> position_x;
+        std::vector<float> position_y;
+        std::vector<float> position_z;
+        std::vector<float> target_x;
+        std::vector<float> target_y;
+        std::vector<float> target_z;
+        std::vector<float> new_position_x;
+        std::vector<float> new_position_y;
+        std::vector<float> new_position_z;
+        std::vector<float> yaws;
+        std::vector<uint8_t> moved;
+
+        void resize(const size_t count)
+        {
+            node_indices.resize(count);
+            for (std::vector<float>* v : {&position_x, &position_y, &position_z, &target_x, &target_y, &target_z, &new_position_x, &new_position_y, &new_position_z, &yaws})
+            {
+                v->resize(count);
+            }
+            moved.resize(count);
+        }
+    };
+
+    // Every mob's world space translate in mob order, which is also the order of their collision bodies.
+    struct collision_scratch
+    {
+        std::vector<uint32_t> node_indices;
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> yaws;
+        std::vector<uint8_t> pushed;
+
+        void reset(const std::span<node> mobs)
+        {
+            node_indices.resize(mobs.size());
+            for (size_t i{0}; i < mobs.size(); i++) node_indices[i] = mobs[i].index;
+            for (std::vector<float>* v : {&x, &y, &z, &yaws}) v->resize(mobs.size());
+            pushed.assign(mobs.size(), 0);
+        }
+    };
+
+    // Each mob's world space translate and yaw before and after the last simulation step, blended to the frame's point between them for
+    // rendering. Mobs whose two states match are left alone, so only moving mobs cost anything at render time.
+    struct interpolation_scratch
+    {
+        std::vector<uint32_t> node_indices;
+        std::vector<float> previous_x;
+        std::vector<float> previous_y;
+        std::vector<float> previous_z;
+        std::vector<float> previous_yaws;
+        std::vector<float> current_x;
+        std::vector<float> current_y;
+        std::vector<float> current_z;
+        std::vector<float> current_yaws;
+        std::vector<float> render_x;
+        std::vector<float> render_y;
+        std::vector<float> render_z;
+        std::vector<float> render_yaws;
+        std::vector<uint8_t> moving;
+        std::vector<uint8_t> drawn_moving; // drawn at an interpolated state last frame
+        std::vector<uint8_t> drawn; // written at the render state this frame
+
+        void reset(const std::span<node> mobs)
+        {
+            node_indices.resize(mobs.size());
+            for (size_t i{0}; i < mobs.size(); i++) node_indices[i] = mobs[i].index;
+            for (std::vector<float>* v : {
+                     &previous_x, &previous_y, &previous_z, &previous_yaws, &current_x, &current_y, &current_z, &current_yaws, &render_x, &render_y,
+                     &render_z, &render_yaws
+                 })
+            {
+                v->resize(mobs.size());
+            }
+            moving.assign(mobs.size(), 0);
+            drawn_moving.assign(mobs.size(), 0);
+            drawn.assign(mobs.size(), 0);
+        }
+
+        void read_previous(const node_graph& graph)
+        {
+            graph.get_world_space_translates_and_yaws(node_indices.data(), node_indices.size(), previous_x.data(), previous_y.data(), previous_z.data(),
+                                                      previous_yaws.data());
+        }
+
+        void read_current(const node_graph& graph)
+        {
+            graph.get_world_space_translates_and_yaws(node_indices.data(), node_indices.size(), current_x.data(), current_y.data(), current_z.data(),
+                                                      current_yaws.data());
+        }
+
+        void blend(const float alpha)
+        {
+            for (size_t i{0}; i < node_indices.size(); i++)
+            {
+                // Yaws wrap at pi, so they are blended the short way around.
+                float yaw_change = current_yaws[i] - previous_yaws[i];
+                if (yaw_change > glm::pi<float>()) yaw_change -= glm::two_pi<float>();
+                if (yaw_change < -glm::pi<float>()) yaw_change += glm::two_pi<float>();
+                render_x[i] = previous_x[i] + (current_x[i] - previous_x[i]) * alpha;
+                render_y[i] = previous_y[i] + (current_y[i] - previous_y[i]) * alpha;
+                render_z[i] = previous_z[i] + (current_z[i] - previous_z[i]) * alpha;
+                render_yaws[i] = previous_yaws[i] + yaw_change * alpha;
+                moving[i] = previous_x[i] != current_x[i] || previous_y[i] != current_y[i] || previous_z[i] != current_z[i] ||
+                            previous_yaws[i] != current_yaws[i];
+            }
+        }
+    };
+
     // Game nodes are double referenced by entity id and index in a vector.
     struct game_node_reference
     {
@@ -171,6 +296,8 @@ namespace
     };
 
     constexpr float initial_fps_target{240.f};
+    // A frame long enough to need more simulation steps than this drops the rest instead of falling further behind.
+    constexpr uint32_t max_simulation_steps{8};
 
     struct level_state
     {
@@ -192,12 +319,39 @@ namespace
         // asset to graphics objects
         std::queue<stack_item> queue{};
 
-        node* level_game_node{nullptr};
+        // Splits transform and graphics object updates of large levels across threads.
+        worker_pool pool{};
+        // Every game node in the level in breadth first order.
+        node_graph graph{};
+        // Ray queries against the level's triangles.
+        picking picker{};
+        // Flow fields over the floor that mobs follow toward their targets.
+        navigation nav{};
+        // Seconds until a field toward rosy's moving target may be built again.
+        float rosy_field_wait{0.f};
+        // Keeps mobs out of static objects.
+        collision collider{};
         // Important game nodes that can be referenced via their graphics object index
         std::vector<game_node_reference> game_nodes;
+        // The built scene of the current level as saved to and loaded from its snapshot file.
+        scene_snapshot snapshot{};
+        // Scratch arrays for steering a table of mobs, kept to reuse their memory every frame.
+        steering_scratch steering{};
+        // Mob states of the last two simulation steps for rendering in between them.
+        interpolation_scratch interpolation{};
+        collision_scratch colliding{};
+
+        // Fixed step simulation, frame time accumulates until it covers a whole step.
+        double simulation_step{1.0 / 60.0};
+        double simulation_accumulator{0.0};
+        bool rosy_was_moving{false};
 
         // ECS
+        uint32_t system_threads{1};
+        bool system_time_measured{false};
         flecs::world world;
+        // Systems that advance the simulation, run in order once per fixed step instead of once per frame by the pipeline.
+        std::vector<flecs::system> simulation_systems;
         flecs::entity level_entity = world.entity("level");
         game_node_reference rosy_reference{};
         flecs::entity floor_entity = world.entity("floor");
@@ -205,19 +359,31 @@ namespace
         result init(const std::shared_ptr<rosy_logger::log>& new_log, const config new_cfg)
         {
             l = new_log;
-            if (level_game_node = new(std::nothrow) node; level_game_node == nullptr)
+            if (const auto res = pool.init(l); res != result::ok)
             {
-                l->error("root scene_objects allocation failed");
-                return result::allocation_failure;
-            };
-            if (const auto res = level_game_node->init(l, false, {}, {}, {}, {}, 1.f, 0.f); res != result::ok)
+                l->error("worker pool initialization failed");
+                return res;
+            }
+            if (const auto res = graph.init(l, &pool); res != result::ok)
             {
                 l->error("root scene_objects initialization failed");
-                delete level_game_node;
-                level_game_node = nullptr;
-                return result::error;
+                return res;
+            }
+            if (const auto res = picker.init(l); res != result::ok)
+            {
+                l->error("picking initialization failed");
+                return res;
+            }
+            if (const auto res = nav.init(l, navigation_cell_size); res != result::ok)
+            {
+                l->error("navigation initialization failed");
+                return res;
+            }
+            if (const auto res = collider.init(l); res != result::ok)
+            {
+                l->error("collision initialization failed");
+                return res;
             }
-            level_game_node->name = "rosy_root";
 
             // Free camera initialization
             {
@@ -275,6 +441,10 @@ namespace
 
             world.set_target_fps(initial_fps_target);
 
+            simulation_step = 1.0 / static_cast<double>(std::max(1u, new_cfg.simulation_tick_rate));
+            l->info(std::format("level simulation stepping at {} Hz", std::max(1u, new_cfg.simulation_tick_rate)));
+            system_threads = new_cfg.level_system_threads > 0 ? new_cfg.level_system_threads : std::max(1u, std::thread::hardware_concurrency());
+            l->info(std::format("level systems running on {} threads", system_threads));
             init_systems();
 
             return result::ok;
@@ -286,12 +456,11 @@ namespace
             {
                 gnr.entity.destruct();
             }
-            if (level_game_node != nullptr)
-            {
-                level_game_node->deinit();
-                delete level_game_node;
-                level_game_node = nullptr;
-            }
+            collider.deinit();
+            nav.deinit();
+            picker.deinit();
+            graph.deinit();
+            pool.deinit();
             if (world.is_alive(level_entity))
             {
                 level_entity.destruct();
@@ -326,8 +495,10 @@ namespace
             }
             {
                 // Clear existing game nodes
-                for (node* n : level_game_node->children) n->deinit();
-                level_game_node->children.clear();
+                game_nodes.clear();
+                nav.clear();
+                collider.clear();
+                graph.clear();
             }
             if (world.is_alive(level_entity))
             {
@@ -347,9 +518,13 @@ namespace
 
         // **** ECS SYSTEM DEFINITIONS ****/
 
-        void init_system_init_level_state() const
+        // Phases run in order and level systems in a phase run in declaration order. Systems that touch the shared read level state run
+        // on the main thread, systems marked multi_threaded split their matched entities across the world's worker threads.
+        // Simulation systems have no phase, they are kept in simulation_systems and run by simulate with the fixed step as delta time.
+
+        void init_system_sync_camera()
         {
-            world.system("init_level_state")
+            world.system("sync_camera")
                  .kind(flecs::OnLoad)
                  .run([&, this]([[maybe_unused]] flecs::iter& it)
                  {
@@ -383,47 +558,53 @@ namespace
                          // Fragment config
                          rls->fragment_config = wls->fragment_config;
                      }
-                     {
-                         // Mob state
-                         const std::vector<node*> mobs = get_mobs();
-                         if (wls->mob_edit.submitted)
-                         {
-                             rls->mob_read.clear_edits = true;
-                             if (mobs.size() > wls->mob_edit.edit_index)
-                             {
-                                 mobs[wls->mob_edit.edit_index]->set_world_space_translate(wls->mob_edit.position);
-                             }
-                         }
-                         else
-                         {
-                             rls->mob_read.clear_edits = false;
-                         }
-                         rls->mob_read.mob_states.clear();
-                         for (const game_node_reference& nr : game_nodes)
-                         {
-                             const std::array<float, 3> node_world_space_pos = nr.node->get_world_space_position();
+                 });
+        }
 
-                             std::array<float, 3> target = {0.f, 0.f, 0.f};
-                             float yaw = 0.f;
-                             if (nr.entity.has<c_target>())
-                             {
-                                 const auto tc = nr.entity.get<c_target>();
-                                 target = {tc->x, tc->y, tc->z};
-                             }
-                             if (nr.entity.has<c_forward>())
-                             {
-                                 const auto fc = nr.entity.get<c_forward>();
-                                 l->debug(std::format("setting rls yaw: ({:.3f}", fc->yaw));
-                                 yaw = fc->yaw;
-                             }
-                             rls->mob_read.mob_states.push_back({
-                                 .name = nr.node->name,
-                                 .position = node_world_space_pos,
-                                 .yaw = yaw,
-                                 .target = target,
-                             });
-                         }
+        void init_system_apply_mob_edit()
+        {
+            world.system("apply_mob_edit")
+                 .kind(flecs::OnLoad)
+                 .run([&, this]([[maybe_unused]] flecs::iter& it)
+                 {
+                     const std::span<node> mobs = get_mobs();
+                     if (wls->mob_edit.submitted && mobs.size() > wls->mob_edit.edit_index)
+                     {
+                         mobs[wls->mob_edit.edit_index].set_world_space_translate(wls->mob_edit.position);
                      }
+                     // The mob state readback reads world transforms from several threads, so bring them up to date here while single threaded.
+                     graph.update_world_transforms();
+                     rls->mob_read.mob_states.resize(game_nodes.size());
+                 });
+        }
+
+        void init_system_read_mob_state()
+        {
+            // Each mob writes only its own slot of mob_states, which apply_mob_edit sized for every mob.
+            world.system<const c_mob, const c_forward, const c_target*>("read_mob_state")
+                 .kind(flecs::PostLoad)
+                 .multi_threaded()
+                 .each([&, this](const c_mob& m, const c_forward& fc, const c_target* tc)
+                 {
+                     if (m.index >= game_nodes.size()) return;
+                     const node* n = game_nodes[m.index].node;
+                     mob_state& ms = rls->mob_read.mob_states[m.index];
+                     // Only copied when the slot is new or the mob changed, a steady state tick copies no strings.
+                     if (ms.name != n->name()) ms.name = n->name();
+                     ms.position = n->get_world_space_position();
+                     ms.yaw = fc.yaw;
+                     ms.target = tc != nullptr ? std::array<float, 3>{tc->x, tc->y, tc->z} : std::array<float, 3>{0.f, 0.f, 0.f};
+                 });
+        }
+
+        void init_system_update_pick_debugging()
+        {
+            world.system("update_pick_debugging")
+                 .kind(flecs::PostLoad)
+                 .read<c_pick_debugging_enabled>()
+                 .write<t_pick_debugging_clear>()
+                 .run([&, this]([[maybe_unused]] flecs::iter& it)
+                 {
                      rls->debug_objects.clear();
                      if (level_entity.has<t_pick_debugging_clear>())
                      {
@@ -452,88 +633,95 @@ namespace
                      {
                          rls->pick_debugging.space = pick_debug_read_state::picking_space::disabled;
                      }
+                 });
+        }
+
+        void init_system_compute_light()
+        {
+            // Runs after sync_camera, whose camera values the light camera debug option overrides, and after the debug objects are reset.
+            world.system("compute_light")
+                 .kind(flecs::PreUpdate)
+                 .run([&, this]([[maybe_unused]] flecs::iter& it)
+                 {
+                     glm::mat4 light_sun_view;
+                     glm::mat4 debug_light_sun_view;
+                     glm::mat4 debug_light_translate;
+                     glm::mat4 light_line_rot;
                      {
-                         // Light & Shadow logic
-                         glm::mat4 light_sun_view;
-                         glm::mat4 debug_light_sun_view;
-                         glm::mat4 debug_light_translate;
-                         glm::mat4 light_line_rot;
-                         {
-                             // Lighting math
+                         // Lighting math
 
-                             {
-                                 const glm::mat4 light_translate = glm::translate(glm::mat4(1.f), {0.f, 0.f, 1.f * wls->light_debug.sun_distance});
-                                 debug_light_translate = glm::translate(glm::mat4(1.f), {0.f, 0.f, -1.f * wls->light_debug.sun_distance});
+                         {
+                             const glm::mat4 light_translate = glm::translate(glm::mat4(1.f), {0.f, 0.f, 1.f * wls->light_debug.sun_distance});
+                             debug_light_translate = glm::translate(glm::mat4(1.f), {0.f, 0.f, -1.f * wls->light_debug.sun_distance});
 
-                                 const glm::quat pitch_rotation = angleAxis(-wls->light_debug.sun_pitch, glm::vec3{1.f, 0.f, 0.f});
-                                 const glm::quat yaw_rotation = angleAxis(wls->light_debug.sun_yaw, glm::vec3{0.f, -1.f, 0.f});
-                                 light_line_rot = toMat4(yaw_rotation) * toMat4(pitch_rotation);
+                             const glm::quat pitch_rotation = angleAxis(-wls->light_debug.sun_pitch, glm::vec3{1.f, 0.f, 0.f});
+                             const glm::quat yaw_rotation = angleAxis(wls->light_debug.sun_yaw, glm::vec3{0.f, -1.f, 0.f});
+                             light_line_rot = toMat4(yaw_rotation) * toMat4(pitch_rotation);
 
-                                 const glm::quat regular_cam_light_view_pitch_rotation = angleAxis(wls->light_debug.sun_pitch, glm::vec3{1.f, 0.f, 0.f});
-                                 const glm::quat regular_cam_light_view_yaw_rotation = angleAxis(wls->light_debug.sun_yaw + glm::pi<float>(), glm::vec3{0.f, -1.f, 0.f});
-                                 const glm::mat4 regular_cam_light_view = toMat4(regular_cam_light_view_yaw_rotation) * toMat4(regular_cam_light_view_pitch_rotation);
+                             const glm::quat regular_cam_light_view_pitch_rotation = angleAxis(wls->light_debug.sun_pitch, glm::vec3{1.f, 0.f, 0.f});
+                             const glm::quat regular_cam_light_view_yaw_rotation = angleAxis(wls->light_debug.sun_yaw + glm::pi<float>(), glm::vec3{0.f, -1.f, 0.f});
+                             const glm::mat4 regular_cam_light_view = toMat4(regular_cam_light_view_yaw_rotation) * toMat4(regular_cam_light_view_pitch_rotation);
 
-                                 rls->light.sun_position = vec4_to_array(light_line_rot * glm::vec4(0.f, 0.f, -wls->light_debug.sun_distance, 1.f));
+                             rls->light.sun_position = vec4_to_array(light_line_rot * glm::vec4(0.f, 0.f, -wls->light_debug.sun_distance, 1.f));
 
-                                 light_sun_view = light_line_rot * light_translate;
-                                 debug_light_sun_view = (wls->light_debug.enable_light_perspective ? light_sun_view : regular_cam_light_view * light_translate);;
-                             };
-                         }
+                             light_sun_view = light_line_rot * light_translate;
+                             debug_light_sun_view = (wls->light_debug.enable_light_perspective ? light_sun_view : regular_cam_light_view * light_translate);;
+                         };
+                     }
 
-                         if (wls->light_debug.enable_sun_debug)
+                     if (wls->light_debug.enable_sun_debug)
+                     {
+                         // Generate debug lines for light and shadow debugging
+                         const glm::mat4 debug_draw_view = light_line_rot * debug_light_translate;
+                         const glm::mat4 debug_light_line = glm::scale(debug_draw_view, {wls->light_debug.sun_distance, wls->light_debug.sun_distance, wls->light_debug.sun_distance});
+
+                         debug_object line;
+                         line.type = debug_object_type::line;
+                         line.transform = mat4_to_array(debug_light_line);
+                         line.color = {1.f, 0.f, 0.f, 1.f};
+                         if (wls->light_debug.enable_sun_debug) rls->debug_objects.push_back(line);
                          {
-                             // Generate debug lines for light and shadow debugging
-                             const glm::mat4 debug_draw_view = light_line_rot * debug_light_translate;
-                             const glm::mat4 debug_light_line = glm::scale(debug_draw_view, {wls->light_debug.sun_distance, wls->light_debug.sun_distance, wls->light_debug.sun_distance});
-
-                             debug_object line;
-                             line.type = debug_object_type::line;
-                             line.transform = mat4_to_array(debug_light_line);
-                             line.color = {1.f, 0.f, 0.f, 1.f};
-                             if (wls->light_debug.enable_sun_debug) rls->debug_objects.push_back(line);
+                             // Two circles to represent a sun
+                             constexpr float angle_step{glm::pi<float>() / 4.f};
+                             for (size_t i{0}; i < 4; i++)
                              {
-                                 // Two circles to represent a sun
-                                 constexpr float angle_step{glm::pi<float>() / 4.f};
-                                 for (size_t i{0}; i < 4; i++)
-                                 {
-                                     debug_object sun_circle;
-                                     glm::mat4 m{1.f};
-                                     m = glm::rotate(m, angle_step * static_cast<float>(i), {1.f, 0.f, 0.f});
-                                     sun_circle.type = debug_object_type::circle;
-                                     sun_circle.transform = mat4_to_array(debug_draw_view * m);
-                                     sun_circle.color = {0.976f, 0.912f, 0.609f, 1.f};
-                                     rls->debug_objects.push_back(sun_circle);
-                                 }
+                                 debug_object sun_circle;
+                                 glm::mat4 m{1.f};
+                                 m = glm::rotate(m, angle_step * static_cast<float>(i), {1.f, 0.f, 0.f});
+                                 sun_circle.type = debug_object_type::circle;
+                                 sun_circle.transform = mat4_to_array(debug_draw_view * m);
+                                 sun_circle.color = {0.976f, 0.912f, 0.609f, 1.f};
+                                 rls->debug_objects.push_back(sun_circle);
                              }
                          }
+                     }
 
-                         glm::mat4 cam_lv;
-                         glm::mat4 cam_lp;
-                         {
-                             // Create Light view and projection
-
-                             const float cascade_level = wls->light_debug.cascade_level;
-                             auto light_projections = glm::mat4(
-                                 glm::vec4(-2.f / cascade_level, 0.f, 0.f, 0.f),
-                                 glm::vec4(0.f, -2.f / cascade_level, 0.f, 0.f),
-                                 glm::vec4(0.f, 0.f, -1.f / wls->light_debug.orthographic_depth, 0.f),
-                                 glm::vec4(0.f, 0.f, 0.f, 1.f)
-                             );
-
-                             const glm::mat4 lv = light_sun_view;
-                             const glm::mat4 lp = light_projections;
-                             cam_lv = glm::inverse(debug_light_sun_view);
-                             cam_lp = wls->light_debug.enable_light_perspective ? light_projections : array_to_mat4((rls->cam.p));
-                             rls->cam.shadow_projection_near = mat4_to_array(lp * glm::inverse(lv));
-                         }
+                     glm::mat4 cam_lv;
+                     glm::mat4 cam_lp;
+                     {
+                         // Create Light view and projection
+
+                         const float cascade_level = wls->light_debug.cascade_level;
+                         auto light_projections = glm::mat4(
+                             glm::vec4(-2.f / cascade_level, 0.f, 0.f, 0.f),
+                             glm::vec4(0.f, -2.f / cascade_level, 0.f, 0.f),
+                             glm::vec4(0.f, 0.f, -1.f / wls->light_debug.orthographic_depth, 0.f),
+                             glm::vec4(0.f, 0.f, 0.f, 1.f)
+                         );
+
+                         const glm::mat4 lv = light_sun_view;
+                         const glm::mat4 lp = light_projections;
+                         cam_lv = glm::inverse(debug_light_sun_view);
+                         cam_lp = wls->light_debug.enable_light_perspective ? light_projections : array_to_mat4((rls->cam.p));
+                         rls->cam.shadow_projection_near = mat4_to_array(lp * glm::inverse(lv));
+                     }
 
-                         if (wls->light_debug.enable_light_cam)
-                         {
-                             // Set debug lighting options on
-                             rls->debug_enabled = false;
-                             rls->cam.v = mat4_to_array(cam_lv);
-                             rls->cam.vp = mat4_to_array(cam_lp * cam_lv);
-                         }
+                     if (wls->light_debug.enable_light_cam)
+                     {
+                         // Set debug lighting options on
+                         rls->debug_enabled = false;
+                         rls->cam.v = mat4_to_array(cam_lv);
+                         rls->cam.vp = mat4_to_array(cam_lp * cam_lv);
                      }
                  });
         }
@@ -542,6 +730,7 @@ namespace
         {
             world.system<t_rosy_action>("move_rosy")
                  .kind(flecs::OnUpdate)
+                 .write<c_target>()
                  .each([&, this](flecs::iter& it, size_t, t_rosy_action)
                  {
                      // This function moves rosy to where the screen cursor is when the left mouse button is pushed.
@@ -588,16 +777,29 @@ namespace
                      const glm::vec3 intersection = m_x_n + d_v;
                      const float intersection_w = glm::dot(-normal, plucker_v);
 
-                     l->debug(std::format("intersection {:.3f}, {:.3f}, {:.3f}", intersection[0] / intersection_w, intersection[1] / intersection_w, intersection[2] / intersection_w));
+                     if (l->level == rosy_logger::log_level::debug)
+                     {
+                         l->debug(std::format("intersection {:.3f}, {:.3f}, {:.3f}", intersection[0] / intersection_w, intersection[1] / intersection_w, intersection[2] / intersection_w));
+                     }
 
-                     // Set rosy to target that intersection.
+                     // Set rosy to target the static geometry under the cursor, or that intersection when the cursor is over nothing.
                      auto rosy_target = glm::vec3(intersection[0] / intersection_w, intersection[1] / intersection_w, intersection[2] / intersection_w);
+                     if (const std::optional<pick_hit> hit = picker.pick(graph, vec3_to_array(camera_pos), vec3_to_array(world_ray),
+                                                                         std::numeric_limits<float>::infinity(), pick_filter::static_only))
+                     {
+                         if (l->level == rosy_logger::log_level::debug)
+                         {
+                             l->debug(std::format("picked {} surface {} at {:.3f}, {:.3f}, {:.3f}", graph.nodes[hit->node_index].name(), hit->surface_index,
+                                                  hit->position[0], hit->position[1], hit->position[2]));
+                         }
+                         rosy_target = array_to_vec3(hit->position);
+                     }
 
                      // This is all taking place in world space. It used to be in object space and that was incorrect because this is about moving rosy in world space.
                      // Calculate whether the target is within the floor's bounds, if not set any coordinate outside to the max extent of the bounds.
                      const auto floor_index = floor_entity.get<c_static>();
-                     const node* floor_node = get_static()[floor_index->index];
-                     auto world_space_floor_bounds = floor_node->get_world_space_bounds();
+                     const node& floor_node = get_static()[floor_index->index];
+                     auto world_space_floor_bounds = floor_node.get_world_space_bounds();
                      for (int j{0}; j < 3; j++)
                      {
                          if (rosy_target[j] < world_space_floor_bounds.min[j])
@@ -610,7 +812,27 @@ namespace
                          }
                      }
 
+                     // A field is built for every cell the target enters, so while it is dragged around rosy keeps the last field and a new one is
+                     // only built when the button goes down or navigation_field_interval has passed.
                      c_target target{.x = rosy_target.x, .y = rosy_target.y, .z = rosy_target.z};
+                     rosy_field_wait -= it.delta_time();
+                     if (const c_target* previous = rosy_reference.entity.get<c_target>(); previous == nullptr || rosy_field_wait <= 0.f)
+                     {
+                         rosy_field_wait = navigation_field_interval;
+                         if (const auto res = nav.prepare_field(vec3_to_array(rosy_target)); res != result::ok)
+                         {
+                             l->error(std::format("Error preparing a flow field toward rosy's target {}", static_cast<uint8_t>(res)));
+                         }
+                         target.field_x = target.x;
+                         target.field_y = target.y;
+                         target.field_z = target.z;
+                     }
+                     else
+                     {
+                         target.field_x = previous->field_x;
+                         target.field_y = previous->field_y;
+                         target.field_z = previous->field_z;
+                     }
                      rosy_reference.entity.add<c_target>().set<c_target>(target);
 
                      // Draw some debugging UI to display picking performance.
@@ -675,85 +897,161 @@ namespace
                              .flags = 0,
                          };
                      }
-                     // If rosy is targeting orient rosy and move her toward the target.
-                     if (rosy_reference.entity.has<c_target>())
+                 });
+        }
+
+        void init_system_steer_mobs()
+        {
+            // Mobs are steered a flecs table at a time, the table's component columns are contiguous so a batch is gathered with linear reads.
+            simulation_systems.push_back(world.system<const c_mob, const c_target, c_forward>("steer_mobs")
+                 .kind(0)
+                 .run([&, this](flecs::iter& it)
+                 {
+                     const float t = it.delta_time();
+                     while (it.next())
                      {
-                         const std::array<float, 3> node_world_space_position = rosy_reference.node->get_world_space_position();
-                         const auto rosy_pos = glm::vec3(node_world_space_position[0], node_world_space_position[1], node_world_space_position[2]);
-                         constexpr auto game_forward = glm::vec3(0.f, 0.f, 1.f);
-
-                         // Convert rosy target translation to world position if rosy's position was world origin.
-                         // This works because rosy will be at origin in this space and so wherever the target is at an angle for rosy's position.
-                         // This is not rosy's asset-origin space, this just translating world origin to get a world yaw for rosy.
-                         glm::mat4 transform_world_origin_to_rosy_position = glm::translate(glm::mat4(1.f), {-rosy_pos[0], -rosy_pos[1], -rosy_pos[2]});
-                         // Verify that the rosy_space target isn't the null vector, if it is she's already there.
-                         if (glm::vec4 rosy_target_if_rosy_is_world_origin = transform_world_origin_to_rosy_position * glm::vec4(rosy_target, 1.f); rosy_target_if_rosy_is_world_origin != glm::zero<
-                             glm::vec4>())
+                         const flecs::field<const c_mob> mobs = it.field<const c_mob>(0);
+                         const flecs::field<const c_target> targets = it.field<const c_target>(1);
+                         const flecs::field<c_forward> forwards = it.field<c_forward>(2);
+                         const size_t count = it.count();
+                         steering.resize(count);
+                         for (size_t i{0}; i < count; i++)
+                         {
+                             steering.node_indices[i] = mobs[i].node_index;
+                             steering.target_x[i] = targets[i].x;
+                             steering.target_y[i] = targets[i].y;
+                             steering.target_z[i] = targets[i].z;
+                             steering.yaws[i] = forwards[i].yaw;
+                         }
+                         graph.get_world_space_positions(steering.node_indices.data(), count, steering.position_x.data(), steering.position_y.data(),
+                                                         steering.position_z.data());
+                         for (size_t i{0}; i < count; i++)
                          {
-                             // Calculate the difference between rosy's orientation and her target position
-                             const float sign = rosy_target_if_rosy_is_world_origin.x > 0 ? -1.f : 1.f;
-                             // This offset's rosy's orientation based on her orientation around the x-axis.
-                             const float target_game_cos_theta = glm::dot(glm::normalize(glm::vec3(rosy_target_if_rosy_is_world_origin)), game_forward);
-                             // This dot product is used to get the angle of the target with respect to rosy's position.
-                             const float target_yaw = sign * std::acos(target_game_cos_theta);
-
-                             l->debug(std::format(
-                                 "rosy_target: ({:.3f}, {:.3f}, {:.3f}) cosTheta {:.3f}) target_yaw: {:.3f}) sign: {:.3f}",
-                                 rosy_target_if_rosy_is_world_origin[0],
-                                 rosy_target_if_rosy_is_world_origin[1],
-                                 rosy_target_if_rosy_is_world_origin[2],
-                                 target_game_cos_theta,
-                                 target_yaw,
-                                 sign
-                             ));
-
-                             c_forward nf{.yaw = target_yaw};
-                             rosy_reference.entity.add<c_forward>().set<c_forward>(nf);
-
-                             // Linearly interpolate rosy's position toward the target
-                             const float t = 1.f * it.delta_time();
-                             glm::vec3 new_rosy_pos = (rosy_pos * (1.f - t)) + rosy_target * t;
-
-                             // Update rosy's world space orientation and position
-                             rosy_reference.node->set_world_space_translate(vec3_to_array(new_rosy_pos));
-                             // Set rosy's orientation to face target
-                             rosy_reference.node->set_world_space_yaw(target_yaw);
-
-                             game_cam->set_game_cam_position({new_rosy_pos[0], new_rosy_pos[1], new_rosy_pos[2]});
+                             // Mobs with a flow field toward their target head along it instead of straight at the target. The target is moved onto
+                             // the field's direction at the same distance, so the lerp keeps its pace.
+                             const std::array<float, 3> position{steering.position_x[i], steering.position_y[i], steering.position_z[i]};
+                             const std::array<float, 3> target{steering.target_x[i], steering.target_y[i], steering.target_z[i]};
+                             const std::array<float, 3> field_target{targets[i].field_x, targets[i].field_y, targets[i].field_z};
+                             if (const std::optional<std::array<float, 2>> direction = nav.flow_direction(field_target, position))
+                             {
+                                 const float dx = target[0] - position[0];
+                                 const float dz = target[2] - position[2];
+                                 const float distance = std::sqrt(dx * dx + dz * dz);
+                                 steering.target_x[i] = position[0] + (*direction)[0] * distance;
+                                 steering.target_z[i] = position[2] + (*direction)[1] * distance;
+                             }
                          }
+                         steer({
+                             .count = count,
+                             .t = t,
+                             .position_x = steering.position_x.data(),
+                             .position_y = steering.position_y.data(),
+                             .position_z = steering.position_z.data(),
+                             .target_x = steering.target_x.data(),
+                             .target_y = steering.target_y.data(),
+                             .target_z = steering.target_z.data(),
+                             .new_position_x = steering.new_position_x.data(),
+                             .new_position_y = steering.new_position_y.data(),
+                             .new_position_z = steering.new_position_z.data(),
+                             .yaws = steering.yaws.data(),
+                             .moved = steering.moved.data(),
+                         });
+                         graph.set_world_space_translates_and_yaws(steering.node_indices.data(), count, steering.new_position_x.data(),
+                                                                   steering.new_position_y.data(), steering.new_position_z.data(), steering.yaws.data(),
+                                                                   steering.moved.data());
+                         for (size_t i{0}; i < count; i++) forwards[i].yaw = steering.yaws[i];
                      }
-                 });
+                 }));
+        }
+
+        void init_system_resolve_collisions()
+        {
+            // After steering moves mobs.
+            simulation_systems.push_back(world.system("resolve_collisions")
+                 .kind(0)
+                 .run([&, this]([[maybe_unused]] flecs::iter& it)
+                 {
+                     const size_t count = colliding.node_indices.size();
+                     if (count == 0) return;
+                     graph.get_world_space_translates_and_yaws(colliding.node_indices.data(), count, colliding.x.data(), colliding.y.data(), colliding.z.data(),
+                                                               colliding.yaws.data());
+                     collider.resolve(colliding.x.data(), colliding.y.data(), colliding.z.data(), colliding.pushed.data());
+                     for (size_t i{0}; i < count; i++)
+                     {
+                         if (colliding.pushed[i] == 0) continue;
+                         graph.nodes[colliding.node_indices[i]].set_world_space_translate({colliding.x[i], colliding.y[i], colliding.z[i]});
+                     }
+                 }));
         }
 
         void init_systems()
         {
-            init_system_init_level_state();
+            if (system_threads > 1) world.set_threads(static_cast<int32_t>(system_threads));
+            world.measure_system_time(system_time_measured);
+            simulation_systems.clear();
+            init_system_sync_camera();
+            init_system_apply_mob_edit();
+            init_system_read_mob_state();
+            init_system_update_pick_debugging();
+            init_system_compute_light();
             init_system_move_rosy();
+            init_system_steer_mobs();
+            init_system_resolve_collisions();
+        }
+
+        [[nodiscard]] result set_mob_target(const size_t mob_index, const std::array<float, 3>& target)
+        {
+            if (mob_index >= game_nodes.size())
+            {
+                l->error(std::format("Error targeting mob {}, the level has {} mobs", mob_index, game_nodes.size()));
+                return result::invalid_argument;
+            }
+            const c_target t{.x = target[0], .y = target[1], .z = target[2], .field_x = target[0], .field_y = target[1], .field_z = target[2]};
+            game_nodes[mob_index].entity.add<c_target>().set<c_target>(t);
+            if (const auto res = nav.prepare_field(target); res != result::ok)
+            {
+                l->error(std::format("Error preparing a flow field toward mob {}'s target {}", mob_index, static_cast<uint8_t>(res)));
+                return res;
+            }
+            return result::ok;
+        }
+
+        void get_system_times(std::vector<level_system_time>& out) const
+        {
+            out.clear();
+            world.query_builder().with(flecs::System).build().each([&](const flecs::entity e)
+            {
+                // flecs' own systems are scoped under its modules, the level's are at the root.
+                if (e.parent().is_valid()) return;
+                const ecs_system_t* s = ecs_system_get(world, e);
+                if (s == nullptr) return;
+                out.push_back({.name = std::string(e.name().c_str()), .seconds = static_cast<double>(s->time_spent)});
+            });
         }
 
-        [[nodiscard]] std::vector<node*> get_mobs() const
+        [[nodiscard]] std::span<node> get_mobs()
         {
-            if (level_game_node == nullptr) return {};
-            if (level_game_node->children.empty()) return {};
-            for (const node* root_node = level_game_node->children[0]; node* child : root_node->children)
+            const std::span<node> roots = graph.roots();
+            if (roots.empty()) return {};
+            for (const node& child : roots[0].children())
             {
-                if (child->name == "mobs")
+                if (child.name() == "mobs")
                 {
-                    return child->children;
+                    return child.children();
                 }
             }
             return {};
         }
 
-        [[nodiscard]] std::vector<node*> get_static() const
+        [[nodiscard]] std::span<node> get_static()
         {
-            if (level_game_node == nullptr) return {};
-            if (level_game_node->children.empty()) return {};
-            for (const node* root_node = level_game_node->children[0]; node* child : root_node->children)
+            const std::span<node> roots = graph.roots();
+            if (roots.empty()) return {};
+            for (const node& child : roots[0].children())
             {
-                if (child->name == "static")
+                if (child.name() == "static")
                 {
-                    return child->children;
+                    return child.children();
                 }
             }
             return {};
@@ -761,7 +1059,7 @@ namespace
 
         [[nodiscard]] result setup_frame() const
         {
-            rls->go_update.graphic_objects.clear();
+            rls->go_update.dirty_ranges.clear();
             if (rls->target_fps != wls->target_fps)
             {
                 world.set_target_fps(wls->target_fps);
@@ -780,8 +1078,7 @@ namespace
             }
             if (rls->editor_state.new_asset != nullptr)
             {
-                const auto a = static_cast<const rosy_asset::asset*>(rls->editor_state.new_asset);
-                const result res = set_asset(*a);
+                const result res = set_asset(*rls->editor_state.new_asset, rls->editor_state.new_asset_snapshot);
                 if (res != result::ok)
                 {
                     l->error(std::format("Error setting new asset {}", static_cast<uint8_t>(res)));
@@ -801,9 +1098,58 @@ namespace
                 return res;
             }
             world.progress(static_cast<float>(dt));
+            simulate(dt);
             return result::ok;
         }
 
+        // Runs as many fixed simulation steps as the accumulated frame time covers, so movement does not depend on the frame rate and a
+        // long frame is caught up in steps instead of one large one. Only the state before the last step is kept for interpolation.
+        void simulate(const double dt)
+        {
+            simulation_accumulator += dt;
+            auto steps = static_cast<uint32_t>(simulation_accumulator / simulation_step);
+            simulation_accumulator -= static_cast<double>(steps) * simulation_step;
+            if (steps > max_simulation_steps)
+            {
+                if (l->level == rosy_logger::log_level::debug) l->debug(std::format("dropping {} simulation steps", steps - max_simulation_steps));
+                steps = max_simulation_steps;
+            }
+            for (uint32_t step{0}; step < steps; step++)
+            {
+                if (step + 1 == steps) interpolation.read_previous(graph);
+                for (const flecs::system& s : simulation_systems) s.run(static_cast<float>(simulation_step));
+            }
+            // Read every frame, mob edits move mobs outside of the simulation.
+            interpolation.read_current(graph);
+            interpolation.blend(static_cast<float>(simulation_accumulator / simulation_step));
+            {
+                // The game camera follows where rosy is drawn, including the frame rosy comes to rest.
+                const size_t rosy_index = rosy_reference.index;
+                const bool rosy_moving = rosy_reference.node != nullptr && interpolation.moving[rosy_index] != 0;
+                if (rosy_moving || rosy_was_moving)
+                {
+                    game_cam->set_game_cam_position({interpolation.render_x[rosy_index], interpolation.render_y[rosy_index], interpolation.render_z[rosy_index]});
+                }
+                rosy_was_moving = rosy_moving;
+            }
+        }
+
+        // Moving mobs are drawn at their interpolated state, written over their simulated graphics objects while the graph stays at the
+        // simulated state. A mob that came to rest is written once more, at its simulated state, to replace its last interpolated one.
+        void populate_dynamic()
+        {
+            graph.populate_dynamic(rls->go_update.graphic_objects, rls->go_update.dirty_ranges);
+            const size_t count = interpolation.node_indices.size();
+            for (size_t i{0}; i < count; i++)
+            {
+                interpolation.drawn[i] = interpolation.moving[i] != 0 || interpolation.drawn_moving[i] != 0;
+                interpolation.drawn_moving[i] = interpolation.moving[i];
+            }
+            graph.populate_moved(interpolation.node_indices.data(), count, interpolation.render_x.data(), interpolation.render_y.data(),
+                                 interpolation.render_z.data(), interpolation.render_yaws.data(), interpolation.drawn.data(), rls->go_update.graphic_objects,
+                                 rls->go_update.dirty_ranges);
+        }
+
         [[nodiscard]] result process_sdl_event(const SDL_Event& event)
         {
             if (event.type == SDL_EVENT_KEY_DOWN)
@@ -905,21 +1251,23 @@ namespace
             {
                 if (const auto mbe = reinterpret_cast<const SDL_MouseButtonEvent&>(event); mbe.button == rosy_attention_btn)
                 {
+                    // Rosy only walks toward the cursor while the button is held.
                     rosy_entity.remove<t_rosy_action>();
+                    rosy_entity.remove<c_target>();
                 }
             }
             return result::ok;
         }
 
 
-        result set_asset(const rosy_asset::asset& new_asset)
+        result set_asset(const rosy_asset::asset& new_asset, const scene_snapshot_key& snapshot_key)
         {
             if (const result res = reset_world(); res != result::ok)
             {
                 l->error("error resetting world in set_asset");
                 return res;
             }
-            // Traverse the assets to construct the scene graph and track important game play entities.
+            // Build the scene graph from the level's snapshot or by traversing the asset, then track important game play entities.
             rls->go_update.full_scene.clear();
             const size_t root_scene_index = static_cast<size_t>(new_asset.root_scene);
             if (new_asset.scenes.size() <= root_scene_index)
@@ -928,13 +1276,89 @@ namespace
                 return result::invalid_argument;
             }
 
-            const auto& scene = new_asset.scenes[root_scene_index];
-            if (scene.nodes.empty())
+            if (new_asset.scenes[root_scene_index].nodes.empty())
             {
                 l->error("error scene.nodes.empty()");
                 return result::invalid_argument;
             }
 
+            {
+                // An unchanged level is loaded from the snapshot written the last time it was built, the time either takes is logged to
+                // compare the two.
+                const auto scene_start = std::chrono::system_clock::now();
+                bool snapshot_loaded{false};
+                if (!snapshot_key.path.empty() && snapshot.read(l, snapshot_key.path, snapshot_key.hash) == result::ok)
+                {
+                    if (const result res = load_scene_snapshot(); res == result::ok)
+                    {
+                        snapshot_loaded = true;
+                    }
+                    else
+                    {
+                        l->warn(std::format("error loading scene snapshot {}, rebuilding the scene", static_cast<uint8_t>(res)));
+                        if (const result reset_res = reset_world(); reset_res != result::ok)
+                        {
+                            l->error("error resetting world after a failed snapshot load");
+                            return reset_res;
+                        }
+                        rls->go_update.full_scene.clear();
+                    }
+                }
+                if (!snapshot_loaded)
+                {
+                    if (const result res = build_scene(new_asset); res != result::ok)
+                    {
+                        l->error("error building the scene in set_asset");
+                        return res;
+                    }
+                }
+                const auto scene_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - scene_start);
+                l->info(std::format("{} the scene of {} nodes in {} us", snapshot_loaded ? "loaded" : "built", snapshot.nodes.size(), scene_elapsed.count()));
+                if (!snapshot_loaded && !snapshot_key.path.empty())
+                {
+                    // A missing snapshot only costs the next load a rebuild.
+                    snapshot.level_hash = snapshot_key.hash;
+                    if (const result res = snapshot.write(l, snapshot_key.path); res != result::ok)
+                    {
+                        l->warn(std::format("error writing scene snapshot {}", static_cast<uint8_t>(res)));
+                    }
+                }
+            }
+            {
+                // Print the result of all this if debug logging is on.
+                graph.debug();
+            }
+            {
+                // Every node drawing a mesh can be picked, meshes are read from the graphics objects' surfaces as a snapshot has no asset nodes.
+                if (const auto res = picker.set_meshes(new_asset); res != result::ok)
+                {
+                    l->error("Error building picking meshes in set_asset");
+                    return res;
+                }
+                for (const scene_snapshot_graphics_object& sgo : snapshot.graphics_objects)
+                {
+                    if (sgo.num_surfaces == 0) continue;
+                    const size_t mesh_index = snapshot.surfaces[sgo.first_surface].mesh_index;
+                    if (const auto res = picker.add_instance(sgo.node_index, static_cast<uint32_t>(mesh_index), sgo.is_mob != 0); res != result::ok)
+                    {
+                        l->error("Error adding a picking instance in set_asset");
+                        return res;
+                    }
+                }
+                picker.prepare(graph);
+            }
+            if (const auto res = init_game_nodes(); res != result::ok)
+            {
+                return res;
+            }
+            return init_collision(new_asset);
+        }
+
+        // Traverses the asset to construct the scene graph and the full scene upload, recording both in the snapshot as it goes.
+        [[nodiscard]] result build_scene(const rosy_asset::asset& new_asset)
+        {
+            snapshot.clear();
+            const auto& scene = new_asset.scenes[static_cast<size_t>(new_asset.root_scene)];
             const std::array<float, 16> asset_coordinate_system_transform = new_asset.asset_coordinate_system;
 
             {
@@ -942,45 +1366,50 @@ namespace
                 while (!queue.empty()) queue.pop();
             }
 
-            // Prepopulate the node queue with the root scenes nodes
-            for (const auto& node_index : scene.nodes)
             {
-                const rosy_asset::node new_node = new_asset.nodes[node_index];
-
-                // Game nodes are a game play representation of a graphics object, and can be static or a mob.
-                auto new_game_node = new(std::nothrow) node;
-                if (new_game_node == nullptr)
+                // Size the node graph for every node the traversal below visits, so building it never reallocates.
+                size_t num_nodes{0};
+                size_t num_graphics_objects{0};
+                size_t name_bytes{0};
+                std::stack<size_t> pending;
+                for (const auto& node_index : scene.nodes) pending.push(node_index);
+                while (!pending.empty())
                 {
-                    l->error("initial scene_objects allocation failed");
-                    return result::allocation_failure;
+                    const rosy_asset::node& n = new_asset.nodes[pending.top()];
+                    pending.pop();
+                    num_nodes += 1;
+                    name_bytes += n.name.size();
+                    if (n.mesh_id < new_asset.meshes.size()) num_graphics_objects += 1;
+                    for (const size_t child_index : n.child_nodes) pending.push(child_index);
+                }
+                if (const auto res = graph.reserve(num_nodes, num_graphics_objects, name_bytes); res != result::ok)
+                {
+                    l->error("Error reserving the node graph in set asset");
+                    return res;
                 }
+            }
 
-                // The initial parent transform to populate the scene graph hierarchy is an identity matrix.
-                const std::array<float, 16> identity_m = mat4_to_array(glm::mat4(1.f));
+            // Prepopulate the node queue with the root scenes nodes
+            for (const auto& node_index : scene.nodes)
+            {
+                const rosy_asset::node& new_node = new_asset.nodes[node_index];
 
-                // All nodes must be initialized here and below.
-                if (const auto res = new_game_node->init(l, false, asset_coordinate_system_transform, identity_m, new_node.transform, new_node.world_translate,
-                                                         new_node.world_scale, new_node.world_yaw); res !=
-                    result::ok)
+                // Game nodes are a game play representation of a graphics object, and can be static or a mob.
+                // All nodes are added to the graph here and below, roots first so that the graph is in breadth first order.
+                uint32_t new_game_node_index{0};
+                if (const auto res = graph.add_node(node_graph::no_parent, std::string_view{new_node.name.data(), new_node.name.size()}, false, false,
+                                                    asset_coordinate_system_transform, new_node.transform, new_node.world_translate, new_node.world_scale,
+                                                    new_node.world_yaw, new_game_node_index); res != result::ok)
                 {
                     l->error("initial scene_objects initialization failed");
-                    new_game_node->deinit();
-                    delete new_game_node;
-                    delete new_game_node;
-                    return result::error;
+                    return res;
                 }
-
-                // All nodes have a name.
-                new_game_node->name = std::string(new_node.name.begin(), new_node.name.end());
-
-                // Root nodes are directly owned by the level state.
-                level_game_node->children.push_back(new_game_node);
+                record_snapshot_node(node_graph::no_parent, new_node.name, false, false, asset_coordinate_system_transform, new_node);
 
                 // Populate the node queue.
                 queue.push({
-                    .game_node = new_game_node,
+                    .node_index = new_game_node_index,
                     .asset_node = new_node,
-                    .parent_transform = glm::mat4{1.f},
                     .is_mob = false, // Root nodes are assumed to be static.
                 });
             }
@@ -995,12 +1424,10 @@ namespace
                 // ReSharper disable once CppUseStructuredBinding Visual studio wants to make this a reference, and it shouldn't be.
                 stack_item queue_item = queue.front();
                 queue.pop();
-                assert(queue_item.game_node != nullptr);
+                assert(queue_item.node_index < graph.size());
 
-
-                const glm::mat4 node_object_space_transform = array_to_mat4(queue_item.game_node->get_object_space_transform());
-                const glm::mat4 node_world_space_transform = array_to_mat4(queue_item.game_node->get_world_space_transform());
-                const glm::mat4 to_object_space_transform = array_to_mat4(queue_item.game_node->get_to_object_space_transform());
+                // Handles are only used for the duration of this iteration as adding children may reallocate the handle array.
+                const node game_node = graph.nodes[queue_item.node_index];
 
                 // Set node bounds for bound testing.
                 node_bounds object_space_bounds{};
@@ -1023,11 +1450,9 @@ namespace
 
                     {
                         // Record the assets transforms from the asset
-                        const glm::mat3 normal_transform = glm::transpose(glm::inverse(glm::mat3(node_world_space_transform)));
-
-                        go.transform = mat4_to_array(node_world_space_transform);
-                        go.to_object_space_transform = mat4_to_array(to_object_space_transform);
-                        go.normal_transform = mat3_to_array(normal_transform);
+                        go.transform = game_node.get_world_space_transform();
+                        go.to_object_space_transform = game_node.get_to_object_space_transform();
+                        go.normal_transform = game_node.get_normal_transform();
                     }
 
                     {
@@ -1042,7 +1467,7 @@ namespace
                                 object_space_bounds.min[i] = glm::min(object_space_min_bounds[i], object_space_bounds.min[i]);
                                 object_space_bounds.max[i] = glm::max(object_space_max_bounds[i], object_space_bounds.max[i]);
                             }
-                            queue_item.game_node->set_object_space_bounds(object_space_bounds);
+                            game_node.set_object_space_bounds(object_space_bounds);
                             surface_graphics_data sgd{};
                             sgd.mesh_index = current_mesh_index;
                             // The index written to the surface graphic object is critical for pulling its transforms out of the buffer for rendering.
@@ -1077,9 +1502,20 @@ namespace
                             go_static_index += 1;
                         }
                         // Also track all the graphic objects in a combined bucket.
-                        queue_item.game_node->graphics_objects.push_back(go);
+                        if (const auto res = graph.add_graphics_object(queue_item.node_index, go); res != result::ok)
+                        {
+                            l->error("Error adding graphics object in set asset");
+                            return res;
+                        }
+                        // The transforms and surfaces are filled in from the full scene once the mob offset is known.
+                        snapshot.graphics_objects.push_back({
+                            .node_index = queue_item.node_index,
+                            .is_mob = queue_item.is_mob ? 1u : 0u,
+                            .index = go.index,
+                        });
                     }
                 }
+                snapshot.nodes[queue_item.node_index].object_space_bounds = object_space_bounds;
 
                 // Each node can have an arbitrary number of child nodes.
                 for (const size_t child_index : queue_item.asset_node.child_nodes)
@@ -1087,14 +1523,6 @@ namespace
                     // This is the same node initialization sequence from the root's scenes logic above.
                     const rosy_asset::node new_asset_node = new_asset.nodes[child_index];
 
-                    // Create the pointer
-                    auto new_game_node = new(std::nothrow) node;
-                    if (new_game_node == nullptr)
-                    {
-                        l->error("Error allocating new game node in set asset");
-                        return result::allocation_failure;
-                    }
-
                     std::array<float, 16> node_coordinate_system = asset_coordinate_system_transform;
                     // Check if the node has its own coordinate system (because the nodes in the assets may come from different coordinate systems).
                     for (const float v : new_asset_node.coordinate_system)
@@ -1106,37 +1534,34 @@ namespace
                         }
                     }
 
-                    // Initialize its state
-                    if (const auto res = new_game_node->init(l,
-                                                             new_asset_node.is_world_node,
-                                                             node_coordinate_system,
-                                                             mat4_to_array(node_object_space_transform),
-                                                             new_asset_node.transform,
-                                                             new_asset_node.world_translate,
-                                                             new_asset_node.world_scale,
-                                                             new_asset_node.world_yaw);
+                    // Mobs are a child of "mob" node or are ancestors of the "mob" node's children
+                    const std::string_view new_node_name{new_asset_node.name.data(), new_asset_node.name.size()};
+                    const bool is_mob = queue_item.is_mob || new_node_name == mobs_node_name;
+
+                    // New nodes are recorded as children of their parent to form a scene graph, its object space parent transform is derived from the parent.
+                    uint32_t new_game_node_index{0};
+                    if (const auto res = graph.add_node(queue_item.node_index,
+                                                        new_node_name,
+                                                        is_mob,
+                                                        new_asset_node.is_world_node,
+                                                        node_coordinate_system,
+                                                        new_asset_node.transform,
+                                                        new_asset_node.world_translate,
+                                                        new_asset_node.world_scale,
+                                                        new_asset_node.world_yaw,
+                                                        new_game_node_index);
                         res != result::ok)
                     {
                         l->error("Error initializing new game node in set asset");
-                        new_game_node->deinit();
-                        delete new_game_node;
-                        return result::error;
+                        return res;
                     }
-
-                    // Give it a name
-                    new_game_node->name = std::string(new_asset_node.name.begin(), new_asset_node.name.end());
-
-                    // New nodes are recorded as children of their parent to form a scene graph.
-                    queue_item.game_node->children.push_back(new_game_node);
-
-                    // Mobs are a child of "mob" node or are ancestors of the "mob" node's children
-                    const bool is_mob = queue_item.is_mob || new_game_node->name == mobs_node_name;
+                    record_snapshot_node(queue_item.node_index, new_asset_node.name, is_mob, new_asset_node.is_world_node, node_coordinate_system,
+                                         new_asset_node);
 
                     // Add the node to the node queue to have their meshes and primitives processed.
                     queue.push({
-                        .game_node = new_game_node,
+                        .node_index = new_game_node_index,
                         .asset_node = new_asset_node,
-                        .parent_transform = queue_item.parent_transform * node_object_space_transform,
                         .is_mob = is_mob,
                     });
                 }
@@ -1164,19 +1589,129 @@ namespace
                                                  mob_graphics_objects.end());
             }
             {
-                // Print the result of all this if debug logging is on.
-                level_game_node->debug();
+                // Record the final graphics objects in the snapshot.
+                snapshot.static_objects_offset = static_objects_offset;
+                snapshot.num_dynamic_objects = num_dynamic_objects;
+                for (scene_snapshot_graphics_object& sgo : snapshot.graphics_objects)
+                {
+                    const graphics_object& go = rls->go_update.full_scene[sgo.is_mob != 0 ? static_objects_offset + sgo.index : sgo.index];
+                    sgo.first_surface = snapshot.surfaces.size();
+                    sgo.num_surfaces = go.surface_data.size();
+                    sgo.transform = go.transform;
+                    sgo.to_object_space_transform = go.to_object_space_transform;
+                    sgo.normal_transform = go.normal_transform;
+                    snapshot.surfaces.insert(snapshot.surfaces.end(), go.surface_data.begin(), go.surface_data.end());
+                }
+            }
+            return result::ok;
+        }
+
+        void record_snapshot_node(const uint32_t parent_index, const std::vector<char>& name, const bool is_dynamic, const bool is_world_node,
+                                  const std::array<float, 16>& coordinate_system, const rosy_asset::node& asset_node)
+        {
+            snapshot.nodes.push_back({
+                .parent_index = parent_index,
+                .is_dynamic = is_dynamic ? 1u : 0u,
+                .is_world_node = is_world_node ? 1u : 0u,
+                .name_length = static_cast<uint32_t>(name.size()),
+                .coordinate_system = coordinate_system,
+                .object_space_transform = asset_node.transform,
+                .world_translate = asset_node.world_translate,
+                .world_scale = asset_node.world_scale,
+                .world_yaw = asset_node.world_yaw,
+            });
+            snapshot.names.insert(snapshot.names.end(), name.begin(), name.end());
+        }
+
+        // Recreates the scene graph and the full scene upload from the snapshot without touching the asset.
+        [[nodiscard]] result load_scene_snapshot()
+        {
+            if (const auto res = graph.reserve(snapshot.nodes.size(), snapshot.graphics_objects.size(), snapshot.names.size()); res != result::ok)
+            {
+                l->error("Error reserving the node graph for a scene snapshot");
+                return res;
+            }
+            size_t name_offset{0};
+            for (const scene_snapshot_node& sn : snapshot.nodes)
+            {
+                if (name_offset + sn.name_length > snapshot.names.size()) return result::invalid_state;
+                uint32_t new_index{0};
+                if (const auto res = graph.add_node(sn.parent_index, std::string_view{snapshot.names.data() + name_offset, sn.name_length}, sn.is_dynamic != 0,
+                                                    sn.is_world_node != 0, sn.coordinate_system, sn.object_space_transform, sn.world_translate,
+                                                    sn.world_scale, sn.world_yaw, new_index); res != result::ok)
+                {
+                    l->error("Error adding a scene snapshot node");
+                    return res;
+                }
+                name_offset += sn.name_length;
+                if (!sn.object_space_bounds.empty()) graph.nodes[new_index].set_object_space_bounds(sn.object_space_bounds);
+            }
+
+            std::vector<graphics_object>& full_scene = rls->go_update.full_scene;
+            full_scene.resize(snapshot.graphics_objects.size());
+            for (const scene_snapshot_graphics_object& sgo : snapshot.graphics_objects)
+            {
+                const size_t position = sgo.is_mob != 0 ? snapshot.static_objects_offset + sgo.index : sgo.index;
+                if (position >= full_scene.size() || sgo.first_surface + sgo.num_surfaces > snapshot.surfaces.size()) return result::invalid_state;
+                graphics_object& go = full_scene[position];
+                go.index = sgo.index;
+                go.transform = sgo.transform;
+                go.to_object_space_transform = sgo.to_object_space_transform;
+                go.normal_transform = sgo.normal_transform;
+                const auto first_surface = snapshot.surfaces.begin() + static_cast<std::ptrdiff_t>(sgo.first_surface);
+                go.surface_data.assign(first_surface, first_surface + static_cast<std::ptrdiff_t>(sgo.num_surfaces));
+                if (const auto res = graph.add_graphics_object(sgo.node_index, go); res != result::ok)
+                {
+                    l->error("Error adding a scene snapshot graphics object");
+                    return res;
+                }
+            }
+
+            rls->graphic_objects.static_objects_offset = snapshot.static_objects_offset;
+            static_objects_offset = snapshot.static_objects_offset;
+            num_dynamic_objects = snapshot.num_dynamic_objects;
+            return result::ok;
+        }
+
+        [[nodiscard]] result init_game_nodes()
+        {
+            {
+                // The navigation grid covers the floor, static objects standing on it block the cells under them. Levels without a floor
+                // get no grid and mobs walk straight to their targets.
+                const std::span<node> static_objects = get_static();
+                const auto floor_it = std::ranges::find_if(static_objects, [](const node& n) { return n.name() == "floor"; });
+                if (floor_it != static_objects.end())
+                {
+                    const node_bounds floor_bounds = floor_it->get_subtree_world_space_bounds();
+                    if (const auto res = nav.set_floor(floor_bounds); res != result::ok)
+                    {
+                        l->warn(std::format("Error laying the navigation grid over the floor {}, mobs will walk straight to their targets", static_cast<uint8_t>(res)));
+                    }
+                    else
+                    {
+                        const float floor_top = floor_bounds.max[1];
+                        for (const node& n : static_objects)
+                        {
+                            if (n.index == floor_it->index) continue;
+                            const node_bounds b = n.get_subtree_world_space_bounds();
+                            if (b.empty() || b.max[1] < floor_top + navigation_step_height || b.min[1] > floor_top + navigation_clearance) continue;
+                            nav.set_blocked(b, true);
+                        }
+                        const auto [width, height] = nav.grid_size();
+                        l->info(std::format("navigation grid of {} by {} cells", width, height));
+                    }
+                }
             }
             {
                 // Initialize ECS game nodes
                 {
                     // Track mobs
-                    std::vector<node*> mobs = get_mobs();
+                    const std::span<node> mobs = get_mobs();
                     game_nodes.resize(mobs.size());
                     for (size_t i{0}; i < mobs.size(); i++)
                     {
-                        node* n = mobs[i];
-                        flecs::entity node_entity = world.entity(n->name.c_str());
+                        node* n = &mobs[i];
+                        flecs::entity node_entity = world.entity(n->name().data());
 
                         game_node_reference ref = {
                             .entity = node_entity,
@@ -1185,12 +1720,12 @@ namespace
                         };
                         game_nodes[i] = ref;
 
-                        c_mob m{i};
+                        c_mob m{.index = i, .node_index = n->index};
                         node_entity.add<c_mob>().set(m);
                         c_forward forward{.yaw = 0.f};
                         node_entity.add<c_forward>().set(forward);
 
-                        if (n->name == "rosy")
+                        if (n->name() == "rosy")
                         {
                             rosy_reference = ref;
                             node_entity.add<t_rosy>();
@@ -1198,15 +1733,31 @@ namespace
                         }
                     }
                 }
+                {
+                    // Per frame scratch is sized for every mob now so play does not allocate.
+                    steering.resize(get_mobs().size());
+                    rls->mob_read.mob_states.resize(game_nodes.size());
+                    rls->pick_debugging.circles.reserve(pick_debugging_records_reserved);
+                    rls->debug_objects.reserve(pick_debugging_records_reserved + debug_objects_reserved);
+                }
+                {
+                    // Mobs start at rest, the first simulation step starts a whole step from now.
+                    interpolation.reset(get_mobs());
+                    interpolation.read_previous(graph);
+                    interpolation.read_current(graph);
+                    interpolation.blend(0.f);
+                    simulation_accumulator = 0.0;
+                    rosy_was_moving = false;
+                }
                 {
                     // Track special static objects
-                    std::vector<node*> static_objects = get_static();
+                    const std::span<node> static_objects = get_static();
                     for (size_t i{0}; i < static_objects.size(); i++)
                     {
-                        node* n = static_objects[i];
+                        const node& n = static_objects[i];
                         flecs::entity node_entity = world.entity();
 
-                        if (n->name == "floor")
+                        if (n.name() == "floor")
                         {
                             floor_entity = node_entity;
                             c_static m{i};
@@ -1218,6 +1769,64 @@ namespace
             }
             return result::ok;
         }
+
+        // Static objects other than the floor collide as the convex hulls of their meshes and mobs as capsules over their bounds.
+        [[nodiscard]] result init_collision(const rosy_asset::asset& new_asset)
+        {
+            collider.clear();
+            std::vector<uint8_t> colliding_nodes(graph.size(), 0);
+            {
+                std::vector<const node*> stack;
+                for (const node& n : get_static())
+                {
+                    if (n.name() != "floor") stack.push_back(&n);
+                }
+                while (!stack.empty())
+                {
+                    const node* n = stack.back();
+                    stack.pop_back();
+                    colliding_nodes[n->index] = 1;
+                    for (const node& child : n->children()) stack.push_back(&child);
+                }
+            }
+            std::vector<std::array<float, 3>> points;
+            for (const scene_snapshot_graphics_object& sgo : snapshot.graphics_objects)
+            {
+                if (sgo.is_mob != 0 || sgo.num_surfaces == 0 || colliding_nodes[sgo.node_index] == 0) continue;
+                const size_t mesh_index = snapshot.surfaces[sgo.first_surface].mesh_index;
+                if (mesh_index >= new_asset.meshes.size()) continue;
+                const glm::mat4 m = array_to_mat4(graph.nodes[sgo.node_index].get_world_space_transform());
+                points.clear();
+                for (const rosy_asset::position& p : new_asset.meshes[mesh_index].positions)
+                {
+                    points.push_back(vec3_to_array(glm::vec3(m * glm::vec4(array_to_vec3(p.vertex), 1.f))));
+                }
+                if (const auto res = collider.add_static_hull(points); res != result::ok)
+                {
+                    l->error(std::format("Error adding collision for {}", graph.nodes[sgo.node_index].name()));
+                    return res;
+                }
+            }
+            const std::span<node> mobs = get_mobs();
+            colliding.reset(mobs);
+            for (const node& n : mobs)
+            {
+                const std::array<float, 3> position = n.get_world_space_position();
+                collision_body body{.radius = min_mob_collision_radius, .bottom = navigation_step_height, .top = navigation_step_height};
+                if (const node_bounds b = n.get_subtree_world_space_bounds(); !b.empty())
+                {
+                    body.radius = std::max(min_mob_collision_radius, std::min(b.max[0] - b.min[0], b.max[2] - b.min[2]) * 0.5f);
+                    body.bottom = b.min[1] - position[1] + navigation_step_height;
+                    body.top = std::max(body.bottom, b.max[1] - position[1]);
+                }
+                if (const auto res = collider.add_body(body, position); res != result::ok)
+                {
+                    l->error(std::format("Error adding collision for mob {}", n.name()));
+                    return res;
+                }
+            }
+            return collider.prepare();
+        }
     };
 
     level_state* ls{nullptr};
@@ -1305,11 +1914,48 @@ result level::process()
     ls->rls->go_update.offset = ls->static_objects_offset;
     ls->rls->go_update.graphic_objects.resize(ls->num_dynamic_objects);
 
-    for (const std::vector<node*> mobs = ls->get_mobs(); const node* n : mobs)
+    // Only mobs that moved since the last frame are recomputed and written, their ranges tell the renderer what to upload.
+    ls->populate_dynamic();
+    return result::ok;
+}
+
+bool level::publish(read_level_state& out) const
+{
+    // Moving mobs show up as dirty ranges, the rest is compared with the frame out holds.
+    const bool changed = !rls.go_update.dirty_ranges.empty() || rls.editor_state.new_asset != nullptr || rls.editor_state.load_saved_view ||
+        out.debug_enabled != rls.debug_enabled || out.ui_enabled != rls.ui_enabled || out.cursor_enabled != rls.cursor_enabled || out.cam != rls.cam ||
+        out.light != rls.light || out.light_debug != rls.light_debug || out.draw_config != rls.draw_config || out.fragment_config != rls.fragment_config ||
+        out.debug_objects != rls.debug_objects || out.pick_debugging.space != rls.pick_debugging.space ||
+        out.debug_ui != rls.debug_ui || out.game_camera_yaw != rls.game_camera_yaw;
+    out.target_fps = rls.target_fps;
+    out.debug_enabled = rls.debug_enabled;
+    out.ui_enabled = rls.ui_enabled;
+    out.cursor_enabled = rls.cursor_enabled;
+    out.cam = rls.cam;
+    out.light = rls.light;
+    out.light_debug = rls.light_debug;
+    out.draw_config = rls.draw_config;
+    out.debug_objects = rls.debug_objects;
+    out.fragment_config = rls.fragment_config;
+    out.graphic_objects = rls.graphic_objects;
+    out.mob_read = rls.mob_read;
+    out.pick_debugging = rls.pick_debugging;
+    out.editor_state = rls.editor_state;
+    out.debug_ui = rls.debug_ui;
+    out.game_camera_yaw = rls.game_camera_yaw;
     {
-        n->populate_graph(ls->rls->go_update.graphic_objects);
+        const graphics_object_update& from = rls.go_update;
+        graphics_object_update& to = out.go_update;
+        if (rls.editor_state.new_asset != nullptr) to.full_scene = from.full_scene;
+        to.offset = from.offset;
+        to.dirty_ranges = from.dirty_ranges;
+        to.graphic_objects.resize(from.graphic_objects.size());
+        for (const auto& [first, count] : from.dirty_ranges)
+        {
+            std::copy_n(from.graphic_objects.begin() + static_cast<std::ptrdiff_t>(first), count, to.graphic_objects.begin() + static_cast<std::ptrdiff_t>(first));
+        }
     }
-    return result::ok;
+    return changed;
 }
 
 // ReSharper disable once CppMemberFunctionMayBeStatic
@@ -1317,3 +1963,28 @@ result level::process_sdl_event(const SDL_Event& event)
 {
     return ls->process_sdl_event(event);
 }
+
+// ReSharper disable once CppMemberFunctionMayBeStatic
+result level::set_mob_target(const size_t mob_index, const std::array<float, 3>& target)
+{
+    return ls->set_mob_target(mob_index, target);
+}
+
+// ReSharper disable once CppMemberFunctionMayBeStatic
+size_t level::num_mobs() const
+{
+    return ls->game_nodes.size();
+}
+
+// ReSharper disable once CppMemberFunctionMayBeStatic
+void level::measure_system_time(const bool enabled)
+{
+    ls->system_time_measured = enabled;
+    ls->world.measure_system_time(enabled);
+}
+
+// ReSharper disable once CppMemberFunctionMayBeStatic
+void level::get_system_times(std::vector<level_system_time>& out) const
+{
+    ls->get_system_times(out);
+}
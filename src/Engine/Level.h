@@ -5,6 +5,13 @@
 
 namespace rosy
 {
+    // A level system and the time flecs measured it running for since system timing was turned on or the level last loaded.
+    struct level_system_time
+    {
+        std::string name{};
+        double seconds{0.0};
+    };
+
     struct level
     {
         read_level_state rls{};
@@ -15,6 +22,17 @@ namespace rosy
         result setup_frame();
         result update(const uint32_t viewport_width, const uint32_t viewport_height, double dt);
         result process();
+        // Copies everything the renderer reads from rls into out, reusing out's memory. Only the dynamic graphics objects in the
+        // dirty ranges are copied and the full scene only when a new asset is set, out must be handed every frame to stay whole.
+        // Returns whether anything the renderer draws or the debug UI shows differs from what out held.
+        bool publish(read_level_state& out) const;
         result process_sdl_event(const SDL_Event& event);
+        // Sends a mob toward a world space target the way clicking the floor sends rosy, for driving a level without input.
+        result set_mob_target(size_t mob_index, const std::array<float, 3>& target);
+        [[nodiscard]] size_t num_mobs() const;
+        // Timing every system costs a clock read per system run, it is off unless turned on here.
+        void measure_system_time(bool enabled);
+        // Every level system in declaration order, reusing out's memory.
+        void get_system_times(std::vector<level_system_time>& out) const;
     };
 }
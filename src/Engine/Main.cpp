@@ -3,10 +3,37 @@
 
 using namespace rosy;
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+// Usage: Rosy.exe [--record <file>] [--replay <file>] [level json or .rsy]
+// --record saves the input the level is given to the file on exit, --replay plays a recording back in place of the window's input
+// and exits once it has run out, logging the frame timings it replayed with.
+int main(const int argc, char* argv[])
 {
+    config cfg{};
+    for (int i{1}; i < argc; i++)
+    {
+        const std::string_view arg{argv[i]};
+        if ((arg == "--record" || arg == "--replay") && i + 1 < argc)
+        {
+            (arg == "--record" ? cfg.input_record_path : cfg.input_replay_path) = argv[++i];
+        }
+        else if (!arg.starts_with("--"))
+        {
+            cfg.level_path = arg;
+        }
+        else
+        {
+            std::cout << "usage: Rosy.exe [--record <file>] [--replay <file>] [level json or .rsy]\n";
+            return 1;
+        }
+    }
+    if (!cfg.input_record_path.empty() && !cfg.input_replay_path.empty())
+    {
+        std::cout << "a session can be recorded or replayed, not both\n";
+        return 1;
+    }
+
     engine engine{};
-    if (const result res = engine.init(); res != result::ok)
+    if (const result res = engine.init(cfg); res != result::ok)
     {
         engine.deinit();
         return 1;
@@ -1,5 +1,7 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 namespace rosy
 {
@@ -8,4 +10,12 @@ namespace rosy
     {
         return std::abs(a - b) <= epsilon;
     }
+
+    // The value p of the way through values sorted in ascending order, 0 when there are none.
+    template <typename T>
+    T percentile(const std::vector<T>& sorted, const double p) requires std::is_floating_point_v<T>
+    {
+        if (sorted.empty()) return T(0);
+        return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+    }
 }
@@ -0,0 +1,455 @@
+#include "pch.h"
+#include "Navigation.h"
+#include <cmath>
+
+using namespace rosy;
+
+namespace
+{
+    constexpr uint32_t unreachable{UINT32_MAX};
+    constexpr uint32_t no_cell{UINT32_MAX};
+    constexpr uint8_t no_direction{8};
+
+    // Costs are in tenths of a cell so a diagonal step is close to its true length without floating point.
+    constexpr uint32_t straight_cost{10};
+    constexpr uint32_t diagonal_cost{14};
+
+    // The eight neighbors, the straight ones first. Opposite directions map a step from one cell to the step back.
+    constexpr std::array<int32_t, 8> neighbor_x{1, -1, 0, 0, 1, 1, -1, -1};
+    constexpr std::array<int32_t, 8> neighbor_z{0, 0, 1, -1, 1, -1, 1, -1};
+    constexpr std::array<uint8_t, 8> opposite_direction{1, 0, 3, 2, 7, 6, 5, 4};
+    constexpr float diagonal_component{0.70710678f};
+    constexpr std::array<std::array<float, 2>, 8> neighbor_directions{
+        {
+            {1.f, 0.f},
+            {-1.f, 0.f},
+            {0.f, 1.f},
+            {0.f, -1.f},
+            {diagonal_component, diagonal_component},
+            {diagonal_component, -diagonal_component},
+            {-diagonal_component, diagonal_component},
+            {-diagonal_component, -diagonal_component},
+        }
+    };
+
+    struct flow_field
+    {
+        uint32_t target_cell{no_cell};
+        uint64_t last_prepared{0};
+        std::vector<uint32_t> distances; // path cost to the target from every cell
+        std::vector<uint8_t> directions; // the step toward the target from every cell, no_direction at the target and unreachable cells
+    };
+
+    struct open_cell
+    {
+        uint32_t distance{0};
+        uint32_t cell{0};
+
+        [[nodiscard]] bool operator>(const open_cell& other) const
+        {
+            return distance > other.distance;
+        }
+    };
+}
+
+struct navigation_state
+{
+    float cell_size{1.f};
+    float inverse_cell_size{1.f};
+    std::array<float, 2> origin{0.f, 0.f}; // xz of the lower corner of cell 0
+    uint32_t width{0};
+    uint32_t height{0};
+    // Number of blocking footprints covering each cell, so clearing one object does not clear cells another still covers.
+    std::vector<uint16_t> blockers;
+    std::vector<flow_field> fields;
+    uint64_t prepare_count{0};
+
+    // Scratch kept to reuse its memory between builds and repairs. The open cells are a binary min heap holding each cell at most
+    // once, open_positions has every cell's index in it or no_cell, so the heap never holds more than the grid's cells.
+    std::vector<open_cell> open;
+    std::vector<uint32_t> open_positions;
+    std::vector<uint32_t> newly_blocked;
+    std::vector<uint32_t> newly_cleared;
+    std::vector<uint32_t> invalidated;
+
+    [[nodiscard]] uint32_t cell_at(const float x, const float z) const
+    {
+        const float fx = std::floor((x - origin[0]) * inverse_cell_size);
+        const float fz = std::floor((z - origin[1]) * inverse_cell_size);
+        if (!(fx >= 0.f && fz >= 0.f && fx < static_cast<float>(width) && fz < static_cast<float>(height))) return no_cell;
+        return static_cast<uint32_t>(fz) * width + static_cast<uint32_t>(fx);
+    }
+
+    [[nodiscard]] uint32_t neighbor(const uint32_t cell, const uint8_t direction) const
+    {
+        const int64_t x = static_cast<int64_t>(cell % width) + neighbor_x[direction];
+        const int64_t z = static_cast<int64_t>(cell / width) + neighbor_z[direction];
+        if (x < 0 || z < 0 || x >= width || z >= height) return no_cell;
+        return static_cast<uint32_t>(z * width + x);
+    }
+
+    [[nodiscard]] bool blocked(const uint32_t cell) const
+    {
+        return blockers[cell] > 0;
+    }
+
+    // Whether a mob in the cell may step in the direction, into a walkable cell and without cutting a blocked corner.
+    [[nodiscard]] bool can_step(const uint32_t cell, const uint8_t direction) const
+    {
+        const uint32_t next = neighbor(cell, direction);
+        if (next == no_cell || blocked(next)) return false;
+        if (direction < 4) return true;
+        const uint32_t beside_x = next - static_cast<uint32_t>(neighbor_z[direction] * static_cast<int32_t>(width));
+        const uint32_t beside_z = static_cast<uint32_t>(static_cast<int64_t>(cell) + neighbor_z[direction] * static_cast<int64_t>(width));
+        return !blocked(beside_x) && !blocked(beside_z);
+    }
+
+    [[nodiscard]] static uint32_t step_cost(const uint8_t direction)
+    {
+        return direction < 4 ? straight_cost : diagonal_cost;
+    }
+
+    void place_open(const size_t position, const open_cell oc)
+    {
+        open[position] = oc;
+        open_positions[oc.cell] = static_cast<uint32_t>(position);
+    }
+
+    void sift_up(size_t position)
+    {
+        const open_cell oc = open[position];
+        while (position > 0)
+        {
+            const size_t parent = (position - 1) / 2;
+            if (!(open[parent] > oc)) break;
+            place_open(position, open[parent]);
+            position = parent;
+        }
+        place_open(position, oc);
+    }
+
+    void sift_down(size_t position)
+    {
+        const open_cell oc = open[position];
+        while (true)
+        {
+            size_t child = position * 2 + 1;
+            if (child >= open.size()) break;
+            if (child + 1 < open.size() && open[child] > open[child + 1]) child += 1;
+            if (!(oc > open[child])) break;
+            place_open(position, open[child]);
+            position = child;
+        }
+        place_open(position, oc);
+    }
+
+    // A cell already open only ever has its distance lowered, distances are never raised while a cell is open.
+    void push_open(const uint32_t distance, const uint32_t cell)
+    {
+        if (const uint32_t position = open_positions[cell]; position != no_cell)
+        {
+            if (distance >= open[position].distance) return;
+            open[position].distance = distance;
+            sift_up(position);
+            return;
+        }
+        open.push_back({.distance = distance, .cell = cell});
+        sift_up(open.size() - 1);
+    }
+
+    [[nodiscard]] open_cell pop_open()
+    {
+        const open_cell top = open.front();
+        open_positions[top.cell] = no_cell;
+        const open_cell last = open.back();
+        open.pop_back();
+        if (!open.empty())
+        {
+            open[0] = last;
+            sift_down(0);
+        }
+        return top;
+    }
+
+    // Dijkstra outward from the open cells. A cell is only improved, never made worse, so repairs seed the cells that changed and
+    // everything downstream of them settles here.
+    void propagate(flow_field& f)
+    {
+        while (!open.empty())
+        {
+            const auto [distance, cell] = pop_open();
+            for (uint8_t direction{0}; direction < 8; direction++)
+            {
+                // The neighbor reaches this cell by stepping back the opposite way.
+                const uint32_t from = neighbor(cell, direction);
+                if (from == no_cell || blocked(from)) continue;
+                const uint8_t back = opposite_direction[direction];
+                if (!can_step(from, back) && neighbor(from, back) != f.target_cell) continue;
+                if (const uint32_t new_distance = distance + step_cost(direction); new_distance < f.distances[from])
+                {
+                    f.distances[from] = new_distance;
+                    f.directions[from] = back;
+                    push_open(new_distance, from);
+                }
+            }
+        }
+    }
+
+    void build(flow_field& f)
+    {
+        const size_t num_cells = static_cast<size_t>(width) * height;
+        f.distances.assign(num_cells, unreachable);
+        f.directions.assign(num_cells, no_direction);
+        f.distances[f.target_cell] = 0;
+        push_open(0, f.target_cell);
+        propagate(f);
+    }
+
+    // Seeds a cell that lost its path, or was just cleared, with the best step to a neighbor that still has one.
+    void seed_from_neighbors(flow_field& f, const uint32_t cell)
+    {
+        if (cell == f.target_cell || blocked(cell)) return;
+        uint32_t best{unreachable};
+        uint8_t best_direction{no_direction};
+        for (uint8_t direction{0}; direction < 8; direction++)
+        {
+            const uint32_t next = neighbor(cell, direction);
+            if (next == no_cell || f.distances[next] == unreachable) continue;
+            if (!can_step(cell, direction) && next != f.target_cell) continue;
+            if (const uint32_t d = f.distances[next] + step_cost(direction); d < best)
+            {
+                best = d;
+                best_direction = direction;
+            }
+        }
+        if (best == unreachable) return;
+        f.distances[cell] = best;
+        f.directions[cell] = best_direction;
+        push_open(best, cell);
+    }
+
+    void invalidate(flow_field& f, const uint32_t cell)
+    {
+        if (cell == f.target_cell || f.distances[cell] == unreachable) return;
+        f.distances[cell] = unreachable;
+        f.directions[cell] = no_direction;
+        invalidated.push_back(cell);
+    }
+
+    // Cells whose path is unaffected keep their distance, they were already shortest and blocking cells only makes paths longer.
+    // Cells whose path ran through a newly blocked cell or cut its corner are cleared along with everything upstream of them and
+    // refilled from the cells around them, cleared cells are filled from their neighbors and their shorter paths spread from there.
+    void repair(flow_field& f)
+    {
+        invalidated.clear();
+        for (const uint32_t cell : newly_blocked)
+        {
+            invalidate(f, cell);
+            for (uint8_t direction{0}; direction < 8; direction++)
+            {
+                const uint32_t n = neighbor(cell, direction);
+                if (n == no_cell || f.directions[n] == no_direction) continue;
+                if (!can_step(n, f.directions[n]) && neighbor(n, f.directions[n]) != f.target_cell) invalidate(f, n);
+            }
+        }
+        for (size_t i{0}; i < invalidated.size(); i++)
+        {
+            const uint32_t cell = invalidated[i];
+            for (uint8_t direction{0}; direction < 8; direction++)
+            {
+                const uint32_t upstream = neighbor(cell, direction);
+                if (upstream == no_cell || f.directions[upstream] != opposite_direction[direction]) continue;
+                invalidate(f, upstream);
+            }
+        }
+        for (const uint32_t cell : invalidated) seed_from_neighbors(f, cell);
+        for (const uint32_t cell : newly_cleared)
+        {
+            seed_from_neighbors(f, cell);
+            // A cleared cell can also open diagonal steps between its neighbors, they are revisited with their current distance.
+            for (uint8_t direction{0}; direction < 8; direction++)
+            {
+                if (const uint32_t n = neighbor(cell, direction); n != no_cell && f.distances[n] != unreachable) push_open(f.distances[n], n);
+            }
+        }
+        propagate(f);
+    }
+
+    [[nodiscard]] const flow_field* find_field(const uint32_t target_cell) const
+    {
+        for (const flow_field& f : fields)
+        {
+            if (f.target_cell == target_cell) return &f;
+        }
+        return nullptr;
+    }
+};
+
+result navigation::init(const std::shared_ptr<rosy_logger::log>& new_log, const float new_cell_size)
+{
+    l = new_log;
+    if (new_cell_size <= 0.f)
+    {
+        l->error(std::format("invalid navigation cell size {}", new_cell_size));
+        return result::invalid_argument;
+    }
+    if (ns = new(std::nothrow) navigation_state; ns == nullptr)
+    {
+        l->error("Error allocating navigation state");
+        return result::allocation_failure;
+    }
+    ns->cell_size = new_cell_size;
+    ns->inverse_cell_size = 1.f / new_cell_size;
+    return result::ok;
+}
+
+void navigation::deinit()
+{
+    delete ns;
+    ns = nullptr;
+}
+
+void navigation::clear() const
+{
+    ns->width = 0;
+    ns->height = 0;
+    ns->blockers.clear();
+    ns->open_positions.clear();
+    // Keep the fields' memory for the next level.
+    for (flow_field& f : ns->fields) f.target_cell = no_cell;
+}
+
+result navigation::set_floor(const node_bounds& floor_bounds) const
+{
+    clear();
+    if (floor_bounds.empty()) return result::ok;
+    if (!std::isfinite(floor_bounds.min[0]) || !std::isfinite(floor_bounds.min[2]) || !std::isfinite(floor_bounds.max[0]) || !std::isfinite(floor_bounds.max[2]))
+    {
+        l->error("navigation cannot lay a grid over non finite floor bounds");
+        return result::invalid_argument;
+    }
+    const float cells_x = std::ceil((floor_bounds.max[0] - floor_bounds.min[0]) * ns->inverse_cell_size);
+    const float cells_z = std::ceil((floor_bounds.max[2] - floor_bounds.min[2]) * ns->inverse_cell_size);
+    if (cells_x > static_cast<float>(max_grid_size) || cells_z > static_cast<float>(max_grid_size))
+    {
+        l->error(std::format("navigation grid of {} by {} cells is larger than {} cells a side", cells_x, cells_z, max_grid_size));
+        return result::overflow;
+    }
+    ns->origin = {floor_bounds.min[0], floor_bounds.min[2]};
+    ns->width = std::max(1u, static_cast<uint32_t>(cells_x));
+    ns->height = std::max(1u, static_cast<uint32_t>(cells_z));
+    const size_t num_cells = static_cast<size_t>(ns->width) * ns->height;
+    ns->blockers.assign(num_cells, 0);
+    // Every field's memory is taken now, so picking a new target while the game runs never allocates. Large grids cache fewer fields
+    // to stay within the budget, and memory a larger previous floor took is given back.
+    const size_t field_bytes = num_cells * (sizeof(uint32_t) + sizeof(uint8_t));
+    const size_t num_fields = std::clamp(field_cache_budget / field_bytes, static_cast<size_t>(1), max_cached_fields);
+    ns->fields.resize(num_fields);
+    for (flow_field& f : ns->fields)
+    {
+        f.target_cell = no_cell;
+        f.distances.resize(num_cells);
+        f.distances.shrink_to_fit();
+        f.directions.resize(num_cells);
+        f.directions.shrink_to_fit();
+    }
+    ns->open_positions.assign(num_cells, no_cell);
+    ns->open_positions.shrink_to_fit();
+    ns->open.reserve(num_cells);
+    if (l->level == rosy_logger::log_level::debug)
+    {
+        l->debug(std::format("navigation grid of {} by {} cells caches {} fields in {} bytes", ns->width, ns->height, num_fields, num_fields * field_bytes));
+    }
+    return result::ok;
+}
+
+void navigation::set_blocked(const node_bounds& bounds, const bool blocked) const
+{
+    if (bounds.empty() || ns->width == 0) return;
+    const auto lower_x = static_cast<int64_t>(std::floor((bounds.min[0] - ns->origin[0]) * ns->inverse_cell_size));
+    const auto lower_z = static_cast<int64_t>(std::floor((bounds.min[2] - ns->origin[1]) * ns->inverse_cell_size));
+    const auto upper_x = static_cast<int64_t>(std::floor((bounds.max[0] - ns->origin[0]) * ns->inverse_cell_size));
+    const auto upper_z = static_cast<int64_t>(std::floor((bounds.max[2] - ns->origin[1]) * ns->inverse_cell_size));
+
+    ns->newly_blocked.clear();
+    ns->newly_cleared.clear();
+    for (int64_t z{std::max(lower_z, int64_t{0})}; z <= std::min(upper_z, static_cast<int64_t>(ns->height) - 1); z++)
+    {
+        for (int64_t x{std::max(lower_x, int64_t{0})}; x <= std::min(upper_x, static_cast<int64_t>(ns->width) - 1); x++)
+        {
+            const auto cell = static_cast<uint32_t>(z * ns->width + x);
+            uint16_t& count = ns->blockers[cell];
+            if (blocked)
+            {
+                if (count == UINT16_MAX) continue;
+                if (count == 0) ns->newly_blocked.push_back(cell);
+                count += 1;
+                continue;
+            }
+            if (count == 0) continue;
+            count -= 1;
+            if (count == 0) ns->newly_cleared.push_back(cell);
+        }
+    }
+    if (ns->newly_blocked.empty() && ns->newly_cleared.empty()) return;
+    for (flow_field& f : ns->fields)
+    {
+        if (f.target_cell != no_cell) ns->repair(f);
+    }
+}
+
+result navigation::prepare_field(const std::array<float, 3>& target) const
+{
+    const uint32_t target_cell = ns->cell_at(target[0], target[2]);
+    if (target_cell == no_cell) return result::ok;
+    ns->prepare_count += 1;
+    for (flow_field& f : ns->fields)
+    {
+        if (f.target_cell != target_cell) continue;
+        f.last_prepared = ns->prepare_count;
+        return result::ok;
+    }
+
+    flow_field* slot{nullptr};
+    for (flow_field& f : ns->fields)
+    {
+        if (f.target_cell == no_cell)
+        {
+            slot = &f;
+            break;
+        }
+    }
+    if (slot == nullptr) slot = &*std::ranges::min_element(ns->fields, {}, &flow_field::last_prepared);
+    slot->target_cell = target_cell;
+    slot->last_prepared = ns->prepare_count;
+    ns->build(*slot);
+    return result::ok;
+}
+
+std::optional<std::array<float, 2>> navigation::flow_direction(const std::array<float, 3>& target, const std::array<float, 3>& position) const
+{
+    if (ns->width == 0) return std::nullopt;
+    const uint32_t target_cell = ns->cell_at(target[0], target[2]);
+    const uint32_t cell = ns->cell_at(position[0], position[2]);
+    if (target_cell == no_cell || cell == no_cell || cell == target_cell) return std::nullopt;
+    const flow_field* f = ns->find_field(target_cell);
+    if (f == nullptr) return std::nullopt;
+    const uint8_t direction = f->directions[cell];
+    if (direction == no_direction) return std::nullopt;
+    return neighbor_directions[direction];
+}
+
+std::array<uint32_t, 2> navigation::grid_size() const
+{
+    return {ns->width, ns->height};
+}
+
+size_t navigation::num_cached_fields() const
+{
+    size_t n{0};
+    for (const flow_field& f : ns->fields)
+    {
+        if (f.target_cell != no_cell) n += 1;
+    }
+    return n;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Types.h"
+#include "Node.h"
+#include "Logger/Logger.h"
+
+struct navigation_state;
+
+namespace rosy
+{
+    // Flow field navigation over the floor. Walkable space is a grid of square cells laid over the floor's xz bounds, cells under
+    // static objects are blocked. A flow field toward a target is built once with a Dijkstra pass outward from the target's cell and
+    // leaves every reachable cell pointing at the neighbor it should move to next, so any number of mobs heading to the same target
+    // share one field and each pays only a lookup. Fields are cached by target cell, the least recently prepared is replaced when the
+    // cache is full. Blocking or clearing cells repairs every cached field in place, only cells whose path changed are revisited.
+    // Diagonal moves are only allowed when both cells beside them are walkable, so paths never cut a blocked cell's corner.
+    // Lookups are const and may run concurrently with each other, everything else may not run concurrently with anything.
+    struct navigation
+    {
+        static constexpr size_t max_cached_fields{8};
+        // Fields take 5 bytes a cell, a floor with more than 838'860 cells caches fewer than max_cached_fields and at least one.
+        static constexpr size_t field_cache_budget{32 * 1'024 * 1'024};
+        static constexpr uint32_t max_grid_size{2'048}; // cells along either side
+
+        std::shared_ptr<rosy_logger::log> l{nullptr};
+        navigation_state* ns{nullptr};
+
+        [[nodiscard]] result init(const std::shared_ptr<rosy_logger::log>& new_log, float new_cell_size);
+        void deinit();
+        // Forgets the grid and every field.
+        void clear() const;
+
+        // Lays a grid of walkable cells over the floor's xz bounds and forgets every field, memory for as many fields as the grid's size
+        // and field_cache_budget allow is taken here.
+        [[nodiscard]] result set_floor(const node_bounds& floor_bounds) const;
+        // Blocks or clears every cell the bounds' xz footprint overlaps and repairs the cached fields.
+        void set_blocked(const node_bounds& bounds, bool blocked) const;
+
+        // Builds the field toward the target's cell unless it is cached, call when a mob is given a new target.
+        [[nodiscard]] result prepare_field(const std::array<float, 3>& target) const;
+        // The normalized xz direction to move from the position toward the target, or nothing when there is no prepared field for the
+        // target, the position is off the grid or blocked, the target cannot be reached or the position is already in the target's cell.
+        // Callers move straight toward the target then.
+        [[nodiscard]] std::optional<std::array<float, 2>> flow_direction(const std::array<float, 3>& target, const std::array<float, 3>& position) const;
+
+        [[nodiscard]] std::array<uint32_t, 2> grid_size() const;
+        [[nodiscard]] size_t num_cached_fields() const;
+    };
+}
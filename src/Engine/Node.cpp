@@ -1,10 +1,10 @@
 #include "pch.h"
 #include "Node.h"
-#define GLM_ENABLE_EXPERIMENTAL
+#include "Arena.h"
+#include "Transforms.h"
+#include "WorkerPool.h"
 #include <glm/glm.hpp>
-#include <glm/ext/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.inl>
-#include <glm/gtx/quaternion.hpp>
 
 using namespace rosy;
 
@@ -23,18 +23,6 @@ namespace
         return a;
     }
 
-    std::array<float, 9> mat3_to_array(glm::mat3 m)
-    {
-        std::array<float, 9> a{
-            1.f, 0.f, 0.f,
-            0.f, 1.f, 0.f,
-            0.f, 0.f, 1.f,
-        };
-        const auto pos_r = glm::value_ptr(m);
-        for (size_t i{ 0 }; i < 9; i++) a[i] = pos_r[i];
-        return a;
-    }
-
     glm::mat4 array_to_mat4(const std::array<float, 16>& a)
     {
         glm::mat4 m{};
@@ -58,201 +46,755 @@ namespace
         for (uint64_t i{0}; i < 3; i++) pos_r[i] = a[i];
         return v;
     }
+
+    // The rotation the transform kernels compose a yaw into, about -Y.
+    glm::mat4 yaw_rotation(const float yaw)
+    {
+        const float c = std::cos(yaw);
+        const float s = std::sin(yaw);
+        glm::mat4 m{1.f};
+        m[0][0] = c;
+        m[0][2] = s;
+        m[2][0] = -s;
+        m[2][2] = c;
+        return m;
+    }
+
+    // Extends the last range when the graphics object follows it, so objects written in order produce merged ranges.
+    void append_dirty_range(std::vector<graphics_object_range>& dirty_ranges, const size_t go_index)
+    {
+        if (!dirty_ranges.empty() && dirty_ranges.back().first + dirty_ranges.back().count == go_index)
+        {
+            dirty_ranges.back().count += 1;
+            return;
+        }
+        dirty_ranges.push_back({.first = go_index, .count = 1});
+    }
+
+    // The transform kernels read the per node arrays as tightly packed floats.
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+    static_assert(sizeof(glm::mat4) == 16 * sizeof(float));
+    static_assert(sizeof(std::array<float, 9>) == 9 * sizeof(float));
+    static_assert(sizeof(node_bounds) == 6 * sizeof(float));
+
+    float* floats(arena_array<glm::mat4>& a)
+    {
+        return glm::value_ptr(a.front());
+    }
+
+    // Below this many nodes the cost of waking the workers outweighs the work, so it runs on the calling thread.
+    constexpr size_t parallel_node_threshold{4096};
+    constexpr size_t parallel_chunk_size{1024};
 }
 
-struct node_state
+// Every per node array is indexed by the node's index in the graph. All of them live in the graph's arena, sized once by
+// node_graph::reserve, so building a level never reallocates and clearing it releases everything at once.
+struct node_graph_state
 {
-    std::shared_ptr<rosy_logger::log> l{nullptr};
-    bool is_world_node{false};
-    glm::mat4 object_to_world_transform{};
-    glm::mat4 object_space_parent_transform{};
-    glm::mat4 object_space_transform{};
-    glm::vec3 world_space_translate{};
-    node_bounds object_space_bounds{};
-    float world_space_scale{1.f};
-    float world_space_yaw{0.f};
+    arena memory;
+    const worker_pool* pool{nullptr};
+    arena_array<node> handles;
+
+    // Hierarchy
+    arena_array<uint32_t> parents;
+    arena_array<uint32_t> first_children;
+    arena_array<uint32_t> child_counts;
+    arena_array<uint32_t> name_offsets;
+    arena_array<uint32_t> name_lengths;
+    arena_array<char> name_chars; // every name is followed by a null terminator
+    arena_array<uint8_t> world_node_flags;
+    arena_array<uint8_t> dynamic_flags;
+
+    // Local TRS in world space and the object space transforms from the asset
+    arena_array<glm::vec3> world_space_translates;
+    arena_array<float> world_space_scales;
+    arena_array<float> world_space_yaws;
+    arena_array<glm::mat4> object_to_world_transforms;
+    arena_array<glm::mat4> object_space_transforms;
+
+    // Derived by update_world_transforms
+    arena_array<glm::mat4> object_space_parent_transforms;
+    arena_array<glm::mat4> object_spaces; // object space parent transform * object space transform
+    arena_array<glm::mat4> world_transforms;
+    arena_array<glm::mat4> to_object_space_transforms;
+    arena_array<std::array<float, 9>> normal_transforms;
+
+    arena_array<node_bounds> object_space_bounds;
+    arena_array<node_bounds> world_bounds;
+    arena_array<node_sphere> world_spheres;
+    arena_array<node_bounds> subtree_bounds; // world bounds merged with every descendant's, updated lazily
 
-    void init(
-        const std::shared_ptr<rosy_logger::log>& new_log,
-        const bool new_is_world_node,
-        const std::array<float, 16>& coordinate_space_transform,
-        const std::array<float, 16>& new_object_space_parent_transform,
-        const std::array<float, 16>& new_object_space_transform,
-        const std::array<float, 3> new_world_space_translate,
-        const float new_world_space_scale,
-        const float new_world_space_yaw
-    )
+    // The graphics object indices of each node are contiguous in graphics_object_indices.
+    arena_array<uint32_t> first_graphics_objects;
+    arena_array<uint32_t> graphics_object_counts;
+    arena_array<uint32_t> graphics_object_indices;
+    arena_array<uint32_t> graphics_object_surface_counts;
+
+    uint32_t last_graphics_object_node{0};
+
+    // Dirty tracking, a node whose world transform must be recomputed has its transform_dirty_flags set and anything before
+    // first_dirty_node is known to be clean. Dynamic nodes recomputed since the last populate_dynamic are queued in pending_graphics_nodes.
+    arena_array<uint8_t> transform_dirty_flags;
+    arena_array<uint8_t> graphics_dirty_flags;
+    arena_array<uint32_t> pending_graphics_nodes;
+    arena_array<uint32_t> recomputed_nodes;
+    size_t first_dirty_node{0};
+    bool transforms_dirty{false};
+    bool subtree_bounds_dirty{false};
+
+    [[nodiscard]] result reserve(const size_t max_nodes, const size_t max_graphics_objects, const size_t max_name_bytes)
     {
-        l = new_log;
-        is_world_node = new_is_world_node;
-        object_to_world_transform = array_to_mat4(coordinate_space_transform);
-        object_space_parent_transform = array_to_mat4(new_object_space_parent_transform);
-        object_space_transform = array_to_mat4(new_object_space_transform);
-        world_space_translate = array_to_vec3(new_world_space_translate);
-        world_space_scale = new_world_space_scale;
-        world_space_yaw = new_world_space_yaw;
+        const std::array results{
+            handles.init(memory, max_nodes),
+            parents.init(memory, max_nodes),
+            first_children.init(memory, max_nodes),
+            child_counts.init(memory, max_nodes),
+            name_offsets.init(memory, max_nodes),
+            name_lengths.init(memory, max_nodes),
+            name_chars.init(memory, max_name_bytes + max_nodes),
+            world_node_flags.init(memory, max_nodes),
+            dynamic_flags.init(memory, max_nodes),
+            world_space_translates.init(memory, max_nodes),
+            world_space_scales.init(memory, max_nodes),
+            world_space_yaws.init(memory, max_nodes),
+            object_to_world_transforms.init(memory, max_nodes),
+            object_space_transforms.init(memory, max_nodes),
+            object_space_parent_transforms.init(memory, max_nodes),
+            object_spaces.init(memory, max_nodes),
+            world_transforms.init(memory, max_nodes),
+            to_object_space_transforms.init(memory, max_nodes),
+            normal_transforms.init(memory, max_nodes),
+            object_space_bounds.init(memory, max_nodes),
+            world_bounds.init(memory, max_nodes),
+            world_spheres.init(memory, max_nodes),
+            subtree_bounds.init(memory, max_nodes),
+            first_graphics_objects.init(memory, max_nodes),
+            graphics_object_counts.init(memory, max_nodes),
+            graphics_object_indices.init(memory, max_graphics_objects),
+            graphics_object_surface_counts.init(memory, max_graphics_objects),
+            transform_dirty_flags.init(memory, max_nodes),
+            graphics_dirty_flags.init(memory, max_nodes),
+            pending_graphics_nodes.init(memory, max_nodes),
+            recomputed_nodes.init(memory, max_nodes),
+        };
+        for (const result res : results) if (res != result::ok) return res;
+        return result::ok;
     }
 
-    [[nodiscard]] glm::mat4 get_world_space_transform() const
+    void clear()
     {
-        const glm::mat4 t = translate(glm::mat4(1.f), world_space_translate);
-        const glm::mat4 r = toMat4(angleAxis(world_space_yaw, glm::vec3{0.f, -1.f, 0.f}));
-        const glm::mat4 s = scale(glm::mat4(1.f), glm::vec3(world_space_scale, world_space_scale, world_space_scale));
+        handles.release();
+        parents.release();
+        first_children.release();
+        child_counts.release();
+        name_offsets.release();
+        name_lengths.release();
+        name_chars.release();
+        world_node_flags.release();
+        dynamic_flags.release();
+        world_space_translates.release();
+        world_space_scales.release();
+        world_space_yaws.release();
+        object_to_world_transforms.release();
+        object_space_transforms.release();
+        object_space_parent_transforms.release();
+        object_spaces.release();
+        world_transforms.release();
+        to_object_space_transforms.release();
+        normal_transforms.release();
+        object_space_bounds.release();
+        world_bounds.release();
+        world_spheres.release();
+        subtree_bounds.release();
+        first_graphics_objects.release();
+        graphics_object_counts.release();
+        graphics_object_indices.release();
+        graphics_object_surface_counts.release();
+        last_graphics_object_node = 0;
+        transform_dirty_flags.release();
+        graphics_dirty_flags.release();
+        pending_graphics_nodes.release();
+        recomputed_nodes.release();
+        first_dirty_node = 0;
+        transforms_dirty = false;
+        subtree_bounds_dirty = false;
+        memory.reset();
+    }
 
-        return t * r * s * object_to_world_transform * object_space_parent_transform * object_space_transform;
+    [[nodiscard]] std::string_view name(const size_t i) const
+    {
+        return {name_chars.data() + name_offsets[i], name_lengths[i]};
     }
 
-    [[nodiscard]] glm::mat4 get_to_object_space_transform() const
+    void mark_dirty(const size_t i)
     {
-        return inverse(get_world_space_transform());
+        transform_dirty_flags[i] = 1;
+        if (!transforms_dirty || i < first_dirty_node) first_dirty_node = i;
+        transforms_dirty = true;
     }
 
-    [[nodiscard]] glm::mat4 get_object_space_transform() const
+    void queue_graphics_update(const size_t i)
     {
-        return object_space_parent_transform * object_space_transform;
+        if (dynamic_flags[i] == 0 || graphics_dirty_flags[i] != 0) return;
+        graphics_dirty_flags[i] = 1;
+        pending_graphics_nodes.push_back(static_cast<uint32_t>(i));
     }
-};
 
-result node::init(
-    const std::shared_ptr<rosy_logger::log>& new_log,
-    const bool is_world_node,
-    const std::array<float, 16>& coordinate_space,
-    const std::array<float, 16>& new_object_space_parent_transform,
-    const std::array<float, 16>& new_object_space_transform,
-    const std::array<float, 3> new_world_translate,
-    const float new_world_scale, const float new_world_yaw)
-{
-    l = new_log;
-    if (ns = new(std::nothrow) node_state; ns == nullptr)
+    // Runs f(begin, end) over [0, count) in chunks on the worker pool once count is large enough. Every node's outputs are
+    // written only by the chunk that holds it, so the results are the same however the chunks are scheduled.
+    template <typename F>
+    void for_each_chunk(const size_t count, F&& f) const
     {
-        l->error("Error allocating node state");
-        return result::allocation_failure;
+        if (pool == nullptr || count < parallel_node_threshold)
+        {
+            f(static_cast<size_t>(0), count);
+            return;
+        }
+        pool->parallel_for(count, parallel_chunk_size, f);
     }
-    ns->init(
-        l,
-        is_world_node,
-        coordinate_space,
-        new_object_space_parent_transform,
-        new_object_space_transform,
-        new_world_translate,
-        new_world_scale,
-        new_world_yaw);
-    return result::ok;
-}
 
-void node::deinit()
-{
-    for (node* n : children)
+    // Composes the object space and world transforms of the given nodes, whose parents must already be up to date.
+    // No node in a batch is the parent of another, so the batch can be split freely.
+    void compose(const uint32_t* indices, const size_t count)
     {
-        n->deinit();
-        delete n;
+        if (count == 0) return;
+        for_each_chunk(count, [&](const size_t begin, const size_t end)
+        {
+            compose_chunk(indices + begin, end - begin);
+        });
+    }
+
+    void compose_chunk(const uint32_t* indices, const size_t count)
+    {
+        get_transform_kernels().compose({
+            .indices = indices,
+            .count = count,
+            .parents = parents.data(),
+            .translates = glm::value_ptr(world_space_translates.front()),
+            .scales = world_space_scales.data(),
+            .yaws = world_space_yaws.data(),
+            .coordinate_systems = floats(object_to_world_transforms),
+            .object_space_transforms = floats(object_space_transforms),
+            .object_space_parent_transforms = floats(object_space_parent_transforms),
+            .object_spaces = floats(object_spaces),
+            .world_transforms = floats(world_transforms),
+        });
     }
-    children.erase(children.begin(), children.end());
-    delete ns;
-    ns = nullptr;
+
+    // The inverse and normal transforms are derived from already composed world transforms.
+    void invert(const uint32_t* indices, const size_t count)
+    {
+        if (count == 0) return;
+        for_each_chunk(count, [&](const size_t begin, const size_t end)
+        {
+            const transform_kernels& kernels = get_transform_kernels();
+            kernels.affine_inverse(indices + begin, end - begin, floats(world_transforms), floats(to_object_space_transforms));
+            kernels.normal_matrix(indices + begin, end - begin, floats(world_transforms), normal_transforms.front().data());
+        });
+    }
+
+    // World bounds are the object space bounds' center and extents run through the world transform, which covers all eight corners.
+    // The sphere is centered the same way with the extents' length scaled by the transform's largest axis scale.
+    void transform_bounds(const uint32_t* indices, const size_t count)
+    {
+        if (count == 0) return;
+        for_each_chunk(count, [&](const size_t begin, const size_t end)
+        {
+            transform_bounds_chunk(indices + begin, end - begin);
+        });
+        subtree_bounds_dirty = true;
+    }
+
+    void transform_bounds_chunk(const uint32_t* indices, const size_t count)
+    {
+        get_transform_kernels().transform_bounds(indices, count, floats(world_transforms), object_space_bounds.front().min.data(), world_bounds.front().min.data());
+        for (size_t k{0}; k < count; k++)
+        {
+            const size_t i = indices[k];
+            const node_bounds& b = object_space_bounds[i];
+            if (b.empty())
+            {
+                world_bounds[i] = {};
+                world_spheres[i] = {};
+                continue;
+            }
+            const glm::mat4& m = world_transforms[i];
+            const glm::vec3 center = glm::vec3{m * glm::vec4{(b.min[0] + b.max[0]) * 0.5f, (b.min[1] + b.max[1]) * 0.5f, (b.min[2] + b.max[2]) * 0.5f, 1.f}};
+            const glm::vec3 extent{(b.max[0] - b.min[0]) * 0.5f, (b.max[1] - b.min[1]) * 0.5f, (b.max[2] - b.min[2]) * 0.5f};
+            const float max_scale = std::max({glm::length(glm::vec3{m[0]}), glm::length(glm::vec3{m[1]}), glm::length(glm::vec3{m[2]})});
+            world_spheres[i] = {.center = {center.x, center.y, center.z}, .radius = glm::length(extent) * max_scale};
+        }
+    }
+
+    // Children come after their parents, so walking the graph backwards merges every child's subtree before its parent's.
+    void update_subtree_bounds()
+    {
+        update_world_transforms();
+        if (!subtree_bounds_dirty) return;
+        for (size_t i{parents.size()}; i > 0; i--)
+        {
+            const size_t n = i - 1;
+            node_bounds b = world_bounds[n];
+            for (size_t c{first_children[n]}; c < first_children[n] + child_counts[n]; c++) b.merge(subtree_bounds[c]);
+            subtree_bounds[n] = b;
+        }
+        subtree_bounds_dirty = false;
+    }
+
+    // Parents precede children so a single forward pass from the first dirty node sees whether a parent was dirty before its
+    // children are visited. Dirty flags are only cleared once the pass is done for that reason. Dirty nodes are composed in batches,
+    // a new batch starting whenever a node's parent could be in the current one.
+    void update_world_transforms()
+    {
+        if (!transforms_dirty) return;
+        const size_t num_nodes = parents.size();
+        recomputed_nodes.clear();
+        size_t batch_start{0};
+        for (size_t i{first_dirty_node}; i < num_nodes; i++)
+        {
+            const uint32_t p = parents[i];
+            if (p != node_graph::no_parent && transform_dirty_flags[p] != 0) transform_dirty_flags[i] = 1;
+            if (transform_dirty_flags[i] == 0) continue;
+
+            if (p != node_graph::no_parent && batch_start < recomputed_nodes.size() && p >= recomputed_nodes[batch_start])
+            {
+                compose(recomputed_nodes.data() + batch_start, recomputed_nodes.size() - batch_start);
+                batch_start = recomputed_nodes.size();
+            }
+            recomputed_nodes.push_back(static_cast<uint32_t>(i));
+        }
+        compose(recomputed_nodes.data() + batch_start, recomputed_nodes.size() - batch_start);
+        invert(recomputed_nodes.data(), recomputed_nodes.size());
+        transform_bounds(recomputed_nodes.data(), recomputed_nodes.size());
+        for (const uint32_t i : recomputed_nodes) queue_graphics_update(i);
+
+        std::fill(transform_dirty_flags.begin() + first_dirty_node, transform_dirty_flags.end(), static_cast<uint8_t>(0));
+        first_dirty_node = 0;
+        transforms_dirty = false;
+    }
+
+    const glm::mat4& world_transform(const size_t i)
+    {
+        update_world_transforms();
+        return world_transforms[i];
+    }
+
+    // Only the transforms are written, the renderer already has every graphics object's surfaces from the full scene upload.
+    // World transforms must be up to date, this runs on worker threads and only touches node i's graphics objects.
+    template <typename T>
+    void write_graphics_objects(const size_t i, std::vector<T>& graph) const
+    {
+        if (graphics_object_counts[i] == 0) return;
+        const std::array<float, 16> go_transform = mat4_to_array(world_transforms[i]);
+        const std::array<float, 16> go_to_object_space_transform = mat4_to_array(to_object_space_transforms[i]);
+        const std::array<float, 9>& go_normal_transform = normal_transforms[i];
+
+        const size_t first = first_graphics_objects[i];
+        for (size_t j{first}; j < first + graphics_object_counts[i]; j++)
+        {
+            const size_t go_index = graphics_object_indices[j];
+            assert(graph.size() > go_index);
+            T& go = graph[go_index];
+            if constexpr (std::is_same_v<T, graphics_object>) go.index = go_index;
+            go.transform = go_transform;
+            go.normal_transform = go_normal_transform;
+            go.to_object_space_transform = go_to_object_space_transform;
+        }
+    }
+};
+
+std::string_view node::name() const
+{
+    return graph->gs->name(index);
+}
+
+std::span<node> node::children() const
+{
+    return {graph->nodes.data() + graph->gs->first_children[index], graph->gs->child_counts[index]};
 }
 
 void node::set_world_space_translate(const std::array<float, 3>& new_world_space_translate) const
 {
-    ns->world_space_translate = array_to_vec3(new_world_space_translate);
+    graph->gs->world_space_translates[index] = array_to_vec3(new_world_space_translate);
+    graph->gs->mark_dirty(index);
 }
 
 void node::set_world_space_scale(const float new_world_space_scale) const
 {
-    ns->world_space_scale = new_world_space_scale;
+    graph->gs->world_space_scales[index] = new_world_space_scale;
+    graph->gs->mark_dirty(index);
 }
 
 void node::set_world_space_yaw(const float new_world_space_yaw) const
 {
-    ns->world_space_yaw = new_world_space_yaw;
+    graph->gs->world_space_yaws[index] = new_world_space_yaw;
+    graph->gs->mark_dirty(index);
 }
 
 void node::set_object_space_bounds(const node_bounds& new_object_space_bounds) const
 {
-    ns->object_space_bounds = new_object_space_bounds;
+    node_graph_state* gs = graph->gs;
+    gs->object_space_bounds[index] = new_object_space_bounds;
+    // Only this node's bounds change, its transform is reused when it is current.
+    gs->update_world_transforms();
+    gs->transform_bounds(&index, 1);
 }
 
 std::array<float, 16> node::get_object_space_transform() const
 {
-    return mat4_to_array(ns->get_object_space_transform());
+    node_graph_state* gs = graph->gs;
+    gs->update_world_transforms();
+    return mat4_to_array(gs->object_spaces[index]);
 }
 
 std::array<float, 16> node::get_world_space_transform() const
 {
-    return mat4_to_array(ns->get_world_space_transform());
+    return mat4_to_array(graph->gs->world_transform(index));
 }
 
 std::array<float, 16> node::get_to_object_space_transform() const
 {
-    return mat4_to_array(ns->get_to_object_space_transform());
+    node_graph_state* gs = graph->gs;
+    gs->update_world_transforms();
+    return mat4_to_array(gs->to_object_space_transforms[index]);
+}
+
+std::array<float, 9> node::get_normal_transform() const
+{
+    node_graph_state* gs = graph->gs;
+    gs->update_world_transforms();
+    return gs->normal_transforms[index];
 }
 
 node_bounds node::get_world_space_bounds() const
 {
-    const glm::mat4 world_space_transform = ns->get_world_space_transform();
-    const glm::vec4 object_space_min_bounds = {ns->object_space_bounds.min[0], ns->object_space_bounds.min[1], ns->object_space_bounds.min[2], 1.f};
-    const glm::vec4 object_space_max_bounds = {ns->object_space_bounds.max[0], ns->object_space_bounds.max[1], ns->object_space_bounds.max[2], 1.f};
-    glm::vec4 world_space_min_bounds = world_space_transform * object_space_min_bounds;
-    glm::vec4 world_space_max_bounds = world_space_transform * object_space_max_bounds;
+    node_graph_state* gs = graph->gs;
+    gs->update_world_transforms();
+    return gs->world_bounds[index];
+}
+
+node_sphere node::get_world_space_sphere() const
+{
+    node_graph_state* gs = graph->gs;
+    gs->update_world_transforms();
+    return gs->world_spheres[index];
+}
+
+node_bounds node::get_subtree_world_space_bounds() const
+{
+    node_graph_state* gs = graph->gs;
+    gs->update_subtree_bounds();
+    return gs->subtree_bounds[index];
+}
+
+std::array<float, 3> node::get_world_space_position() const
+{
+    const auto rv = vec4_to_array(graph->gs->world_transform(index) * glm::vec4(0.f, 0.f, 0.f, 1.f));
+    return {rv[0], rv[1], rv[2]};
+}
+
+void node::update_object_space_parent_transform(const std::array<float, 16>& new_parent_transform) const
+{
+    assert(graph->gs->parents[index] == node_graph::no_parent);
+    graph->gs->object_space_parent_transforms[index] = array_to_mat4(new_parent_transform);
+    graph->gs->mark_dirty(index);
+}
+
+void node::populate_graph(std::vector<graphics_object>& graph_objects) const
+{
+    // Walk the subtree with an explicit stack, children are pushed in reverse to keep the same visiting order as graph order.
+    graph->gs->update_world_transforms();
+    std::stack<uint32_t> pending;
+    pending.push(index);
+    while (!pending.empty())
+    {
+        const uint32_t i = pending.top();
+        pending.pop();
+        graph->gs->write_graphics_objects(i, graph_objects);
+        const uint32_t first = graph->gs->first_children[i];
+        for (uint32_t c{graph->gs->child_counts[i]}; c > 0; c--) pending.push(first + c - 1);
+    }
+}
+
+result node_graph::init(const std::shared_ptr<rosy_logger::log>& new_log, const worker_pool* new_pool)
+{
+    l = new_log;
+    if (gs = new(std::nothrow) node_graph_state; gs == nullptr)
+    {
+        l->error("Error allocating node graph state");
+        return result::allocation_failure;
+    }
+    gs->pool = new_pool;
+    return result::ok;
+}
+
+void node_graph::deinit()
+{
+    nodes = {};
+    if (gs != nullptr) gs->memory.deinit();
+    delete gs;
+    gs = nullptr;
+}
+
+void node_graph::clear()
+{
+    nodes = {};
+    gs->clear();
+}
+
+result node_graph::reserve(const size_t max_nodes, const size_t max_graphics_objects, const size_t max_name_bytes)
+{
+    if (!gs->parents.empty())
+    {
+        l->error("node graph must be cleared before it is reserved");
+        return result::invalid_state;
+    }
+    if (const auto res = gs->reserve(max_nodes, max_graphics_objects, max_name_bytes); res != result::ok)
+    {
+        l->error(std::format("Error reserving node graph for {} nodes", max_nodes));
+        return res;
+    }
+    return result::ok;
+}
 
-    for (glm::length_t i{0}; i < 3; i++)
+result node_graph::add_node(
+    const uint32_t parent_index,
+    const std::string_view name,
+    const bool is_dynamic,
+    const bool is_world_node,
+    const std::array<float, 16>& coordinate_space,
+    const std::array<float, 16>& new_object_space_transform,
+    const std::array<float, 3>& new_world_translate,
+    const float new_world_scale,
+    const float new_world_yaw,
+    uint32_t& new_index)
+{
+    new_index = static_cast<uint32_t>(gs->parents.size());
+    if (gs->parents.full() || gs->name_chars.size() + name.size() + 1 > gs->name_chars.max_count)
+    {
+        l->error(std::format("node {} does not fit the {} nodes the graph was reserved for", name, gs->parents.max_count));
+        return result::overflow;
+    }
+    if (parent_index == no_parent)
     {
-        if (world_space_min_bounds[i] > world_space_max_bounds[i])
+        // Roots must all come before any child node.
+        if (new_index > 0 && gs->parents[new_index - 1] != no_parent)
         {
-            const float swap = world_space_min_bounds[i];
-            world_space_min_bounds[i] = world_space_max_bounds[i];
-            world_space_max_bounds[i] = swap;
+            l->error(std::format("root node {} added after child nodes", name));
+            return result::invalid_argument;
         }
     }
-    return { .min = {world_space_min_bounds[0], world_space_min_bounds[1], world_space_min_bounds[2]}, .max ={world_space_max_bounds[0], world_space_max_bounds[1], world_space_max_bounds[2]}};
+    else
+    {
+        if (parent_index >= new_index)
+        {
+            l->error(std::format("node {} added before its parent {}", name, parent_index));
+            return result::invalid_argument;
+        }
+        if (gs->child_counts[parent_index] == 0)
+        {
+            gs->first_children[parent_index] = new_index;
+        }
+        else if (gs->first_children[parent_index] + gs->child_counts[parent_index] != new_index)
+        {
+            l->error(std::format("node {} is not contiguous with its siblings under {}", name, parent_index));
+            return result::invalid_argument;
+        }
+        gs->child_counts[parent_index] += 1;
+    }
+
+    gs->parents.push_back(parent_index);
+    gs->first_children.push_back(0);
+    gs->child_counts.push_back(0);
+    gs->name_offsets.push_back(static_cast<uint32_t>(gs->name_chars.size()));
+    gs->name_lengths.push_back(static_cast<uint32_t>(name.size()));
+    for (const char c : name) gs->name_chars.push_back(c);
+    gs->name_chars.push_back('\0');
+    gs->world_node_flags.push_back(is_world_node ? 1 : 0);
+    gs->dynamic_flags.push_back(is_dynamic ? 1 : 0);
+    gs->world_space_translates.push_back(array_to_vec3(new_world_translate));
+    gs->world_space_scales.push_back(new_world_scale);
+    gs->world_space_yaws.push_back(new_world_yaw);
+    gs->object_to_world_transforms.push_back(array_to_mat4(coordinate_space));
+    gs->object_space_transforms.push_back(array_to_mat4(new_object_space_transform));
+    gs->object_space_parent_transforms.push_back(glm::mat4{1.f});
+    gs->object_spaces.push_back(glm::mat4{1.f});
+    gs->world_transforms.push_back(glm::mat4{1.f});
+    gs->to_object_space_transforms.push_back(glm::mat4{1.f});
+    gs->normal_transforms.push_back({1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f});
+    gs->object_space_bounds.push_back({});
+    gs->world_bounds.push_back({});
+    gs->world_spheres.push_back({});
+    gs->subtree_bounds.push_back({});
+    gs->first_graphics_objects.push_back(static_cast<uint32_t>(gs->graphics_object_indices.size()));
+    gs->graphics_object_counts.push_back(0);
+    gs->transform_dirty_flags.push_back(0);
+    gs->graphics_dirty_flags.push_back(0);
+    gs->compose(&new_index, 1);
+    gs->invert(&new_index, 1);
+    gs->transform_bounds(&new_index, 1);
+    gs->queue_graphics_update(new_index);
+
+    // The handle array never moves once reserved, so pointers into nodes stay valid until the graph is cleared.
+    gs->handles.push_back({.graph = this, .index = new_index});
+    nodes = {gs->handles.data(), gs->handles.size()};
+    return result::ok;
 }
 
-std::array<float, 3> node::get_world_space_position() const
+result node_graph::add_graphics_object(const uint32_t node_index, const graphics_object& go)
 {
-    const auto rv = vec4_to_array(ns->get_world_space_transform() * glm::vec4(0.f, 0.f, 0.f, 1.f));
-    return {rv[0], rv[1], rv[2]};
+    if (node_index >= gs->parents.size())
+    {
+        l->error(std::format("graphics object added to unknown node {}", node_index));
+        return result::invalid_argument;
+    }
+    if (node_index < gs->last_graphics_object_node)
+    {
+        l->error(std::format("graphics objects for node {} added out of node order", node_index));
+        return result::invalid_argument;
+    }
+    if (gs->graphics_object_indices.full())
+    {
+        l->error(std::format("graphics object for node {} does not fit the {} graphics objects the graph was reserved for", node_index,
+                             gs->graphics_object_indices.max_count));
+        return result::overflow;
+    }
+    if (gs->graphics_object_counts[node_index] == 0) gs->first_graphics_objects[node_index] = static_cast<uint32_t>(gs->graphics_object_indices.size());
+    gs->last_graphics_object_node = node_index;
+    gs->graphics_object_indices.push_back(static_cast<uint32_t>(go.index));
+    gs->graphics_object_surface_counts.push_back(static_cast<uint32_t>(go.surface_data.size()));
+    gs->graphics_object_counts[node_index] += 1;
+    return result::ok;
 }
 
-void node::update_object_space_parent_transform(const std::array<float, 16>& new_parent_transform) const
+size_t node_graph::size() const
+{
+    return gs->parents.size();
+}
+
+std::span<node> node_graph::roots()
+{
+    size_t num_roots{0};
+    while (num_roots < gs->parents.size() && gs->parents[num_roots] == no_parent) num_roots += 1;
+    return {nodes.data(), num_roots};
+}
+
+void node_graph::update_world_transforms() const
 {
-    ns->object_space_parent_transform = array_to_mat4(new_parent_transform);
-    for (const node* n : children)
+    gs->update_world_transforms();
+}
+
+void node_graph::populate_dynamic(std::vector<graphics_object_transform>& graph_objects, std::vector<graphics_object_range>& dirty_ranges) const
+{
+    gs->update_world_transforms();
+    if (gs->pending_graphics_nodes.empty()) return;
+
+    // Graphics object indices increase with node order, so sorted nodes produce sorted, mergeable ranges.
+    std::sort(gs->pending_graphics_nodes.begin(), gs->pending_graphics_nodes.end());
+
+    // Each node owns its own graphics objects, so extraction is split across the workers while the ranges are built in order after.
+    const uint32_t* pending = gs->pending_graphics_nodes.data();
+    gs->for_each_chunk(gs->pending_graphics_nodes.size(), [&](const size_t begin, const size_t end)
     {
-        n->update_object_space_parent_transform(mat4_to_array(ns->object_space_parent_transform * ns->object_space_transform));
+        for (size_t k{begin}; k < end; k++) gs->write_graphics_objects(pending[k], graph_objects);
+    });
+
+    for (const uint32_t i : gs->pending_graphics_nodes)
+    {
+        gs->graphics_dirty_flags[i] = 0;
+        const size_t first = gs->first_graphics_objects[i];
+        for (size_t j{first}; j < first + gs->graphics_object_counts[i]; j++) append_dirty_range(dirty_ranges, gs->graphics_object_indices[j]);
     }
+    gs->pending_graphics_nodes.clear();
 }
 
-void node::populate_graph(std::vector<graphics_object>& graph) const
+void node_graph::populate_moved(const uint32_t* indices, const size_t count, const float* xs, const float* ys, const float* zs, const float* yaws,
+                                const uint8_t* mask, std::vector<graphics_object_transform>& graph_objects,
+                                std::vector<graphics_object_range>& dirty_ranges) const
 {
-    const glm::mat4 world_space_transform = ns->get_world_space_transform();
-    const glm::mat4 world_to_object_space_transform = inverse(world_space_transform);
-    const glm::mat3 world_space_normal_transform = glm::transpose(glm::inverse(glm::mat3(world_space_transform)));
+    gs->update_world_transforms();
+    for (size_t k{0}; k < count; k++)
+    {
+        const uint32_t i = indices[k];
+        if (mask[k] == 0 || gs->graphics_object_counts[i] == 0) continue;
+        // A node's translate and yaw are the outermost terms of its world transform, so moving it is a world space translate and yaw
+        // applied on the left, and its inverse applied on the right of the inverse. The normal transform only takes the rotation.
+        const glm::vec3 from = gs->world_space_translates[i];
+        const glm::vec3 to{xs[k], ys[k], zs[k]};
+        const float yaw_change = yaws[k] - gs->world_space_yaws[i];
+        const glm::mat4 rotation = yaw_rotation(yaw_change);
+        glm::mat4 move = rotation;
+        move[3] = glm::vec4{to - glm::mat3{rotation} * from, 1.f};
+        glm::mat4 move_back = glm::transpose(rotation);
+        move_back[3] = glm::vec4{from - glm::mat3{move_back} * to, 1.f};
 
-    const std::array<float, 16> go_transform = mat4_to_array(world_space_transform);
-    const std::array<float, 16> go_to_object_space_transform = mat4_to_array(world_to_object_space_transform);
-    const std::array<float, 9> go_normal_transform = mat3_to_array(world_space_normal_transform);
+        const std::array<float, 9>& n = gs->normal_transforms[i];
+        const glm::mat3 normal = glm::mat3{rotation} * glm::mat3{n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8]};
+        graphics_object_transform got{
+            .transform = mat4_to_array(move * gs->world_transforms[i]),
+            .to_object_space_transform = mat4_to_array(gs->to_object_space_transforms[i] * move_back),
+        };
+        for (glm::length_t column{0}; column < 3; column++)
+        {
+            for (glm::length_t row{0}; row < 3; row++) got.normal_transform[static_cast<size_t>(column * 3 + row)] = normal[column][row];
+        }
 
-    for (graphics_object go : graphics_objects)
+        const size_t first = gs->first_graphics_objects[i];
+        for (size_t j{first}; j < first + gs->graphics_object_counts[i]; j++)
+        {
+            const size_t go_index = gs->graphics_object_indices[j];
+            assert(graph_objects.size() > go_index);
+            graph_objects[go_index] = got;
+            append_dirty_range(dirty_ranges, go_index);
+        }
+    }
+}
+
+void node_graph::get_world_space_positions(const uint32_t* indices, const size_t count, float* xs, float* ys, float* zs) const
+{
+    gs->update_world_transforms();
+    for (size_t k{0}; k < count; k++)
     {
-        assert(graph.size() > go.index);
-        go.transform = go_transform;
-        go.normal_transform = go_normal_transform;
-        go.to_object_space_transform = go_to_object_space_transform;
-        graph[go.index] = go;
+        const glm::vec4& translation = gs->world_transforms[indices[k]][3];
+        xs[k] = translation.x;
+        ys[k] = translation.y;
+        zs[k] = translation.z;
     }
-    for (const node* n : children)
+}
+
+void node_graph::get_world_space_translates_and_yaws(const uint32_t* indices, const size_t count, float* xs, float* ys, float* zs, float* yaws) const
+{
+    for (size_t k{0}; k < count; k++)
+    {
+        const uint32_t i = indices[k];
+        xs[k] = gs->world_space_translates[i].x;
+        ys[k] = gs->world_space_translates[i].y;
+        zs[k] = gs->world_space_translates[i].z;
+        yaws[k] = gs->world_space_yaws[i];
+    }
+}
+
+void node_graph::set_world_space_translates_and_yaws(const uint32_t* indices, const size_t count, const float* xs, const float* ys, const float* zs,
+                                                     const float* yaws, const uint8_t* mask) const
+{
+    for (size_t k{0}; k < count; k++)
     {
-        n->populate_graph(graph);
+        if (mask[k] == 0) continue;
+        const uint32_t i = indices[k];
+        gs->world_space_translates[i] = {xs[k], ys[k], zs[k]};
+        gs->world_space_yaws[i] = yaws[k];
+        gs->mark_dirty(i);
     }
 }
 
-void node::debug()
+void node_graph::debug() const
 {
-    size_t num_surfaces{0};
-    for (const auto& go : graphics_objects) num_surfaces += go.surface_data.size();
-    l->debug(std::format("game node name: {} num graphic objects: {} num surfaces: {}", name, graphics_objects.size(), num_surfaces));
-    for (node* n : children)
+    const size_t num_nodes = gs->parents.size();
+    for (size_t i{0}; i < num_nodes; i++)
     {
-        n->debug();
+        size_t num_surfaces{0};
+        const size_t first = gs->first_graphics_objects[i];
+        for (size_t j{first}; j < first + gs->graphics_object_counts[i]; j++) num_surfaces += gs->graphics_object_surface_counts[j];
+        l->debug(std::format("game node name: {} num graphic objects: {} num surfaces: {}", gs->name(i), gs->graphics_object_counts[i], num_surfaces));
     }
 }
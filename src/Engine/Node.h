@@ -1,39 +1,57 @@
 #pragma once
 #include "Types.h"
 #include "Logger/Logger.h"
+#include <span>
 
-struct node_state;
+struct node_graph_state;
 
 namespace rosy
 {
+    struct worker_pool;
+
     struct node_bounds
     {
         std::array<float, 3> min{
             std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()
         };
         std::array<float, 3> max{
-            std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min()
+            std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()
         };
+
+        // Default constructed bounds contain nothing, which is what nodes without a mesh have.
+        [[nodiscard]] bool empty() const
+        {
+            return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+        }
+
+        void merge(const node_bounds& other)
+        {
+            for (size_t i{0}; i < 3; i++)
+            {
+                min[i] = std::min(min[i], other.min[i]);
+                max[i] = std::max(max[i], other.max[i]);
+            }
+        }
+    };
+
+    struct node_sphere
+    {
+        std::array<float, 3> center{0.f, 0.f, 0.f};
+        float radius{0.f};
     };
 
+    struct node_graph;
+
+    // A node is a thin handle into a node_graph, every bit of its state lives in the graph's contiguous arrays.
     struct node
     {
-        std::shared_ptr<rosy_logger::log> l{nullptr};
-        node_state* ns{nullptr};
-        std::vector<graphics_object> graphics_objects;
-        std::string name{};
-        std::vector<node*> children;
+        node_graph* graph{nullptr};
+        uint32_t index{0};
+
+        // Names are null terminated so name().data() can be handed to C APIs.
+        [[nodiscard]] std::string_view name() const;
+        [[nodiscard]] std::span<node> children() const;
 
-        [[nodiscard]] result init(
-            const std::shared_ptr<rosy_logger::log>& new_log,
-            bool is_world_node,
-            const std::array<float, 16>& coordinate_space,
-            const std::array<float, 16>& new_object_space_parent_transform,
-            const std::array<float, 16>& new_object_space_transform,
-            const std::array<float, 3> new_world_translate,
-            float new_world_scale,
-            float new_world_yaw);
-        void deinit();
         void set_world_space_translate(const std::array<float, 3>& new_world_space_translate) const;
         void set_world_space_scale(const float new_world_space_scale) const;
         void set_world_space_yaw(float new_world_space_yaw) const;
@@ -48,17 +66,87 @@ namespace rosy
         // world space coordinate system and then any world space transforms
         [[nodiscard]] std::array<float, 16> get_world_space_transform() const;
 
-        // get_to_object_space_transform this returns the matrix required to take something from world space to this object's space. 
+        // get_to_object_space_transform this returns the matrix required to take something from world space to this object's space.
         [[nodiscard]] std::array<float, 16> get_to_object_space_transform() const;
 
-        // get_world_space_bounds this returns the world space bounds that this object fills in world space.
+        // get_normal_transform returns transpose(inverse(mat3(world space transform))) for transforming normals.
+        [[nodiscard]] std::array<float, 9> get_normal_transform() const;
+
+        // get_world_space_bounds this returns the world space bounds that this object fills in world space. Every corner of the object
+        // space bounds is accounted for, so they stay tight and correct under rotation. Cached, only recomputed when the node moves.
         [[nodiscard]] node_bounds get_world_space_bounds() const;
 
+        // get_world_space_sphere returns a world space sphere containing the object space bounds, radius 0 if the node has none.
+        [[nodiscard]] node_sphere get_world_space_sphere() const;
+
+        // get_subtree_world_space_bounds returns the world space bounds of this node and all of its descendants.
+        [[nodiscard]] node_bounds get_subtree_world_space_bounds() const;
+
 
         [[nodiscard]] std::array<float, 3> get_world_space_position() const;
 
+        // Only root nodes own their object space parent transform, every other node's is derived from its parent.
+        // Setting it or any world space value marks the node and its descendants dirty.
         void update_object_space_parent_transform(const std::array<float, 16>& new_parent_transform) const;
-        void populate_graph(std::vector<graphics_object>& graph) const;
-        void debug();
+        void populate_graph(std::vector<graphics_object>& graph_objects) const;
+    };
+
+    // node_graph stores every node of a scene in breadth first order in parallel arrays. Roots come first, the children of any node are
+    // contiguous and a parent always precedes its children, so world transforms are brought up to date in one linear pass.
+    struct node_graph
+    {
+        static constexpr uint32_t no_parent{UINT32_MAX};
+
+        std::shared_ptr<rosy_logger::log> l{nullptr};
+        node_graph_state* gs{nullptr};
+        // Handles for every node in graph order, stable from when they are added until the graph is cleared.
+        std::span<node> nodes;
+
+        // With a worker pool large batches of nodes are updated in parallel, nullptr keeps everything on the calling thread.
+        [[nodiscard]] result init(const std::shared_ptr<rosy_logger::log>& new_log, const worker_pool* new_pool = nullptr);
+        void deinit();
+        // Releases every node at once, the memory is kept for the next level.
+        void clear();
+        // Sizes the graph for a level before any node is added, adding more than reserved fails with result::overflow.
+        [[nodiscard]] result reserve(size_t max_nodes, size_t max_graphics_objects, size_t max_name_bytes);
+
+        // Nodes must be added in breadth first order, all the children of a parent one after another.
+        // Dynamic nodes have their graphics objects extracted every frame by populate_dynamic.
+        [[nodiscard]] result add_node(
+            uint32_t parent_index,
+            std::string_view name,
+            bool is_dynamic,
+            bool is_world_node,
+            const std::array<float, 16>& coordinate_space,
+            const std::array<float, 16>& new_object_space_transform,
+            const std::array<float, 3>& new_world_translate,
+            float new_world_scale,
+            float new_world_yaw,
+            uint32_t& new_index);
+        // Graphics objects must be added in node order.
+        [[nodiscard]] result add_graphics_object(uint32_t node_index, const graphics_object& go);
+
+        [[nodiscard]] size_t size() const;
+        [[nodiscard]] std::span<node> roots();
+        // Recomputes only the dirty nodes and their descendants, nothing is done when no node has changed.
+        void update_world_transforms() const;
+        // Writes the graphics objects of the dynamic nodes that changed since the last call into graph_objects and appends the
+        // graph_objects index ranges that were written to dirty_ranges. Every dynamic node is written on the first call.
+        void populate_dynamic(std::vector<graphics_object_transform>& graph_objects, std::vector<graphics_object_range>& dirty_ranges) const;
+        // Writes the graphics objects of the nodes whose mask is set as if each had the given world space translate and yaw, and appends
+        // the ranges written to dirty_ranges. The graph is left as it is, for drawing nodes between their simulated states.
+        void populate_moved(const uint32_t* indices, size_t count, const float* xs, const float* ys, const float* zs, const float* yaws,
+                            const uint8_t* mask, std::vector<graphics_object_transform>& graph_objects,
+                            std::vector<graphics_object_range>& dirty_ranges) const;
+
+        // Batched access for systems that move many nodes at once, every array has count elements.
+        // Reads each node's world space position, its world transform's translation.
+        void get_world_space_positions(const uint32_t* indices, size_t count, float* xs, float* ys, float* zs) const;
+        // Reads the world space translates and yaws set on each node, exactly as set_world_space_translates_and_yaws wrote them.
+        void get_world_space_translates_and_yaws(const uint32_t* indices, size_t count, float* xs, float* ys, float* zs, float* yaws) const;
+        // Writes world space translates and yaws of the nodes whose mask is set straight into the graph and marks them dirty.
+        void set_world_space_translates_and_yaws(const uint32_t* indices, size_t count, const float* xs, const float* ys, const float* zs,
+                                                 const float* yaws, const uint8_t* mask) const;
+        void debug() const;
     };
 }
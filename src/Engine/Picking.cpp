@@ -0,0 +1,476 @@
+#include "pch.h"
+#include "Picking.h"
+#include "Asset/Asset.h"
+#include <immintrin.h>
+#include <cmath>
+#include <limits>
+
+using namespace rosy;
+
+namespace
+{
+    constexpr uint32_t leaf_size{4};
+    constexpr size_t max_traversal_depth{64};
+    constexpr float no_hit{std::numeric_limits<float>::infinity()};
+
+    // min's w is -inf and max's w is +inf so the unused lane never limits the slab test.
+    struct bvh_node
+    {
+        std::array<float, 4> min{0.f, 0.f, 0.f, -std::numeric_limits<float>::infinity()};
+        std::array<float, 4> max{0.f, 0.f, 0.f, std::numeric_limits<float>::infinity()};
+        uint32_t first{0}; // internal nodes: the left child, the right child follows it. Leaves: the first item
+        uint32_t count{0}; // items in a leaf, 0 for internal nodes
+    };
+
+    // Four triangles laid out for a four wide test, unused lanes are degenerate and never hit.
+    struct alignas(16) triangle_packet
+    {
+        std::array<float, 4> v0_x{};
+        std::array<float, 4> v0_y{};
+        std::array<float, 4> v0_z{};
+        std::array<float, 4> e1_x{};
+        std::array<float, 4> e1_y{};
+        std::array<float, 4> e1_z{};
+        std::array<float, 4> e2_x{};
+        std::array<float, 4> e2_y{};
+        std::array<float, 4> e2_z{};
+        std::array<uint32_t, 4> first_indices{};
+        std::array<uint32_t, 4> surfaces{};
+    };
+
+    // A leaf's first is its packet.
+    struct mesh_bvh
+    {
+        std::vector<bvh_node> nodes;
+        std::vector<triangle_packet> packets;
+    };
+
+    struct build_item
+    {
+        node_bounds bounds{};
+        std::array<float, 3> centroid{};
+        uint32_t id{0}; // a triangle's first index or an instance
+        uint32_t surface{0};
+    };
+
+    struct picking_instance
+    {
+        uint32_t node_index{0};
+        uint32_t mesh_index{0};
+    };
+
+    struct build_task
+    {
+        uint32_t node{0};
+        uint32_t first{0};
+        uint32_t count{0};
+    };
+
+    // Splits at the median centroid along the widest centroid axis, which keeps the tree balanced and its depth logarithmic.
+    // Items are reordered so every leaf's items are contiguous. Tasks is scratch, passed in so rebuilds reuse its memory.
+    void build_bvh(std::vector<build_item>& items, std::vector<build_task>& tasks, std::vector<bvh_node>& nodes)
+    {
+        nodes.clear();
+        tasks.clear();
+        if (items.empty()) return;
+        nodes.reserve(2 * (items.size() / leaf_size + 1));
+        nodes.push_back({});
+        tasks.push_back({.node = 0, .first = 0, .count = static_cast<uint32_t>(items.size())});
+        while (!tasks.empty())
+        {
+            const build_task task = tasks.back();
+            tasks.pop_back();
+
+            node_bounds bounds{};
+            node_bounds centroids{};
+            for (uint32_t i{task.first}; i < task.first + task.count; i++)
+            {
+                bounds.merge(items[i].bounds);
+                centroids.merge({.min = items[i].centroid, .max = items[i].centroid});
+            }
+            std::copy_n(bounds.min.begin(), 3, nodes[task.node].min.begin());
+            std::copy_n(bounds.max.begin(), 3, nodes[task.node].max.begin());
+            if (task.count <= leaf_size)
+            {
+                nodes[task.node].first = task.first;
+                nodes[task.node].count = task.count;
+                continue;
+            }
+
+            size_t axis{0};
+            for (size_t i{1}; i < 3; i++)
+            {
+                if (centroids.max[i] - centroids.min[i] > centroids.max[axis] - centroids.min[axis]) axis = i;
+            }
+            const uint32_t middle = task.first + task.count / 2;
+            const auto begin = items.begin() + task.first;
+            std::nth_element(begin, items.begin() + middle, begin + task.count, [axis](const build_item& a, const build_item& b)
+            {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+
+            const auto left = static_cast<uint32_t>(nodes.size());
+            nodes.push_back({});
+            nodes.push_back({});
+            nodes[task.node].first = left;
+            nodes[task.node].count = 0;
+            tasks.push_back({.node = left, .first = task.first, .count = middle - task.first});
+            tasks.push_back({.node = left + 1, .first = middle, .count = task.first + task.count - middle});
+        }
+    }
+
+    struct simd_ray
+    {
+        __m128 origin;
+        __m128 inverse_direction;
+        // Broadcast for the packet test.
+        __m128 origin_x;
+        __m128 origin_y;
+        __m128 origin_z;
+        __m128 direction_x;
+        __m128 direction_y;
+        __m128 direction_z;
+    };
+
+    // A zero or tiny component would give an infinite inverse, and 0 * inf in the slab test is NaN when the ray starts on a box face.
+    float safe_inverse(const float d)
+    {
+        return std::abs(d) > 1e-30f ? 1.f / d : std::copysign(1e30f, d);
+    }
+
+    simd_ray make_ray(const std::array<float, 3>& origin, const std::array<float, 3>& direction)
+    {
+        return {
+            .origin = _mm_setr_ps(origin[0], origin[1], origin[2], 0.f),
+            .inverse_direction = _mm_setr_ps(safe_inverse(direction[0]), safe_inverse(direction[1]), safe_inverse(direction[2]), 1.f),
+            .origin_x = _mm_set1_ps(origin[0]),
+            .origin_y = _mm_set1_ps(origin[1]),
+            .origin_z = _mm_set1_ps(origin[2]),
+            .direction_x = _mm_set1_ps(direction[0]),
+            .direction_y = _mm_set1_ps(direction[1]),
+            .direction_z = _mm_set1_ps(direction[2]),
+        };
+    }
+
+    // Slab test on all three axes at once, returns where the ray enters the box or no_hit when it misses it before t_max.
+    float ray_box(const simd_ray& r, const bvh_node& n, const float t_max)
+    {
+        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.min.data()), r.origin), r.inverse_direction);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.max.data()), r.origin), r.inverse_direction);
+        __m128 enter = _mm_min_ps(t0, t1);
+        __m128 leave = _mm_max_ps(t0, t1);
+        enter = _mm_max_ps(enter, _mm_shuffle_ps(enter, enter, _MM_SHUFFLE(1, 0, 3, 2)));
+        enter = _mm_max_ps(enter, _mm_shuffle_ps(enter, enter, _MM_SHUFFLE(2, 3, 0, 1)));
+        leave = _mm_min_ps(leave, _mm_shuffle_ps(leave, leave, _MM_SHUFFLE(1, 0, 3, 2)));
+        leave = _mm_min_ps(leave, _mm_shuffle_ps(leave, leave, _MM_SHUFFLE(2, 3, 0, 1)));
+        const float t_enter = std::max(_mm_cvtss_f32(enter), 0.f);
+        const float t_exit = std::min(_mm_cvtss_f32(leave), t_max);
+        return t_enter <= t_exit ? t_enter : no_hit;
+    }
+
+    // Moller-Trumbore against four triangles at once, double sided. Returns the lane of the nearest hit closer than t_best and
+    // updates t_best, or -1 when no triangle is hit.
+    int ray_packet(const simd_ray& r, const triangle_packet& p, float& t_best)
+    {
+        const __m128 e1_x = _mm_load_ps(p.e1_x.data());
+        const __m128 e1_y = _mm_load_ps(p.e1_y.data());
+        const __m128 e1_z = _mm_load_ps(p.e1_z.data());
+        const __m128 e2_x = _mm_load_ps(p.e2_x.data());
+        const __m128 e2_y = _mm_load_ps(p.e2_y.data());
+        const __m128 e2_z = _mm_load_ps(p.e2_z.data());
+
+        // p = d x e2, det = e1 . p
+        const __m128 p_x = _mm_sub_ps(_mm_mul_ps(r.direction_y, e2_z), _mm_mul_ps(r.direction_z, e2_y));
+        const __m128 p_y = _mm_sub_ps(_mm_mul_ps(r.direction_z, e2_x), _mm_mul_ps(r.direction_x, e2_z));
+        const __m128 p_z = _mm_sub_ps(_mm_mul_ps(r.direction_x, e2_y), _mm_mul_ps(r.direction_y, e2_x));
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1_x, p_x), _mm_mul_ps(e1_y, p_y)), _mm_mul_ps(e1_z, p_z));
+        const __m128 inverse_det = _mm_div_ps(_mm_set1_ps(1.f), det);
+
+        // s = o - v0, u = (s . p) / det
+        const __m128 s_x = _mm_sub_ps(r.origin_x, _mm_load_ps(p.v0_x.data()));
+        const __m128 s_y = _mm_sub_ps(r.origin_y, _mm_load_ps(p.v0_y.data()));
+        const __m128 s_z = _mm_sub_ps(r.origin_z, _mm_load_ps(p.v0_z.data()));
+        const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(s_x, p_x), _mm_mul_ps(s_y, p_y)), _mm_mul_ps(s_z, p_z)), inverse_det);
+
+        // q = s x e1, v = (d . q) / det, t = (e2 . q) / det
+        const __m128 q_x = _mm_sub_ps(_mm_mul_ps(s_y, e1_z), _mm_mul_ps(s_z, e1_y));
+        const __m128 q_y = _mm_sub_ps(_mm_mul_ps(s_z, e1_x), _mm_mul_ps(s_x, e1_z));
+        const __m128 q_z = _mm_sub_ps(_mm_mul_ps(s_x, e1_y), _mm_mul_ps(s_y, e1_x));
+        const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r.direction_x, q_x), _mm_mul_ps(r.direction_y, q_y)), _mm_mul_ps(r.direction_z, q_z)),
+                                    inverse_det);
+        const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2_x, q_x), _mm_mul_ps(e2_y, q_y)), _mm_mul_ps(e2_z, q_z)), inverse_det);
+
+        // Degenerate lanes have a zero determinant, their infinite or NaN results fail every comparison below.
+        const __m128 zero = _mm_setzero_ps();
+        __m128 hit = _mm_cmpneq_ps(det, zero);
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+        hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.f)));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_set1_ps(t_best)));
+        const int mask = _mm_movemask_ps(hit);
+        if (mask == 0) return -1;
+
+        alignas(16) std::array<float, 4> distances{};
+        _mm_store_ps(distances.data(), t);
+        int lane{-1};
+        for (int i{0}; i < 4; i++)
+        {
+            if ((mask & (1 << i)) == 0 || distances[i] >= t_best) continue;
+            t_best = distances[i];
+            lane = i;
+        }
+        return lane;
+    }
+
+    // Visits the leaves the ray reaches nearest first, leaf_hit(leaf, t_best) lowers t_best when it finds a nearer hit.
+    template <typename F>
+    void traverse(const std::vector<bvh_node>& nodes, const simd_ray& r, float& t_best, F&& leaf_hit)
+    {
+        if (nodes.empty()) return;
+        struct stack_entry
+        {
+            uint32_t node{0};
+            float t_enter{0.f};
+        };
+        std::array<stack_entry, max_traversal_depth> stack{};
+        size_t stack_size{0};
+        if (const float t_root = ray_box(r, nodes[0], t_best); t_root != no_hit) stack[stack_size++] = {.node = 0, .t_enter = t_root};
+        while (stack_size > 0)
+        {
+            const stack_entry entry = stack[--stack_size];
+            if (entry.t_enter >= t_best) continue;
+            const bvh_node& n = nodes[entry.node];
+            if (n.count > 0)
+            {
+                leaf_hit(n, t_best);
+                continue;
+            }
+            const float t_left = ray_box(r, nodes[n.first], t_best);
+            const float t_right = ray_box(r, nodes[n.first + 1], t_best);
+            const bool left_first = t_left <= t_right;
+            const stack_entry nearer{.node = left_first ? n.first : n.first + 1, .t_enter = left_first ? t_left : t_right};
+            const stack_entry farther{.node = left_first ? n.first + 1 : n.first, .t_enter = left_first ? t_right : t_left};
+            assert(stack_size + 2 <= stack.size());
+            if (farther.t_enter != no_hit) stack[stack_size++] = farther;
+            if (nearer.t_enter != no_hit) stack[stack_size++] = nearer;
+        }
+    }
+
+    std::array<float, 3> transform_point(const std::array<float, 16>& m, const std::array<float, 3>& p)
+    {
+        return {
+            m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+            m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+            m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14],
+        };
+    }
+
+    std::array<float, 3> transform_direction(const std::array<float, 16>& m, const std::array<float, 3>& d)
+    {
+        return {
+            m[0] * d[0] + m[4] * d[1] + m[8] * d[2],
+            m[1] * d[0] + m[5] * d[1] + m[9] * d[2],
+            m[2] * d[0] + m[6] * d[1] + m[10] * d[2],
+        };
+    }
+}
+
+struct picking_state
+{
+    std::vector<mesh_bvh> meshes;
+    std::vector<picking_instance> static_instances;
+    std::vector<picking_instance> dynamic_instances;
+
+    // The top level BVH over the static instances, its leaves index instance_order which indexes static_instances.
+    std::vector<bvh_node> top_level;
+    std::vector<uint32_t> instance_order;
+    std::vector<build_item> build_items;
+    std::vector<build_task> build_tasks;
+    bool top_level_dirty{true};
+
+    void build_mesh(const rosy_asset::mesh& m, mesh_bvh& bvh)
+    {
+        build_items.clear();
+        for (uint32_t surface_index{0}; surface_index < m.surfaces.size(); surface_index++)
+        {
+            const rosy_asset::surface& s = m.surfaces[surface_index];
+            for (uint32_t first{s.start_index}; first + 2 < s.start_index + s.count && first + 2 < m.indices.size(); first += 3)
+            {
+                node_bounds b{};
+                std::array<float, 3> centroid{0.f, 0.f, 0.f};
+                bool valid{true};
+                for (uint32_t k{0}; k < 3; k++)
+                {
+                    const uint32_t vertex = m.indices[first + k];
+                    if (vertex >= m.positions.size())
+                    {
+                        valid = false;
+                        break;
+                    }
+                    const std::array<float, 3>& p = m.positions[vertex].vertex;
+                    b.merge({.min = p, .max = p});
+                    for (size_t i{0}; i < 3; i++) centroid[i] += p[i] / 3.f;
+                }
+                if (!valid) continue;
+                build_items.push_back({.bounds = b, .centroid = centroid, .id = first, .surface = surface_index});
+            }
+        }
+
+        build_bvh(build_items, build_tasks, bvh.nodes);
+        bvh.packets.clear();
+        for (bvh_node& n : bvh.nodes)
+        {
+            if (n.count == 0) continue;
+            triangle_packet packet{};
+            for (uint32_t lane{0}; lane < n.count; lane++)
+            {
+                const build_item& item = build_items[n.first + lane];
+                const uint32_t first = item.id;
+                const std::array<float, 3>& v0 = m.positions[m.indices[first]].vertex;
+                const std::array<float, 3>& v1 = m.positions[m.indices[first + 1]].vertex;
+                const std::array<float, 3>& v2 = m.positions[m.indices[first + 2]].vertex;
+                packet.v0_x[lane] = v0[0];
+                packet.v0_y[lane] = v0[1];
+                packet.v0_z[lane] = v0[2];
+                packet.e1_x[lane] = v1[0] - v0[0];
+                packet.e1_y[lane] = v1[1] - v0[1];
+                packet.e1_z[lane] = v1[2] - v0[2];
+                packet.e2_x[lane] = v2[0] - v0[0];
+                packet.e2_y[lane] = v2[1] - v0[1];
+                packet.e2_z[lane] = v2[2] - v0[2];
+                packet.first_indices[lane] = first;
+                packet.surfaces[lane] = item.surface;
+            }
+            n.first = static_cast<uint32_t>(bvh.packets.size());
+            bvh.packets.push_back(packet);
+        }
+    }
+
+    void build_top_level(const node_graph& graph)
+    {
+        build_items.clear();
+        for (uint32_t i{0}; i < static_instances.size(); i++)
+        {
+            const node_bounds b = graph.nodes[static_instances[i].node_index].get_world_space_bounds();
+            if (b.empty()) continue;
+            const std::array<float, 3> centroid{(b.min[0] + b.max[0]) * 0.5f, (b.min[1] + b.max[1]) * 0.5f, (b.min[2] + b.max[2]) * 0.5f};
+            build_items.push_back({.bounds = b, .centroid = centroid, .id = i});
+        }
+        build_bvh(build_items, build_tasks, top_level);
+        instance_order.resize(build_items.size());
+        for (size_t i{0}; i < build_items.size(); i++) instance_order[i] = build_items[i].id;
+        top_level_dirty = false;
+    }
+};
+
+result picking::init(const std::shared_ptr<rosy_logger::log>& new_log)
+{
+    l = new_log;
+    if (ps = new(std::nothrow) picking_state; ps == nullptr)
+    {
+        l->error("Error allocating picking state");
+        return result::allocation_failure;
+    }
+    return result::ok;
+}
+
+void picking::deinit()
+{
+    delete ps;
+    ps = nullptr;
+}
+
+result picking::set_meshes(const rosy_asset::asset& a) const
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    ps->static_instances.clear();
+    ps->dynamic_instances.clear();
+    ps->top_level.clear();
+    ps->top_level_dirty = true;
+    ps->meshes.resize(a.meshes.size());
+    size_t num_triangles{0};
+    for (size_t i{0}; i < a.meshes.size(); i++)
+    {
+        ps->build_mesh(a.meshes[i], ps->meshes[i]);
+        num_triangles += ps->build_items.size();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    l->info(std::format("built picking BVHs for {} meshes with {} triangles in {:.2f} ms", a.meshes.size(), num_triangles,
+                        std::chrono::duration<double, std::milli>(end - start).count()));
+    return result::ok;
+}
+
+result picking::add_instance(const uint32_t node_index, const uint32_t mesh_index, const bool is_dynamic) const
+{
+    if (mesh_index >= ps->meshes.size())
+    {
+        l->error(std::format("picking instance for node {} has an invalid mesh {}", node_index, mesh_index));
+        return result::invalid_argument;
+    }
+    if (is_dynamic)
+    {
+        ps->dynamic_instances.push_back({.node_index = node_index, .mesh_index = mesh_index});
+        return result::ok;
+    }
+    ps->static_instances.push_back({.node_index = node_index, .mesh_index = mesh_index});
+    ps->top_level_dirty = true;
+    return result::ok;
+}
+
+void picking::prepare(const node_graph& graph) const
+{
+    ps->build_top_level(graph);
+}
+
+std::optional<pick_hit> picking::pick(const node_graph& graph, const std::array<float, 3>& origin, const std::array<float, 3>& direction,
+                                      const float max_distance, const pick_filter filter) const
+{
+    if (ps->top_level_dirty) ps->build_top_level(graph);
+
+    pick_hit best{};
+    bool found{false};
+    float t_best = max_distance;
+    const simd_ray world_ray = make_ray(origin, direction);
+    const auto pick_instance = [&](const picking_instance& instance, float& t_nearest)
+    {
+        // An affine transform keeps the ray's parameterization, so distances in object space are distances in world space.
+        const std::array<float, 16> to_object_space = graph.nodes[instance.node_index].get_to_object_space_transform();
+        const simd_ray object_ray = make_ray(transform_point(to_object_space, origin), transform_direction(to_object_space, direction));
+        const mesh_bvh& mesh = ps->meshes[instance.mesh_index];
+        traverse(mesh.nodes, object_ray, t_nearest, [&](const bvh_node& mesh_leaf, float& t_triangle)
+        {
+            const triangle_packet& packet = mesh.packets[mesh_leaf.first];
+            if (const int lane = ray_packet(object_ray, packet, t_triangle); lane >= 0)
+            {
+                found = true;
+                best.node_index = instance.node_index;
+                best.mesh_index = instance.mesh_index;
+                best.surface_index = packet.surfaces[lane];
+                best.first_index = packet.first_indices[lane];
+                best.distance = t_triangle;
+            }
+        });
+    };
+    traverse(ps->top_level, world_ray, t_best, [&](const bvh_node& leaf, float& t_nearest)
+    {
+        for (uint32_t k{leaf.first}; k < leaf.first + leaf.count; k++) pick_instance(ps->static_instances[ps->instance_order[k]], t_nearest);
+    });
+    if (filter != pick_filter::static_only)
+    {
+        // Dynamic instances move every frame, so each is tested against its current world bounds instead of being kept in a tree.
+        for (const picking_instance& instance : ps->dynamic_instances)
+        {
+            const node_bounds b = graph.nodes[instance.node_index].get_world_space_bounds();
+            if (b.empty()) continue;
+            bvh_node box{};
+            std::copy_n(b.min.begin(), 3, box.min.begin());
+            std::copy_n(b.max.begin(), 3, box.max.begin());
+            if (ray_box(world_ray, box, t_best) == no_hit) continue;
+            pick_instance(instance, t_best);
+        }
+    }
+    if (!found) return std::nullopt;
+    for (size_t i{0}; i < 3; i++) best.position[i] = origin[i] + direction[i] * best.distance;
+    return best;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Types.h"
+#include "Node.h"
+#include "Logger/Logger.h"
+
+struct picking_state;
+
+namespace rosy_asset
+{
+    struct asset;
+}
+
+namespace rosy
+{
+    struct pick_hit
+    {
+        uint32_t node_index{0};
+        uint32_t mesh_index{0};
+        uint32_t surface_index{0}; // index into the mesh's surfaces
+        uint32_t first_index{0}; // where the triangle's three indices start in the mesh's indices
+        float distance{0.f}; // in units of the ray direction's length
+        std::array<float, 3> position{0.f, 0.f, 0.f}; // world space
+    };
+
+    enum class pick_filter : uint8_t { all, static_only };
+
+    // Ray picking against the level's actual triangles. A top level BVH over the world bounds of every static node with a mesh finds
+    // the candidate nodes, the ray is moved into each candidate's object space and tested against that mesh's triangle BVH. Dynamic
+    // nodes are tested one by one against their current world bounds, so moving them costs nothing until a pick. Triangle BVHs are
+    // built once per level and the top level BVH whenever a static instance is added, static nodes do not move once a level is built.
+    struct picking
+    {
+        std::shared_ptr<rosy_logger::log> l{nullptr};
+        picking_state* ps{nullptr};
+
+        [[nodiscard]] result init(const std::shared_ptr<rosy_logger::log>& new_log);
+        void deinit();
+
+        // Builds a triangle BVH for every mesh in the asset and forgets every instance.
+        [[nodiscard]] result set_meshes(const rosy_asset::asset& a) const;
+        // A node drawing a mesh, dynamic nodes are kept out of the top level BVH and skipped by pick_filter::static_only.
+        [[nodiscard]] result add_instance(uint32_t node_index, uint32_t mesh_index, bool is_dynamic) const;
+
+        // Builds the top level BVH now rather than on the first pick.
+        void prepare(const node_graph& graph) const;
+        // Returns the nearest triangle the world space ray hits within max_distance.
+        [[nodiscard]] std::optional<pick_hit> pick(const node_graph& graph, const std::array<float, 3>& origin, const std::array<float, 3>& direction,
+                                                   float max_distance, pick_filter filter = pick_filter::all) const;
+    };
+}
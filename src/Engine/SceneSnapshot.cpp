@@ -0,0 +1,190 @@
+#include "pch.h"
+#include "SceneSnapshot.h"
+#include "BinaryIO.h"
+#include <cstring>
+
+using namespace rosy;
+
+// Scene Snapshot File Format:
+// 1. Header
+// 2. a std::vector<scene_snapshot_node> of the node count given
+// 3. a std::vector<char> of the name character count given
+// 4. a std::vector<scene_snapshot_graphics_object> of the graphics object count given
+// 5. a std::vector<surface_graphics_data> of the surface count given
+
+namespace
+{
+    struct snapshot_header
+    {
+        uint32_t magic{0};
+        uint32_t version{0};
+        uint32_t endianness{0};
+        uint32_t reserved{0};
+        uint64_t level_hash{0};
+        uint64_t static_objects_offset{0};
+        uint64_t num_dynamic_objects{0};
+        uint64_t num_nodes{0};
+        uint64_t num_name_chars{0};
+        uint64_t num_graphics_objects{0};
+        uint64_t num_surfaces{0};
+    };
+
+    // The snapshot is read and written as raw memory.
+    static_assert(std::is_trivially_copyable_v<scene_snapshot_node>);
+    static_assert(std::is_trivially_copyable_v<scene_snapshot_graphics_object>);
+    static_assert(std::is_trivially_copyable_v<surface_graphics_data>);
+
+    // FNV-1a
+    struct hasher
+    {
+        uint64_t value{14695981039346656037ull};
+
+        void bytes(const void* data, const size_t size)
+        {
+            const auto b = static_cast<const uint8_t*>(data);
+            for (size_t i{0}; i < size; i++)
+            {
+                value ^= b[i];
+                value *= 1099511628211ull;
+            }
+        }
+
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        void add(const T& v)
+        {
+            bytes(&v, sizeof(T));
+        }
+
+        template <typename T>
+            requires std::is_trivially_copyable_v<T>
+        void add(const std::vector<T>& v)
+        {
+            add(v.size());
+            bytes(v.data(), v.size() * sizeof(T));
+        }
+    };
+}
+
+void scene_snapshot::clear()
+{
+    level_hash = 0;
+    static_objects_offset = 0;
+    num_dynamic_objects = 0;
+    nodes.clear();
+    names.clear();
+    graphics_objects.clear();
+    surfaces.clear();
+}
+
+result scene_snapshot::write(const std::shared_ptr<rosy_logger::log>& l, const std::string& path) const
+{
+    std::ofstream o(path, std::ios::binary | std::ios::trunc);
+    if (!o.is_open())
+    {
+        l->error(std::format("failed to open scene snapshot for writing {}", path));
+        return result::open_failed;
+    }
+    const snapshot_header header{
+        .magic = scene_snapshot_format,
+        .version = scene_snapshot_version,
+        .endianness = 1, // for std::endian::little
+        .reserved = 0,
+        .level_hash = level_hash,
+        .static_objects_offset = static_objects_offset,
+        .num_dynamic_objects = num_dynamic_objects,
+        .num_nodes = nodes.size(),
+        .num_name_chars = names.size(),
+        .num_graphics_objects = graphics_objects.size(),
+        .num_surfaces = surfaces.size(),
+    };
+    o.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    o.write(reinterpret_cast<const char*>(nodes.data()), static_cast<std::streamsize>(nodes.size() * sizeof(scene_snapshot_node)));
+    o.write(names.data(), static_cast<std::streamsize>(names.size()));
+    o.write(reinterpret_cast<const char*>(graphics_objects.data()),
+            static_cast<std::streamsize>(graphics_objects.size() * sizeof(scene_snapshot_graphics_object)));
+    o.write(reinterpret_cast<const char*>(surfaces.data()), static_cast<std::streamsize>(surfaces.size() * sizeof(surface_graphics_data)));
+    o.close();
+    if (o.fail())
+    {
+        l->error(std::format("failed to write scene snapshot {}", path));
+        return result::write_failed;
+    }
+    l->info(std::format("wrote scene snapshot {} with {} nodes and {} graphics objects", path, nodes.size(), graphics_objects.size()));
+    return result::ok;
+}
+
+result scene_snapshot::read(const std::shared_ptr<rosy_logger::log>& l, const std::string& path, const uint64_t expected_level_hash)
+{
+    clear();
+    std::vector<char> buffer;
+    {
+        // The whole snapshot is brought in with a single read and copied out of the buffer.
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) return result::open_failed;
+        const std::streamsize file_size = file.tellg();
+        if (file_size < static_cast<std::streamsize>(sizeof(snapshot_header)))
+        {
+            l->error(std::format("invalid scene snapshot {}", path));
+            return result::read_failed;
+        }
+        buffer.resize(static_cast<size_t>(file_size));
+        file.seekg(0);
+        if (!file.read(buffer.data(), file_size))
+        {
+            l->error(std::format("failed to read scene snapshot {}", path));
+            return result::read_failed;
+        }
+    }
+
+    snapshot_header header{};
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.magic != scene_snapshot_format || header.version != scene_snapshot_version || header.endianness != 1)
+    {
+        l->info(std::format("scene snapshot {} is version {}, current version is {}", path, header.version, scene_snapshot_version));
+        return result::invalid_state;
+    }
+    if (header.level_hash != expected_level_hash)
+    {
+        l->info(std::format("scene snapshot {} is for a different version of the level", path));
+        return result::invalid_state;
+    }
+
+    size_t offset{sizeof(header)};
+    if (!read_items(buffer, offset, header.num_nodes, nodes) ||
+        !read_items(buffer, offset, header.num_name_chars, names) ||
+        !read_items(buffer, offset, header.num_graphics_objects, graphics_objects) ||
+        !read_items(buffer, offset, header.num_surfaces, surfaces))
+    {
+        l->error(std::format("scene snapshot {} is truncated", path));
+        clear();
+        return result::read_failed;
+    }
+    level_hash = header.level_hash;
+    static_objects_offset = header.static_objects_offset;
+    num_dynamic_objects = header.num_dynamic_objects;
+    l->info(std::format("read scene snapshot {} with {} nodes and {} graphics objects", path, nodes.size(), graphics_objects.size()));
+    return result::ok;
+}
+
+scene_snapshot_key rosy::make_scene_snapshot_key(const std::string& source_path, const std::string_view placed_models,
+                                                 const std::span<const std::string> asset_paths)
+{
+    hasher h{};
+    h.add(scene_snapshot_version);
+    h.add(placed_models.size());
+    h.bytes(placed_models.data(), placed_models.size());
+    h.add(asset_paths.size());
+    for (const std::string& asset_path : asset_paths)
+    {
+        h.add(asset_path.size());
+        h.bytes(asset_path.data(), asset_path.size());
+        // A missing file hashes as empty, the level fails to load it either way.
+        std::error_code ec;
+        const uintmax_t file_size = std::filesystem::file_size(asset_path, ec);
+        h.add(ec ? uintmax_t{0} : file_size);
+        const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(asset_path, ec);
+        h.add(ec ? int64_t{0} : static_cast<int64_t>(write_time.time_since_epoch().count()));
+    }
+    return {.path = source_path + ".scene", .hash = h.value};
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Types.h"
+#include "Node.h"
+#include "Logger/Logger.h"
+#include <span>
+#include <string_view>
+
+namespace rosy
+{
+    constexpr uint32_t scene_snapshot_format{0x52534E53}; // "RSNS"
+    constexpr uint32_t scene_snapshot_version{2};
+
+    // Everything node_graph::add_node needs to recreate a node, plus the object space bounds set_asset derives from its mesh.
+    struct scene_snapshot_node
+    {
+        uint32_t parent_index{UINT32_MAX};
+        uint32_t is_dynamic{0};
+        uint32_t is_world_node{0};
+        uint32_t name_length{0}; // names are stored back to back in scene_snapshot::names in node order
+        std::array<float, 16> coordinate_system{};
+        std::array<float, 16> object_space_transform{};
+        std::array<float, 3> world_translate{0.f, 0.f, 0.f};
+        float world_scale{1.f};
+        float world_yaw{0.f};
+        node_bounds object_space_bounds{};
+    };
+
+    // A graphics object as uploaded to the renderer, its surfaces are a range of scene_snapshot::surfaces.
+    struct scene_snapshot_graphics_object
+    {
+        uint32_t node_index{0};
+        uint32_t is_mob{0};
+        uint64_t index{0};
+        uint64_t first_surface{0};
+        uint64_t num_surfaces{0};
+        std::array<float, 16> transform{};
+        std::array<float, 16> to_object_space_transform{};
+        std::array<float, 9> normal_transform{};
+    };
+
+    // A level's built scene, the node graph and the full scene upload, saved next to the level file so an unchanged level is
+    // reloaded without traversing the asset again. The snapshot only applies to the level whose key it was written with.
+    struct scene_snapshot
+    {
+        uint64_t level_hash{0};
+        uint64_t static_objects_offset{0};
+        uint64_t num_dynamic_objects{0};
+        std::vector<scene_snapshot_node> nodes;
+        std::vector<char> names;
+        // In node order, the order node_graph::add_graphics_object requires.
+        std::vector<scene_snapshot_graphics_object> graphics_objects;
+        std::vector<surface_graphics_data> surfaces;
+
+        void clear();
+        [[nodiscard]] result write(const std::shared_ptr<rosy_logger::log>& l, const std::string& path) const;
+        // Fails with result::invalid_state when the file is from another version or another level.
+        [[nodiscard]] result read(const std::shared_ptr<rosy_logger::log>& l, const std::string& path, uint64_t expected_level_hash);
+    };
+
+    // Keys the snapshot of a level on the file it is loaded from, its placed models as serialized and the asset files those models come
+    // from. Asset files are identified by path, size and last write time so nothing is read or traversed to key a level.
+    [[nodiscard]] scene_snapshot_key make_scene_snapshot_key(const std::string& source_path, std::string_view placed_models,
+                                                             std::span<const std::string> asset_paths);
+}
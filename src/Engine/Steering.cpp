@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "Steering.h"
+#include <cmath>
+
+using namespace rosy;
+
+namespace
+{
+    // Below this distance a mob has arrived and its facing is left alone.
+    constexpr float arrived_distance_squared{1e-12f};
+}
+
+void rosy::steer(const steering_batch& b)
+{
+    const float t = b.t;
+    for (size_t i{0}; i < b.count; i++)
+    {
+        const float px = b.position_x[i];
+        const float py = b.position_y[i];
+        const float pz = b.position_z[i];
+        const float dx = b.target_x[i] - px;
+        const float dy = b.target_y[i] - py;
+        const float dz = b.target_z[i] - pz;
+        const float distance_squared = dx * dx + dy * dy + dz * dz;
+        const bool has_moved = distance_squared > arrived_distance_squared;
+
+        // Selects rather than branches so every lane computes the same instructions.
+        const float inverse_distance = has_moved ? 1.f / std::sqrt(distance_squared) : 0.f;
+        const float cos_theta = std::clamp(dz * inverse_distance, -1.f, 1.f);
+        const float sign = dx > 0.f ? -1.f : 1.f;
+        const float yaw = sign * std::acos(cos_theta);
+        const float step = has_moved ? t : 0.f;
+
+        b.new_position_x[i] = px + dx * step;
+        b.new_position_y[i] = py + dy * step;
+        b.new_position_z[i] = pz + dz * step;
+        b.yaws[i] = has_moved ? yaw : b.yaws[i];
+        b.moved[i] = has_moved ? 1 : 0;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Types.h"
+
+namespace rosy
+{
+    // Moves a batch of mobs toward their targets. Every array has count elements laid out one component per array, so the loop
+    // has no branches or gathers and is vectorized by the compiler, including the acos.
+    struct steering_batch
+    {
+        size_t count{0};
+        // Fraction of the remaining distance covered this step, the simulation step's delta time for the game's lerp toward a target.
+        float t{0.f};
+        const float* position_x{nullptr};
+        const float* position_y{nullptr};
+        const float* position_z{nullptr};
+        const float* target_x{nullptr};
+        const float* target_y{nullptr};
+        const float* target_z{nullptr};
+        // Outputs, a mob already at its target keeps its position and yaw and has moved set to 0.
+        float* new_position_x{nullptr};
+        float* new_position_y{nullptr};
+        float* new_position_z{nullptr};
+        float* yaws{nullptr}; // each mob's current yaw, overwritten for mobs that moved
+        uint8_t* moved{nullptr};
+    };
+
+    // Yaw faces the game's forward, +z, toward the target: a rotation about -y by the angle between forward and the direction
+    // to the target, negative when the target is toward +x.
+    void steer(const steering_batch& b);
+}
@@ -0,0 +1,287 @@
+#pragma once
+#include "Transforms.h"
+#include <math.h>
+
+// Kernel templates shared by Transforms.cpp and TransformsAvx2.cpp. A lanes type supplies the vector type and its operations and
+// each kernel processes lanes::width nodes at a time, finishing the remainder with scalar_lanes. Everything here has internal
+// linkage so each translation unit, compiled for its own instruction set, keeps its own copy. Nothing here may use the standard
+// library's inline functions or templates, their copies compiled for AVX2 could be the ones the linker keeps for the whole program.
+
+namespace rosy
+{
+    const transform_kernels& avx2_transform_kernels();
+}
+
+namespace
+{
+    struct scalar_lanes
+    {
+        using v = float;
+        static constexpr size_t width{1};
+
+        static v gather(const float* base, const uint32_t* indices, const size_t stride, const size_t element)
+        {
+            return base[static_cast<size_t>(indices[0]) * stride + element];
+        }
+
+        static v set1(const float f) { return f; }
+        static v add(const v a, const v b) { return a + b; }
+        static v sub(const v a, const v b) { return a - b; }
+        static v mul(const v a, const v b) { return a * b; }
+        static v div(const v a, const v b) { return a / b; }
+        static v abs(const v a) { return a < 0.f ? -a : a; }
+        static void store(float* out, const v a) { out[0] = a; }
+    };
+
+    template <typename L>
+    struct lane_mat4
+    {
+        typename L::v m[16];
+    };
+
+    template <typename L>
+    struct lane_vec3
+    {
+        typename L::v x;
+        typename L::v y;
+        typename L::v z;
+    };
+
+    template <typename L>
+    void scatter(float* base, const uint32_t* indices, const size_t stride, const size_t element, const typename L::v value)
+    {
+        alignas(32) float lanes[L::width];
+        L::store(lanes, value);
+        for (size_t k{0}; k < L::width; k++) base[static_cast<size_t>(indices[k]) * stride + element] = lanes[k];
+    }
+
+    template <typename L>
+    lane_mat4<L> load_mat4(const float* base, const uint32_t* indices)
+    {
+        lane_mat4<L> r;
+        for (size_t e{0}; e < 16; e++) r.m[e] = L::gather(base, indices, 16, e);
+        return r;
+    }
+
+    template <typename L>
+    void store_mat4(float* base, const uint32_t* indices, const lane_mat4<L>& a)
+    {
+        for (size_t e{0}; e < 16; e++) scatter<L>(base, indices, 16, e, a.m[e]);
+    }
+
+    template <typename L>
+    lane_mat4<L> multiply(const lane_mat4<L>& a, const lane_mat4<L>& b)
+    {
+        lane_mat4<L> r;
+        for (size_t col{0}; col < 4; col++)
+        {
+            for (size_t row{0}; row < 4; row++)
+            {
+                typename L::v acc = L::mul(a.m[row], b.m[col * 4]);
+                for (size_t k{1}; k < 4; k++) acc = L::add(acc, L::mul(a.m[k * 4 + row], b.m[col * 4 + k]));
+                r.m[col * 4 + row] = acc;
+            }
+        }
+        return r;
+    }
+
+    template <typename L>
+    lane_vec3<L> cross(const lane_vec3<L>& a, const lane_vec3<L>& b)
+    {
+        return {
+            .x = L::sub(L::mul(a.y, b.z), L::mul(a.z, b.y)),
+            .y = L::sub(L::mul(a.z, b.x), L::mul(a.x, b.z)),
+            .z = L::sub(L::mul(a.x, b.y), L::mul(a.y, b.x)),
+        };
+    }
+
+    template <typename L>
+    typename L::v dot(const lane_vec3<L>& a, const lane_vec3<L>& b)
+    {
+        return L::add(L::add(L::mul(a.x, b.x), L::mul(a.y, b.y)), L::mul(a.z, b.z));
+    }
+
+    template <typename L>
+    struct lane_mat3
+    {
+        lane_vec3<L> rows[3];
+    };
+
+    template <typename L>
+    lane_vec3<L> column(const lane_mat4<L>& a, const size_t col)
+    {
+        return {.x = a.m[col * 4], .y = a.m[col * 4 + 1], .z = a.m[col * 4 + 2]};
+    }
+
+    // The rows of the inverse of the upper 3x3 of a, which are also the columns of its normal matrix.
+    template <typename L>
+    lane_mat3<L> inverse_rows(const lane_mat4<L>& a)
+    {
+        const lane_vec3<L> c0 = column<L>(a, 0);
+        const lane_vec3<L> c1 = column<L>(a, 1);
+        const lane_vec3<L> c2 = column<L>(a, 2);
+        lane_mat3<L> inverse{{cross<L>(c1, c2), cross<L>(c2, c0), cross<L>(c0, c1)}};
+        const typename L::v inv_det = L::div(L::set1(1.f), dot<L>(c0, inverse.rows[0]));
+        for (lane_vec3<L>& r : inverse.rows)
+        {
+            r.x = L::mul(r.x, inv_det);
+            r.y = L::mul(r.y, inv_det);
+            r.z = L::mul(r.z, inv_det);
+        }
+        return inverse;
+    }
+
+    template <typename L>
+    void compose_lanes(const rosy::transform_compose_batch& b, const uint32_t* indices)
+    {
+        // Parents are resolved per node first so every lane reads its object space parent from the same array.
+        for (size_t k{0}; k < L::width; k++)
+        {
+            const size_t i = indices[k];
+            if (const uint32_t p = b.parents[i]; p != rosy::transform_no_parent)
+            {
+                const float* parent = b.object_spaces + static_cast<size_t>(p) * 16;
+                float* out = b.object_space_parent_transforms + i * 16;
+                for (size_t e{0}; e < 16; e++) out[e] = parent[e];
+            }
+        }
+        const lane_mat4<L> object_space = multiply<L>(load_mat4<L>(b.object_space_parent_transforms, indices), load_mat4<L>(b.object_space_transforms, indices));
+        store_mat4<L>(b.object_spaces, indices, object_space);
+
+        // translate * rotate yaw about -Y * scale only has seven non trivial entries, so it is folded into the coordinate system product directly.
+        alignas(32) float cosines[L::width];
+        alignas(32) float sines[L::width];
+        for (size_t k{0}; k < L::width; k++)
+        {
+            const float yaw = b.yaws[indices[k]];
+            cosines[k] = cosf(yaw);
+            sines[k] = sinf(yaw);
+        }
+        constexpr uint32_t lane_order[8]{0, 1, 2, 3, 4, 5, 6, 7};
+        const typename L::v s = L::gather(b.scales, indices, 1, 0);
+        const typename L::v sc = L::mul(s, L::gather(cosines, lane_order, 1, 0));
+        const typename L::v ss = L::mul(s, L::gather(sines, lane_order, 1, 0));
+        const typename L::v tx = L::gather(b.translates, indices, 3, 0);
+        const typename L::v ty = L::gather(b.translates, indices, 3, 1);
+        const typename L::v tz = L::gather(b.translates, indices, 3, 2);
+
+        const lane_mat4<L> cs = load_mat4<L>(b.coordinate_systems, indices);
+        lane_mat4<L> trs_cs;
+        for (size_t col{0}; col < 4; col++)
+        {
+            const typename L::v c0 = cs.m[col * 4];
+            const typename L::v c1 = cs.m[col * 4 + 1];
+            const typename L::v c2 = cs.m[col * 4 + 2];
+            const typename L::v c3 = cs.m[col * 4 + 3];
+            trs_cs.m[col * 4] = L::add(L::sub(L::mul(sc, c0), L::mul(ss, c2)), L::mul(tx, c3));
+            trs_cs.m[col * 4 + 1] = L::add(L::mul(s, c1), L::mul(ty, c3));
+            trs_cs.m[col * 4 + 2] = L::add(L::add(L::mul(ss, c0), L::mul(sc, c2)), L::mul(tz, c3));
+            trs_cs.m[col * 4 + 3] = c3;
+        }
+        store_mat4<L>(b.world_transforms, indices, multiply<L>(trs_cs, object_space));
+    }
+
+    template <typename L>
+    void affine_inverse_lanes(const uint32_t* indices, const float* transforms, float* inverses)
+    {
+        const lane_mat4<L> a = load_mat4<L>(transforms, indices);
+        const lane_mat3<L> inverse = inverse_rows<L>(a);
+        const lane_vec3<L>* rows = inverse.rows;
+        const lane_vec3<L> t = column<L>(a, 3);
+        const typename L::v zero = L::set1(0.f);
+        for (size_t row{0}; row < 3; row++)
+        {
+            scatter<L>(inverses, indices, 16, row, rows[row].x);
+            scatter<L>(inverses, indices, 16, 4 + row, rows[row].y);
+            scatter<L>(inverses, indices, 16, 8 + row, rows[row].z);
+            scatter<L>(inverses, indices, 16, 12 + row, L::sub(zero, dot<L>(rows[row], t)));
+        }
+        for (size_t col{0}; col < 3; col++) scatter<L>(inverses, indices, 16, col * 4 + 3, zero);
+        scatter<L>(inverses, indices, 16, 15, L::set1(1.f));
+    }
+
+    template <typename L>
+    void normal_matrix_lanes(const uint32_t* indices, const float* transforms, float* normals)
+    {
+        const lane_mat3<L> inverse = inverse_rows<L>(load_mat4<L>(transforms, indices));
+        const lane_vec3<L>* rows = inverse.rows;
+        for (size_t col{0}; col < 3; col++)
+        {
+            scatter<L>(normals, indices, 9, col * 3, rows[col].x);
+            scatter<L>(normals, indices, 9, col * 3 + 1, rows[col].y);
+            scatter<L>(normals, indices, 9, col * 3 + 2, rows[col].z);
+        }
+    }
+
+    template <typename L>
+    void transform_bounds_lanes(const uint32_t* indices, const float* transforms, const float* bounds, float* world_bounds)
+    {
+        const lane_mat4<L> a = load_mat4<L>(transforms, indices);
+        const typename L::v half = L::set1(0.5f);
+        typename L::v center[3];
+        typename L::v extent[3];
+        for (size_t axis{0}; axis < 3; axis++)
+        {
+            const typename L::v lower = L::gather(bounds, indices, 6, axis);
+            const typename L::v upper = L::gather(bounds, indices, 6, 3 + axis);
+            center[axis] = L::mul(L::add(lower, upper), half);
+            extent[axis] = L::mul(L::sub(upper, lower), half);
+        }
+        for (size_t row{0}; row < 3; row++)
+        {
+            typename L::v c = a.m[12 + row];
+            typename L::v e = L::set1(0.f);
+            for (size_t k{0}; k < 3; k++)
+            {
+                c = L::add(c, L::mul(a.m[k * 4 + row], center[k]));
+                e = L::add(e, L::mul(L::abs(a.m[k * 4 + row]), extent[k]));
+            }
+            scatter<L>(world_bounds, indices, 6, row, L::sub(c, e));
+            scatter<L>(world_bounds, indices, 6, 3 + row, L::add(c, e));
+        }
+    }
+
+    template <typename L>
+    void compose_kernel(const rosy::transform_compose_batch& batch)
+    {
+        size_t n{0};
+        for (; n + L::width <= batch.count; n += L::width) compose_lanes<L>(batch, batch.indices + n);
+        for (; n < batch.count; n++) compose_lanes<scalar_lanes>(batch, batch.indices + n);
+    }
+
+    template <typename L>
+    void affine_inverse_kernel(const uint32_t* indices, const size_t count, const float* transforms, float* inverses)
+    {
+        size_t n{0};
+        for (; n + L::width <= count; n += L::width) affine_inverse_lanes<L>(indices + n, transforms, inverses);
+        for (; n < count; n++) affine_inverse_lanes<scalar_lanes>(indices + n, transforms, inverses);
+    }
+
+    template <typename L>
+    void normal_matrix_kernel(const uint32_t* indices, const size_t count, const float* transforms, float* normals)
+    {
+        size_t n{0};
+        for (; n + L::width <= count; n += L::width) normal_matrix_lanes<L>(indices + n, transforms, normals);
+        for (; n < count; n++) normal_matrix_lanes<scalar_lanes>(indices + n, transforms, normals);
+    }
+
+    template <typename L>
+    void transform_bounds_kernel(const uint32_t* indices, const size_t count, const float* transforms, const float* bounds, float* world_bounds)
+    {
+        size_t n{0};
+        for (; n + L::width <= count; n += L::width) transform_bounds_lanes<L>(indices + n, transforms, bounds, world_bounds);
+        for (; n < count; n++) transform_bounds_lanes<scalar_lanes>(indices + n, transforms, bounds, world_bounds);
+    }
+
+    template <typename L>
+    constexpr rosy::transform_kernels make_transform_kernels(const rosy::transform_isa isa)
+    {
+        return {
+            .isa = isa,
+            .compose = compose_kernel<L>,
+            .affine_inverse = affine_inverse_kernel<L>,
+            .normal_matrix = normal_matrix_kernel<L>,
+            .transform_bounds = transform_bounds_kernel<L>,
+        };
+    }
+}
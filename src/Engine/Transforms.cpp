@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "TransformKernels.h"
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace rosy;
+
+namespace
+{
+    struct sse_lanes
+    {
+        using v = __m128;
+        static constexpr size_t width{4};
+
+        static v gather(const float* base, const uint32_t* indices, const size_t stride, const size_t element)
+        {
+            return _mm_setr_ps(base[indices[0] * stride + element], base[indices[1] * stride + element],
+                               base[indices[2] * stride + element], base[indices[3] * stride + element]);
+        }
+
+        static v set1(const float f) { return _mm_set1_ps(f); }
+        static v add(const v a, const v b) { return _mm_add_ps(a, b); }
+        static v sub(const v a, const v b) { return _mm_sub_ps(a, b); }
+        static v mul(const v a, const v b) { return _mm_mul_ps(a, b); }
+        static v div(const v a, const v b) { return _mm_div_ps(a, b); }
+        static v abs(const v a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+        static void store(float* out, const v a) { _mm_storeu_ps(out, a); }
+    };
+
+#if defined(_MSC_VER)
+#if defined(__clang__)
+    __attribute__((target("xsave")))
+#endif
+    uint64_t os_enabled_state()
+    {
+        return _xgetbv(0);
+    }
+#endif
+
+    bool cpu_supports_avx2()
+    {
+#if defined(_MSC_VER)
+        int info[4]{};
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        constexpr int osxsave_bit{1 << 27};
+        constexpr int avx_bit{1 << 28};
+        if ((info[2] & osxsave_bit) == 0 || (info[2] & avx_bit) == 0) return false;
+        // The OS has to save the upper halves of the YMM registers on a context switch.
+        if ((os_enabled_state() & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        constexpr int avx2_bit{1 << 5};
+        return (info[1] & avx2_bit) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+}
+
+transform_isa rosy::detect_transform_isa()
+{
+    // SSE2 is part of x86_64, so only AVX2 has to be checked for.
+    return cpu_supports_avx2() ? transform_isa::avx2 : transform_isa::sse;
+}
+
+const char* rosy::transform_isa_name(const transform_isa isa)
+{
+    switch (isa)
+    {
+    case transform_isa::scalar:
+        return "scalar";
+    case transform_isa::sse:
+        return "sse";
+    case transform_isa::avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+const transform_kernels& rosy::get_transform_kernels()
+{
+    static const transform_kernels& kernels = get_transform_kernels(detect_transform_isa());
+    return kernels;
+}
+
+const transform_kernels& rosy::get_transform_kernels(const transform_isa isa)
+{
+    static constexpr transform_kernels scalar_kernels = make_transform_kernels<scalar_lanes>(transform_isa::scalar);
+    static constexpr transform_kernels sse_kernels = make_transform_kernels<sse_lanes>(transform_isa::sse);
+    switch (isa)
+    {
+    case transform_isa::scalar:
+        return scalar_kernels;
+    case transform_isa::sse:
+        return sse_kernels;
+    case transform_isa::avx2:
+        return avx2_transform_kernels();
+    }
+    return scalar_kernels;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace rosy
+{
+    // Batched node transform math. Every kernel works over a list of node indices into arrays that hold one value per node:
+    // mat4s are 16 floats column major, mat3s 9 floats column major, translates 3 floats and bounds 6 floats, min then max.
+    // The best instruction set the CPU supports is picked at runtime, the scalar kernels are always available.
+
+    enum class transform_isa : uint8_t
+    {
+        scalar,
+        sse,
+        avx2,
+    };
+
+    constexpr uint32_t transform_no_parent{UINT32_MAX};
+
+    struct transform_compose_batch
+    {
+        const uint32_t* indices{nullptr};
+        size_t count{0};
+        const uint32_t* parents{nullptr}; // transform_no_parent for roots, a parent must be composed in an earlier batch than its children
+        const float* translates{nullptr};
+        const float* scales{nullptr};
+        const float* yaws{nullptr};
+        const float* coordinate_systems{nullptr};
+        const float* object_space_transforms{nullptr};
+        float* object_space_parent_transforms{nullptr}; // read for roots, written from the parent's object space for every other node
+        float* object_spaces{nullptr}; // object space parent * object space transform
+        float* world_transforms{nullptr}; // translate * yaw * scale * coordinate system * object space
+    };
+
+    struct transform_kernels
+    {
+        transform_isa isa{transform_isa::scalar};
+        void (*compose)(const transform_compose_batch& batch){nullptr};
+        // Inverts transforms whose last row is 0, 0, 0, 1.
+        void (*affine_inverse)(const uint32_t* indices, size_t count, const float* transforms, float* inverses){nullptr};
+        // transpose(inverse(mat3(transform))) for lighting normals.
+        void (*normal_matrix)(const uint32_t* indices, size_t count, const float* transforms, float* normals){nullptr};
+        // Tight world space bounds of an object space box, transforming its center and extents (Arvo's method).
+        void (*transform_bounds)(const uint32_t* indices, size_t count, const float* transforms, const float* bounds, float* world_bounds){nullptr};
+    };
+
+    [[nodiscard]] transform_isa detect_transform_isa();
+    [[nodiscard]] const char* transform_isa_name(transform_isa isa);
+    // The kernels for the best instruction set this CPU supports, detected once.
+    [[nodiscard]] const transform_kernels& get_transform_kernels();
+    // The kernels for a specific instruction set, the caller must check it is supported with detect_transform_isa.
+    [[nodiscard]] const transform_kernels& get_transform_kernels(transform_isa isa);
+}
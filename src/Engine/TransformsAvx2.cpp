@@ -0,0 +1,39 @@
+#include "TransformKernels.h"
+#include <immintrin.h>
+
+// Built with AVX2 code generation and without the precompiled header, see premake5.lua. Nothing in this file may run
+// before detect_transform_isa has confirmed the CPU supports AVX2, and nothing with an inline definition outside this file and
+// TransformKernels.h may be included, the linker could keep its AVX2 copy for callers on any CPU.
+
+using namespace rosy;
+
+namespace
+{
+    struct avx2_lanes
+    {
+        using v = __m256;
+        static constexpr size_t width{8};
+
+        static v gather(const float* base, const uint32_t* indices, const size_t stride, const size_t element)
+        {
+            const __m256i offsets = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices)),
+                                                                        _mm256_set1_epi32(static_cast<int>(stride))),
+                                                     _mm256_set1_epi32(static_cast<int>(element)));
+            return _mm256_i32gather_ps(base, offsets, 4);
+        }
+
+        static v set1(const float f) { return _mm256_set1_ps(f); }
+        static v add(const v a, const v b) { return _mm256_add_ps(a, b); }
+        static v sub(const v a, const v b) { return _mm256_sub_ps(a, b); }
+        static v mul(const v a, const v b) { return _mm256_mul_ps(a, b); }
+        static v div(const v a, const v b) { return _mm256_div_ps(a, b); }
+        static v abs(const v a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+        static void store(float* out, const v a) { _mm256_storeu_ps(out, a); }
+    };
+}
+
+const transform_kernels& rosy::avx2_transform_kernels()
+{
+    static constexpr transform_kernels kernels = make_transform_kernels<avx2_lanes>(transform_isa::avx2);
+    return kernels;
+}
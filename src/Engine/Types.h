@@ -4,6 +4,12 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <memory>
+
+namespace rosy_asset
+{
+    struct asset;
+}
 
 // These are type declarations, not default configurations. Configure those in Level.cpp or elsewhere.
 namespace rosy
@@ -34,6 +40,34 @@ namespace rosy
     {
         int max_window_width = 0;
         int max_window_height = 0;
+        // Mips whose largest dimension is at or below this size are uploaded when a level loads, the rest are streamed in afterward.
+        uint32_t texture_streaming_tail_size = 128;
+        // Fraction of VMA's device local heap budget that streamed textures are allowed to grow usage to.
+        float texture_streaming_budget = 0.9f;
+        size_t texture_streaming_bytes_per_frame = 16ULL * 1'024 * 1'024;
+        // Levels whose geometry does not fit these vertex and index pools stream meshes in by cell instead of uploading them all at load.
+        // Static objects are grouped into square cells of mesh_streaming_cell_size in the xz plane, a cell's meshes are streamed in once the
+        // camera is within the load distance of it and evicted once it is past the unload distance. A cell size of 0 disables streaming.
+        size_t mesh_streaming_vertex_pool_size = 512ULL * 1'024 * 1'024;
+        size_t mesh_streaming_index_pool_size = 128ULL * 1'024 * 1'024;
+        float mesh_streaming_cell_size = 32.f;
+        float mesh_streaming_load_distance = 96.f;
+        float mesh_streaming_unload_distance = 128.f;
+        size_t mesh_streaming_bytes_per_frame = 8ULL * 1'024 * 1'024;
+        // Threads flecs splits multi threaded level systems across, 0 picks one per hardware thread and 1 keeps every system on the main thread.
+        uint32_t level_system_threads = 0;
+        // Rate in Hz the level simulation steps at regardless of the frame rate, rendering interpolates between the last two steps.
+        uint32_t simulation_tick_rate = 60;
+        // The level json the editor reads and saves to, or an .rsy asset that is loaded on its own with nothing placed in it.
+        std::string level_path{"level1.json"};
+        // When set the input the level is given is recorded to this file, or played back from this one instead of the window's.
+        std::string input_record_path{};
+        std::string input_replay_path{};
+        // Frames are only rendered while something drawn changes or input arrives. Once nothing has for idle_render_delay seconds
+        // the last image stays on screen and the level is updated idle_update_rate times a second, waiting on input in between.
+        bool render_on_demand = true;
+        float idle_render_delay = 0.5f;
+        uint32_t idle_update_rate = 10;
     };
 
     struct surface_graphics_data
@@ -56,16 +90,35 @@ namespace rosy
         std::array<float, 9> normal_transform{};
     };
 
+    // The part of a graphics object that changes when its node moves, dynamic objects hand only this to the renderer every frame.
+    struct graphics_object_transform
+    {
+        std::array<float, 16> transform{};
+        std::array<float, 16> to_object_space_transform{};
+        std::array<float, 9> normal_transform{};
+    };
+
     struct debug_ui_state
     {
         bool lighting_tools_open{false};
         bool fragment_tools_open{false};
+
+        [[nodiscard]] bool operator==(const debug_ui_state& other) const = default;
+    };
+
+    // A run of graphics objects, relative to graphics_object_update::offset, whose transforms changed.
+    struct graphics_object_range
+    {
+        size_t first{0};
+        size_t count{0};
     };
 
     struct graphics_object_update
     {
         size_t offset{0};
-        std::vector<graphics_object> graphic_objects{};
+        // Every dynamic graphics object, only the entries covered by dirty_ranges changed since the last update.
+        std::vector<graphics_object_transform> graphic_objects{};
+        std::vector<graphics_object_range> dirty_ranges{};
         std::vector<graphics_object> full_scene{};
     };
 
@@ -95,6 +148,8 @@ namespace rosy
         std::array<float, 16> transform{};
         std::array<float, 4> color{};
         uint32_t flags{0};
+
+        [[nodiscard]] bool operator==(const debug_object& other) const = default;
     };
 
     struct read_camera
@@ -126,6 +181,8 @@ namespace rosy
         std::array<float, 4> position{};
         float pitch{0.f};
         float yaw{0.f};
+
+        [[nodiscard]] bool operator==(const read_camera& other) const = default;
     };
 
     struct light_read_write_state
@@ -149,6 +206,8 @@ namespace rosy
         bool ignore_asset_tangent_sign{false};
         bool ensure_orthogonal_bitangent{false};
         bool brdf_lighting_enabled{false};
+
+        [[nodiscard]] bool operator==(const light_read_write_state& other) const = default;
     };
 
     struct light_debug_state
@@ -161,6 +220,8 @@ namespace rosy
         bool enable_sun_debug{false};
         bool enable_light_perspective{false};
         float orthographic_depth{0};
+
+        [[nodiscard]] bool operator==(const light_debug_state& other) const = default;
     };
 
     struct draw_config_state
@@ -169,6 +230,8 @@ namespace rosy
         bool cull_enabled{false};
         bool wire_enabled{false};
         bool thick_wire_lines{false};
+
+        [[nodiscard]] bool operator==(const draw_config_state& other) const = default;
     };
 
     struct fragment_config_state
@@ -190,11 +253,13 @@ namespace rosy
         bool tangent_space_enabled{false};
         bool shadows_enabled{false};
         bool normal_maps_enabled{false};
+
+        [[nodiscard]] bool operator==(const fragment_config_state& other) const = default;
     };
 
     struct mob_state
     {
-        std::string name;
+        std::string name; // copied so the render thread's copy stays valid while the level changes
         std::array<float, 3> position;
         float yaw{0.f};
         std::array<float, 3> target{0.f, 0.f, 0.f};
@@ -210,7 +275,6 @@ namespace rosy
 
     struct mob_read_state
     {
-        bool clear_edits{false};
         std::vector<mob_state> mob_states{};
     };
 
@@ -313,7 +377,7 @@ namespace rosy
         std::string id{};
         std::string name{};
         std::vector<model_description> models;
-        const void* asset{nullptr};
+        std::shared_ptr<const rosy_asset::asset> asset{};
     };
 
     struct saved_view
@@ -322,11 +386,20 @@ namespace rosy
         size_t view_index;
     };
 
+    // Where a level asset's built scene is saved and the hash it is saved with, a snapshot with another hash is rebuilt.
+    struct scene_snapshot_key
+    {
+        std::string path{};
+        uint64_t hash{0};
+    };
+
     struct level_editor_state
     {
         std::vector<saved_view> saved_views;
         std::vector<asset_description> assets;
-        const void* new_asset{nullptr};
+        // Shared so the render thread's copy keeps the asset alive while it uploads it, whatever the editor loads meanwhile.
+        std::shared_ptr<const rosy_asset::asset> new_asset{};
+        scene_snapshot_key new_asset_snapshot{};
         level_data current_level_data{};
         bool load_saved_view{false};
     };
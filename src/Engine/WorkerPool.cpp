@@ -0,0 +1,114 @@
+#include "pch.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace rosy;
+
+struct worker_pool_state
+{
+    std::vector<std::jthread> threads;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+
+    // The job being run, written under the mutex before generation is bumped.
+    void* context{nullptr};
+    void (*call)(void*, size_t, size_t){nullptr};
+    size_t count{0};
+    size_t chunk_size{1};
+    std::atomic<size_t> next_chunk{0};
+    uint64_t generation{0};
+    size_t workers_running{0};
+    bool stopping{false};
+
+    void run_chunks()
+    {
+        while (true)
+        {
+            const size_t begin = next_chunk.fetch_add(1, std::memory_order_relaxed) * chunk_size;
+            if (begin >= count) return;
+            call(context, begin, std::min(count, begin + chunk_size));
+        }
+    }
+
+    void work()
+    {
+        uint64_t seen_generation{0};
+        while (true)
+        {
+            {
+                std::unique_lock lock{mutex};
+                work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+                if (stopping) return;
+                seen_generation = generation;
+            }
+            run_chunks();
+            {
+                std::lock_guard lock{mutex};
+                workers_running -= 1;
+            }
+            work_done.notify_one();
+        }
+    }
+};
+
+result worker_pool::init(const std::shared_ptr<rosy_logger::log>& new_log, const uint32_t num_threads)
+{
+    l = new_log;
+    if (ws = new(std::nothrow) worker_pool_state; ws == nullptr)
+    {
+        l->error("Error allocating worker pool state");
+        return result::allocation_failure;
+    }
+    const uint32_t hardware_threads = std::thread::hardware_concurrency();
+    const uint32_t thread_count = num_threads > 0 ? num_threads : (hardware_threads > 1 ? hardware_threads - 1 : 0);
+    ws->threads.reserve(thread_count);
+    for (uint32_t i{0}; i < thread_count; i++) ws->threads.emplace_back([state = ws] { state->work(); });
+    l->info(std::format("worker pool started {} threads", thread_count));
+    return result::ok;
+}
+
+void worker_pool::deinit()
+{
+    if (ws == nullptr) return;
+    {
+        std::lock_guard lock{ws->mutex};
+        ws->stopping = true;
+    }
+    ws->work_ready.notify_all();
+    ws->threads.clear(); // jthreads join
+    delete ws;
+    ws = nullptr;
+}
+
+size_t worker_pool::num_workers() const
+{
+    return ws == nullptr ? 0 : ws->threads.size();
+}
+
+void worker_pool::run(const size_t count, const size_t chunk_size, void* context, void (*call)(void*, size_t, size_t)) const
+{
+    if (count == 0) return;
+    if (ws == nullptr || ws->threads.empty() || count <= chunk_size)
+    {
+        call(context, 0, count);
+        return;
+    }
+    {
+        std::lock_guard lock{ws->mutex};
+        ws->context = context;
+        ws->call = call;
+        ws->count = count;
+        ws->chunk_size = std::max(static_cast<size_t>(1), chunk_size);
+        ws->next_chunk.store(0, std::memory_order_relaxed);
+        ws->workers_running = ws->threads.size();
+        ws->generation += 1;
+    }
+    ws->work_ready.notify_all();
+    ws->run_chunks();
+    std::unique_lock lock{ws->mutex};
+    ws->work_done.wait(lock, [&] { return ws->workers_running == 0; });
+}
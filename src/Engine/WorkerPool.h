@@ -0,0 +1,34 @@
+#pragma once
+#include "Types.h"
+#include "Logger/Logger.h"
+
+struct worker_pool_state;
+
+namespace rosy
+{
+    // A fixed set of worker threads for splitting frame work into chunks. parallel_for blocks until every chunk has run, the
+    // calling thread works on chunks too. Chunks are handed out in any order, so callers must only write state owned by the chunk.
+    struct worker_pool
+    {
+        std::shared_ptr<rosy_logger::log> l{nullptr};
+        worker_pool_state* ws{nullptr};
+
+        // num_threads 0 uses one less than the hardware concurrency, leaving a core for the calling thread.
+        [[nodiscard]] result init(const std::shared_ptr<rosy_logger::log>& new_log, uint32_t num_threads = 0);
+        void deinit();
+        [[nodiscard]] size_t num_workers() const;
+
+        // Calls fn(begin, end) for consecutive chunks of at most chunk_size covering [0, count).
+        template <typename F>
+        void parallel_for(const size_t count, const size_t chunk_size, F&& fn) const
+        {
+            run(count, chunk_size, &fn, [](void* context, const size_t begin, const size_t end)
+            {
+                (*static_cast<std::remove_reference_t<F>*>(context))(begin, end);
+            });
+        }
+
+    private:
+        void run(size_t count, size_t chunk_size, void* context, void (*call)(void*, size_t, size_t)) const;
+    };
+}
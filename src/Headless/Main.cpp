@@ -0,0 +1,337 @@
+#include "pch.h"
+#include <charconv>
+#include <sstream>
+#include "Engine/Level.h"
+#include "Engine/Allocations.h"
+#include "Engine/Math.h"
+#include "Engine/InputRecording.h"
+
+using namespace rosy;
+
+// Runs a level with no window and no graphics device. The level is built from its level json or an .rsy asset, stepped one fixed
+// simulation tick at a time with scripted input, then per system timing, heap allocations and throughput are reported, so gameplay
+// performance can be measured on machines without a GPU.
+// Usage: Headless.exe [level json or .rsy] [ticks] [script | --replay <input recording>]
+// A script has one input per line, starting with the tick it is given before. Blank lines and lines starting with # are skipped.
+//   <tick> click <x> <y>                     a left click at a point of the viewport, which sends rosy there
+//   <tick> target <mob index> <x> <y> <z>    sends a mob toward a world space position
+// Without a script rosy is sent somewhere new every 120 ticks. Exits with 1 when a tick after the warm up allocates.
+// An input recording made with Rosy.exe --record is replayed a frame at a time with the input, dt and viewport each frame had, the
+// first frame loading the level as it did when recorded. Ticks then caps how many frames after the first are replayed.
+
+namespace
+{
+    constexpr uint32_t viewport_width{1'280};
+    constexpr uint32_t viewport_height{720};
+    // Ticks after the level loads in which the level may still grow its per tick buffers, as the engine allows after a load.
+    constexpr uint64_t allocation_warm_up_ticks{120};
+    constexpr uint64_t default_click_interval{120};
+
+    struct scripted_input
+    {
+        enum class input_type : uint8_t
+        {
+            click,
+            target,
+        };
+
+        uint64_t tick{0};
+        input_type type{input_type::click};
+        size_t mob_index{0};
+        std::array<float, 3> position{};
+    };
+
+    [[nodiscard]] result read_script(const std::shared_ptr<rosy_logger::log>& l, const std::string& path, std::vector<scripted_input>& inputs)
+    {
+        std::ifstream i(path);
+        if (!i)
+        {
+            l->error(std::format("Error opening script {}", path));
+            return result::open_failed;
+        }
+        std::string line;
+        size_t line_number{0};
+        while (std::getline(i, line))
+        {
+            line_number += 1;
+            if (line.empty() || line.starts_with('#')) continue;
+            std::istringstream words(line);
+            scripted_input input{};
+            std::string type;
+            if (!(words >> input.tick >> type))
+            {
+                l->error(std::format("Error reading line {} of script {}", line_number, path));
+                return result::read_failed;
+            }
+            if (type == "click")
+            {
+                input.type = scripted_input::input_type::click;
+                if (!(words >> input.position[0] >> input.position[1]))
+                {
+                    l->error(std::format("Error reading the click on line {} of script {}", line_number, path));
+                    return result::read_failed;
+                }
+            }
+            else if (type == "target")
+            {
+                input.type = scripted_input::input_type::target;
+                if (!(words >> input.mob_index >> input.position[0] >> input.position[1] >> input.position[2]))
+                {
+                    l->error(std::format("Error reading the target on line {} of script {}", line_number, path));
+                    return result::read_failed;
+                }
+            }
+            else
+            {
+                l->error(std::format("Unknown input {} on line {} of script {}", type, line_number, path));
+                return result::invalid_argument;
+            }
+            inputs.push_back(input);
+        }
+        std::ranges::stable_sort(inputs, {}, &scripted_input::tick);
+        return result::ok;
+    }
+
+    // Clicks around the viewport, far enough apart that rosy crosses the floor between them.
+    void default_script(const uint64_t num_ticks, std::vector<scripted_input>& inputs)
+    {
+        constexpr std::array<std::array<float, 2>, 6> spots{
+            {
+                {0.5f, 0.75f},
+                {0.2f, 0.6f},
+                {0.8f, 0.55f},
+                {0.35f, 0.9f},
+                {0.65f, 0.4f},
+                {0.5f, 0.5f},
+            }
+        };
+        for (uint64_t tick{0}; tick < num_ticks; tick += default_click_interval)
+        {
+            const auto& [x, y] = spots[(tick / default_click_interval) % spots.size()];
+            inputs.push_back({
+                .tick = tick,
+                .type = scripted_input::input_type::click,
+                .position = {x * static_cast<float>(viewport_width), y * static_cast<float>(viewport_height), 0.f},
+            });
+        }
+    }
+
+    [[nodiscard]] result apply_input(level& lvl, const scripted_input& input)
+    {
+        if (input.type == scripted_input::input_type::target) return lvl.set_mob_target(input.mob_index, input.position);
+        SDL_Event event{};
+        event.type = SDL_EVENT_MOUSE_BUTTON_DOWN;
+        event.button.button = SDL_BUTTON_LEFT;
+        event.button.down = true;
+        event.button.clicks = 1;
+        event.button.x = input.position[0];
+        event.button.y = input.position[1];
+        return lvl.process_sdl_event(event);
+    }
+
+    // Gives the level a recorded frame's events, the ones after next_event.
+    [[nodiscard]] result replay_events(level& lvl, const input_recording& recording, const recorded_frame& f, size_t& next_event)
+    {
+        for (const size_t end = next_event + f.num_events; next_event < end; next_event++)
+        {
+            if (const auto res = lvl.process_sdl_event(input_recording::to_sdl_event(recording.events[next_event])); res != result::ok) return res;
+        }
+        return result::ok;
+    }
+
+    // The level's part of an engine frame, everything but presenting it.
+    [[nodiscard]] result run_tick(level& lvl, read_level_state& published, const uint32_t width, const uint32_t height, const double dt)
+    {
+        if (const auto res = lvl.setup_frame(); res != result::ok) return res;
+        if (const auto res = lvl.update(width, height, dt); res != result::ok) return res;
+        if (const auto res = lvl.process(); res != result::ok) return res;
+        lvl.publish(published);
+        return result::ok;
+    }
+
+    [[nodiscard]] int run(const std::shared_ptr<rosy_logger::log>& l, level& lvl, const config& cfg, const uint64_t num_ticks,
+                          std::vector<scripted_input>& inputs, const input_recording* replay)
+    {
+        read_level_state published{};
+        size_t next_event{0};
+        {
+            // The first update reads the level and builds it from its assets.
+            double load_dt{0.0};
+            uint32_t load_width{viewport_width};
+            uint32_t load_height{viewport_height};
+            if (replay != nullptr)
+            {
+                const recorded_frame& f = replay->frames.front();
+                if (const auto res = replay_events(lvl, *replay, f, next_event); res != result::ok)
+                {
+                    l->error(std::format("Error replaying the first frame: {}", static_cast<uint8_t>(res)));
+                    return 1;
+                }
+                load_dt = f.dt;
+                load_width = f.viewport_width;
+                load_height = f.viewport_height;
+            }
+            if (const auto res = run_tick(lvl, published, load_width, load_height, load_dt); res != result::ok)
+            {
+                l->error(std::format("Error loading level {}: {}", cfg.level_path, static_cast<uint8_t>(res)));
+                return 1;
+            }
+            if (published.editor_state.new_asset == nullptr)
+            {
+                l->error(std::format("Level {} did not load", cfg.level_path));
+                return 1;
+            }
+        }
+        if (inputs.empty() && replay == nullptr) default_script(num_ticks, inputs);
+        const char* step = replay == nullptr ? "tick" : "frame";
+
+        const double dt = 1.0 / static_cast<double>(std::max(1u, cfg.simulation_tick_rate));
+        std::vector<double> tick_ms;
+        tick_ms.reserve(num_ticks);
+        uint64_t allocations{0};
+        uint64_t steady_allocations{0};
+        uint64_t steady_allocating_ticks{0};
+        size_t next_input{0};
+        double simulated_seconds{0.0};
+        lvl.measure_system_time(true);
+        const auto run_start = std::chrono::high_resolution_clock::now();
+        for (uint64_t tick{0}; tick < num_ticks; tick++)
+        {
+            const uint64_t allocations_start = heap_allocation_count();
+            const auto tick_start = std::chrono::high_resolution_clock::now();
+            for (; next_input < inputs.size() && inputs[next_input].tick <= tick; next_input++)
+            {
+                if (const auto res = apply_input(lvl, inputs[next_input]); res != result::ok)
+                {
+                    l->error(std::format("Error applying the scripted input for tick {}: {}", inputs[next_input].tick, static_cast<uint8_t>(res)));
+                    return 1;
+                }
+            }
+            double tick_dt{dt};
+            uint32_t tick_width{viewport_width};
+            uint32_t tick_height{viewport_height};
+            if (replay != nullptr)
+            {
+                const recorded_frame& f = replay->frames[tick + 1];
+                if (const auto res = replay_events(lvl, *replay, f, next_event); res != result::ok)
+                {
+                    l->error(std::format("Error replaying frame {}: {}", tick + 1, static_cast<uint8_t>(res)));
+                    return 1;
+                }
+                tick_dt = f.dt;
+                tick_width = f.viewport_width;
+                tick_height = f.viewport_height;
+            }
+            simulated_seconds += tick_dt;
+            if (const auto res = run_tick(lvl, published, tick_width, tick_height, tick_dt); res != result::ok)
+            {
+                l->error(std::format("Error running {} {}: {}", step, tick, static_cast<uint8_t>(res)));
+                return 1;
+            }
+            const auto tick_end = std::chrono::high_resolution_clock::now();
+            tick_ms.push_back(std::chrono::duration<double, std::milli>(tick_end - tick_start).count());
+            const uint64_t tick_allocations = heap_allocation_count() - allocations_start;
+            allocations += tick_allocations;
+            if (tick >= allocation_warm_up_ticks && tick_allocations > 0)
+            {
+                steady_allocations += tick_allocations;
+                steady_allocating_ticks += 1;
+            }
+        }
+        const auto run_end = std::chrono::high_resolution_clock::now();
+        const double run_ms = std::chrono::duration<double, std::milli>(run_end - run_start).count();
+
+        std::vector<level_system_time> system_times;
+        lvl.get_system_times(system_times);
+        std::vector<double> sorted_ms = tick_ms;
+        std::ranges::sort(sorted_ms);
+
+        const double ticks = static_cast<double>(std::max(static_cast<uint64_t>(1), num_ticks));
+        const size_t num_mobs = lvl.num_mobs();
+        const double ticks_per_second = ticks / (run_ms / 1000.0);
+        if (replay == nullptr)
+        {
+            std::cout << std::format("{}: {} mobs, {} ticks at {} Hz, {} scripted inputs\n", cfg.level_path, num_mobs, num_ticks, cfg.simulation_tick_rate,
+                                     next_input);
+        }
+        else
+        {
+            std::cout << std::format("{}: {} mobs, {} recorded frames at {} Hz, {} recorded events\n", cfg.level_path, num_mobs, num_ticks,
+                                     cfg.simulation_tick_rate, next_event);
+        }
+        std::cout << std::format("  {:<11} mean {:8.4f} ms  p50 {:8.4f} ms  p99 {:8.4f} ms  max {:8.4f} ms\n", step, run_ms / ticks, percentile(sorted_ms, 0.5),
+                                 percentile(sorted_ms, 0.99), sorted_ms.empty() ? 0.0 : sorted_ms.back());
+        std::cout << std::format("  throughput  {:.0f} {}s/s  {:.0f} mob {}s/s  {:.1f}x real time\n", ticks_per_second, step,
+                                 ticks_per_second * static_cast<double>(num_mobs), step, simulated_seconds / (run_ms / 1000.0));
+        std::cout << std::format("  allocations {} in all {}s, {} in {} {}s after the first {} (counted in debug builds)\n", allocations, step, steady_allocations,
+                                 steady_allocating_ticks, step, allocation_warm_up_ticks);
+        std::cout << "  systems\n";
+        for (const auto& [name, seconds] : system_times)
+        {
+            const double system_ms = seconds * 1000.0;
+            std::cout << std::format("    {:<24} {:10.3f} ms  {:8.2f} us/{:<5}  {:5.1f}%\n", name, system_ms, system_ms * 1000.0 / ticks, step,
+                                     system_ms / run_ms * 100.0);
+        }
+        return steady_allocating_ticks > 0 ? 1 : 0;
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    std::shared_ptr<rosy_logger::log> l{nullptr};
+    try { l = std::make_shared<rosy_logger::log>(); }
+    catch (const std::bad_alloc&) {
+        return 1;
+    }
+
+    config cfg{};
+    cfg.max_window_width = static_cast<int>(viewport_width);
+    cfg.max_window_height = static_cast<int>(viewport_height);
+    if (argc > 1) cfg.level_path = argv[1];
+    uint64_t num_ticks{3'600};
+    bool valid_ticks{true};
+    if (argc > 2)
+    {
+        const std::string_view ticks_arg{argv[2]};
+        const auto [end, ec] = std::from_chars(ticks_arg.data(), ticks_arg.data() + ticks_arg.size(), num_ticks);
+        valid_ticks = ec == std::errc{} && end == ticks_arg.data() + ticks_arg.size();
+    }
+    const bool replaying = argc > 3 && std::string_view{argv[3]} == "--replay";
+    if (!valid_ticks || num_ticks == 0 || (replaying && argc < 5))
+    {
+        std::cout << "usage: Headless.exe [level json or .rsy] [ticks] [script | --replay <input recording>]\n";
+        return 1;
+    }
+    std::vector<scripted_input> inputs;
+    input_recording recording{};
+    if (replaying)
+    {
+        if (const auto res = recording.read(l, argv[4]); res != result::ok) return 1;
+        if (recording.frames.empty())
+        {
+            l->error(std::format("Input recording {} has no frames", argv[4]));
+            return 1;
+        }
+        if (recording.level_path != cfg.level_path)
+        {
+            l->warn(std::format("input recording {} was made in {}, replaying it in {}", argv[4], recording.level_path, cfg.level_path));
+        }
+        cfg.simulation_tick_rate = recording.simulation_tick_rate;
+        num_ticks = std::min(num_ticks, static_cast<uint64_t>(recording.frames.size() - 1));
+    }
+    else if (argc > 3)
+    {
+        if (const auto res = read_script(l, argv[3], inputs); res != result::ok) return 1;
+    }
+
+    level lvl{};
+    if (const auto res = lvl.init(l, cfg); res != result::ok)
+    {
+        l->error(std::format("Level creation failed: {}", static_cast<uint8_t>(res)));
+        lvl.deinit();
+        return 1;
+    }
+    const int exit_code = run(l, lvl, cfg, num_ticks, inputs, replaying ? &recording : nullptr);
+    lvl.deinit();
+    return exit_code;
+}
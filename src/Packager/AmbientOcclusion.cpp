@@ -0,0 +1,411 @@
+#include "pch.h"
+#include "AmbientOcclusion.h"
+#include <atomic>
+#include <thread>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace rosy_packager;
+
+namespace
+{
+    constexpr uint32_t bvh_leaf_size{8};
+    constexpr uint32_t bvh_num_bins{16};
+    constexpr uint32_t bvh_max_depth{64};
+    constexpr uint32_t bake_chunk_size{256};
+
+    struct bvh_node
+    {
+        glm::vec3 min{0.f};
+        uint32_t first{0}; // first triangle of a leaf or the left child of an interior node, the right child is always first + 1
+        glm::vec3 max{0.f};
+        uint32_t count{0}; // number of triangles in a leaf, 0 for interior nodes
+    };
+
+    // Leaf triangles are stored as structure of arrays, pre-transformed into a vertex and two edges, so the intersection loop over a leaf
+    // reads contiguous floats and has no early out that would stop the compiler from vectorizing it.
+    struct bvh_triangles
+    {
+        std::vector<float> v0_x;
+        std::vector<float> v0_y;
+        std::vector<float> v0_z;
+        std::vector<float> e1_x;
+        std::vector<float> e1_y;
+        std::vector<float> e1_z;
+        std::vector<float> e2_x;
+        std::vector<float> e2_y;
+        std::vector<float> e2_z;
+    };
+
+    struct bvh
+    {
+        std::vector<bvh_node> nodes;
+        bvh_triangles triangles;
+    };
+
+    struct build_triangle
+    {
+        glm::vec3 v0{0.f};
+        glm::vec3 v1{0.f};
+        glm::vec3 v2{0.f};
+        glm::vec3 centroid{0.f};
+        glm::vec3 min{0.f};
+        glm::vec3 max{0.f};
+    };
+
+    struct build_task
+    {
+        uint32_t node_index{0};
+        uint32_t first{0};
+        uint32_t count{0};
+        uint32_t depth{0};
+    };
+
+    struct build_bin
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+        uint32_t count{0};
+    };
+
+    float surface_area(const glm::vec3& min, const glm::vec3& max)
+    {
+        const glm::vec3 d = glm::max(max - min, glm::vec3{0.f});
+        return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    // Binned surface area heuristic build, splits that fail to separate triangles fall back to a median split.
+    bvh build_bvh(std::vector<build_triangle>& tris)
+    {
+        bvh b{};
+        if (tris.empty()) return b;
+        b.nodes.reserve(tris.size() / bvh_leaf_size * 2 + 1);
+        b.nodes.emplace_back();
+
+        std::stack<build_task> tasks;
+        tasks.push({.node_index = 0, .first = 0, .count = static_cast<uint32_t>(tris.size()), .depth = 0});
+        while (!tasks.empty())
+        {
+            const auto [node_index, first, count, depth] = tasks.top();
+            tasks.pop();
+
+            glm::vec3 bounds_min{std::numeric_limits<float>::max()};
+            glm::vec3 bounds_max{std::numeric_limits<float>::lowest()};
+            glm::vec3 centroid_min{std::numeric_limits<float>::max()};
+            glm::vec3 centroid_max{std::numeric_limits<float>::lowest()};
+            for (uint32_t i{first}; i < first + count; i++)
+            {
+                bounds_min = glm::min(bounds_min, tris[i].min);
+                bounds_max = glm::max(bounds_max, tris[i].max);
+                centroid_min = glm::min(centroid_min, tris[i].centroid);
+                centroid_max = glm::max(centroid_max, tris[i].centroid);
+            }
+            b.nodes[node_index].min = bounds_min;
+            b.nodes[node_index].max = bounds_max;
+
+            const glm::vec3 extent = centroid_max - centroid_min;
+            int axis{0};
+            if (extent.y > extent[axis]) axis = 1;
+            if (extent.z > extent[axis]) axis = 2;
+            if (count <= bvh_leaf_size || depth >= bvh_max_depth || extent[axis] <= 0.f)
+            {
+                b.nodes[node_index].first = first;
+                b.nodes[node_index].count = count;
+                continue;
+            }
+
+            std::array<build_bin, bvh_num_bins> bins{};
+            const float bin_scale = static_cast<float>(bvh_num_bins) / extent[axis];
+            const auto bin_of = [&](const build_triangle& t) -> uint32_t
+            {
+                const auto bin = static_cast<uint32_t>((t.centroid[axis] - centroid_min[axis]) * bin_scale);
+                return std::min(bin, bvh_num_bins - 1);
+            };
+            for (uint32_t i{first}; i < first + count; i++)
+            {
+                build_bin& bin = bins[bin_of(tris[i])];
+                bin.min = glm::min(bin.min, tris[i].min);
+                bin.max = glm::max(bin.max, tris[i].max);
+                bin.count += 1;
+            }
+
+            // Sweep from both sides to find the cheapest split plane between bins.
+            std::array<float, bvh_num_bins - 1> left_cost{};
+            {
+                build_bin left{};
+                for (uint32_t i{0}; i < bvh_num_bins - 1; i++)
+                {
+                    left.min = glm::min(left.min, bins[i].min);
+                    left.max = glm::max(left.max, bins[i].max);
+                    left.count += bins[i].count;
+                    left_cost[i] = left.count == 0 ? 0.f : surface_area(left.min, left.max) * static_cast<float>(left.count);
+                }
+            }
+            uint32_t best_split{1};
+            {
+                float best_cost{std::numeric_limits<float>::max()};
+                build_bin right{};
+                for (uint32_t i{bvh_num_bins - 1}; i > 0; i--)
+                {
+                    right.min = glm::min(right.min, bins[i].min);
+                    right.max = glm::max(right.max, bins[i].max);
+                    right.count += bins[i].count;
+                    const float right_cost = right.count == 0 ? 0.f : surface_area(right.min, right.max) * static_cast<float>(right.count);
+                    if (const float cost = left_cost[i - 1] + right_cost; cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_split = i;
+                    }
+                }
+            }
+
+            const auto begin = tris.begin() + first;
+            const auto end = begin + count;
+            auto left_count = static_cast<uint32_t>(std::partition(begin, end, [&](const build_triangle& t) { return bin_of(t) < best_split; }) - begin);
+            if (left_count == 0 || left_count == count)
+            {
+                left_count = count / 2;
+                std::nth_element(begin, begin + left_count, end, [&](const build_triangle& a, const build_triangle& c) { return a.centroid[axis] < c.centroid[axis]; });
+            }
+
+            const auto left_index = static_cast<uint32_t>(b.nodes.size());
+            b.nodes.emplace_back();
+            b.nodes.emplace_back();
+            b.nodes[node_index].first = left_index;
+            b.nodes[node_index].count = 0;
+            tasks.push({.node_index = left_index, .first = first, .count = left_count, .depth = depth + 1});
+            tasks.push({.node_index = left_index + 1, .first = first + left_count, .count = count - left_count, .depth = depth + 1});
+        }
+
+        bvh_triangles& t = b.triangles;
+        for (std::vector<float>* v : {&t.v0_x, &t.v0_y, &t.v0_z, &t.e1_x, &t.e1_y, &t.e1_z, &t.e2_x, &t.e2_y, &t.e2_z}) v->reserve(tris.size());
+        for (const build_triangle& tri : tris)
+        {
+            const glm::vec3 e1 = tri.v1 - tri.v0;
+            const glm::vec3 e2 = tri.v2 - tri.v0;
+            t.v0_x.push_back(tri.v0.x);
+            t.v0_y.push_back(tri.v0.y);
+            t.v0_z.push_back(tri.v0.z);
+            t.e1_x.push_back(e1.x);
+            t.e1_y.push_back(e1.y);
+            t.e1_z.push_back(e1.z);
+            t.e2_x.push_back(e2.x);
+            t.e2_y.push_back(e2.y);
+            t.e2_z.push_back(e2.z);
+        }
+        return b;
+    }
+
+    // A zero direction component would make the slab test multiply 0 by inf for rays starting on a bounds face, the NaN it gives passes
+    // every comparison. A huge finite inverse keeps the slabs of axis aligned rays correct without it.
+    float safe_inverse(const float d)
+    {
+        constexpr float epsilon{1e-30f};
+        return std::abs(d) < epsilon ? std::copysign(1e30f, d) : 1.f / d;
+    }
+
+    bool intersects_bounds(const bvh_node& n, const glm::vec3& origin, const glm::vec3& inv_dir, const float t_max)
+    {
+        const glm::vec3 t0 = (n.min - origin) * inv_dir;
+        const glm::vec3 t1 = (n.max - origin) * inv_dir;
+        const glm::vec3 t_near = glm::min(t0, t1);
+        const glm::vec3 t_far = glm::max(t0, t1);
+        const float enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.f));
+        const float exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, t_max));
+        return enter <= exit;
+    }
+
+    // Möller-Trumbore against every triangle in a leaf without an early out.
+    bool intersects_leaf(const bvh_triangles& t, const uint32_t first, const uint32_t count, const glm::vec3& o, const glm::vec3& d, const float t_min, const float t_max)
+    {
+        bool hit{false};
+        for (uint32_t i{first}; i < first + count; i++)
+        {
+            const float p_x = d.y * t.e2_z[i] - d.z * t.e2_y[i];
+            const float p_y = d.z * t.e2_x[i] - d.x * t.e2_z[i];
+            const float p_z = d.x * t.e2_y[i] - d.y * t.e2_x[i];
+            const float det = t.e1_x[i] * p_x + t.e1_y[i] * p_y + t.e1_z[i] * p_z;
+            const float inv_det = 1.f / det;
+            const float s_x = o.x - t.v0_x[i];
+            const float s_y = o.y - t.v0_y[i];
+            const float s_z = o.z - t.v0_z[i];
+            const float u = (s_x * p_x + s_y * p_y + s_z * p_z) * inv_det;
+            const float q_x = s_y * t.e1_z[i] - s_z * t.e1_y[i];
+            const float q_y = s_z * t.e1_x[i] - s_x * t.e1_z[i];
+            const float q_z = s_x * t.e1_y[i] - s_y * t.e1_x[i];
+            const float v = (d.x * q_x + d.y * q_y + d.z * q_z) * inv_det;
+            const float dist = (t.e2_x[i] * q_x + t.e2_y[i] * q_y + t.e2_z[i] * q_z) * inv_det;
+            hit |= std::abs(det) > 1e-12f && u >= 0.f && v >= 0.f && u + v <= 1.f && dist > t_min && dist < t_max;
+        }
+        return hit;
+    }
+
+    bool occluded(const bvh& b, const glm::vec3& origin, const glm::vec3& dir, const float t_min, const float t_max)
+    {
+        if (b.nodes.empty()) return false;
+        const glm::vec3 inv_dir{safe_inverse(dir.x), safe_inverse(dir.y), safe_inverse(dir.z)};
+        std::array<uint32_t, bvh_max_depth + 2> stack{};
+        uint32_t stack_size{0};
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const bvh_node& n = b.nodes[stack[--stack_size]];
+            if (!intersects_bounds(n, origin, inv_dir, t_max)) continue;
+            if (n.count > 0)
+            {
+                if (intersects_leaf(b.triangles, n.first, n.count, origin, dir, t_min, t_max)) return true;
+                continue;
+            }
+            stack[stack_size++] = n.first;
+            stack[stack_size++] = n.first + 1;
+        }
+        return false;
+    }
+
+    // A stateless hash so every vertex gets the same rays no matter which thread bakes it, keeping bakes reproducible.
+    uint32_t pcg_hash(const uint32_t input)
+    {
+        const uint32_t state = input * 747'796'405u + 2'891'336'453u;
+        const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277'803'737u;
+        return (word >> 22u) ^ word;
+    }
+
+    float to_unit_float(const uint32_t v)
+    {
+        return static_cast<float>(v >> 8) * (1.f / 16'777'216.f);
+    }
+
+    // Cosine weighted direction about the normal using the branchless orthonormal basis from Duff et al. 2017.
+    glm::vec3 cosine_direction(const glm::vec3& n, const float u1, const float u2)
+    {
+        const float sign = std::copysign(1.f, n.z);
+        const float a = -1.f / (sign + n.z);
+        const float b = n.x * n.y * a;
+        const glm::vec3 tangent{1.f + sign * n.x * n.x * a, sign * b, -sign * n.x};
+        const glm::vec3 bitangent{b, sign + n.y * n.y * a, -n.y};
+        const float r = std::sqrt(u1);
+        const float phi = 2.f * std::numbers::pi_v<float> * u2;
+        return glm::normalize(tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + n * std::sqrt(std::max(0.f, 1.f - u1)));
+    }
+}
+
+rosy::result rosy_packager::bake_ambient_occlusion(const std::shared_ptr<rosy_logger::log>& l, rosy_asset::asset& asset, const ambient_occlusion_config& cfg)
+{
+    if (cfg.num_rays == 0)
+    {
+        l->error("ambient occlusion needs at least one ray");
+        return rosy::result::invalid_argument;
+    }
+    if (asset.scenes.empty() || asset.root_scene >= asset.scenes.size())
+    {
+        l->warn("ambient occlusion skipped, the asset has no root scene");
+        return rosy::result::ok;
+    }
+
+    // Gather every instanced triangle in asset space and remember where each mesh is first placed.
+    std::vector<build_triangle> tris;
+    std::vector<std::optional<glm::mat4>> mesh_transforms(asset.meshes.size());
+    {
+        std::stack<std::tuple<uint32_t, glm::mat4>> nodes;
+        for (const uint32_t node_index : asset.scenes[asset.root_scene].nodes) nodes.emplace(node_index, glm::mat4{1.f});
+        while (!nodes.empty())
+        {
+            const auto [node_index, parent_transform] = nodes.top();
+            nodes.pop();
+            if (node_index >= asset.nodes.size()) continue;
+            const rosy_asset::node& n = asset.nodes[node_index];
+            const glm::mat4 transform = parent_transform * glm::make_mat4(n.transform.data());
+            for (const uint32_t child : n.child_nodes) nodes.emplace(child, transform);
+            if (n.mesh_id >= asset.meshes.size()) continue;
+
+            if (!mesh_transforms[n.mesh_id].has_value()) mesh_transforms[n.mesh_id] = transform;
+            const rosy_asset::mesh& m = asset.meshes[n.mesh_id];
+            tris.reserve(tris.size() + m.indices.size() / 3);
+            for (size_t i{0}; i + 2 < m.indices.size(); i += 3)
+            {
+                build_triangle t{};
+                std::array<glm::vec3*, 3> vs{&t.v0, &t.v1, &t.v2};
+                for (size_t j{0}; j < 3; j++)
+                {
+                    const auto& v = m.positions[m.indices[i + j]].vertex;
+                    *vs[j] = glm::vec3{transform * glm::vec4{v[0], v[1], v[2], 1.f}};
+                }
+                t.min = glm::min(glm::min(t.v0, t.v1), t.v2);
+                t.max = glm::max(glm::max(t.v0, t.v1), t.v2);
+                t.centroid = (t.v0 + t.v1 + t.v2) / 3.f;
+                tris.push_back(t);
+            }
+        }
+    }
+    if (tris.empty())
+    {
+        l->warn("ambient occlusion skipped, the root scene has no triangles");
+        return rosy::result::ok;
+    }
+
+    const bvh scene_bvh = build_bvh(tris);
+    const float scene_diagonal = glm::length(scene_bvh.nodes[0].max - scene_bvh.nodes[0].min);
+    const float t_max = scene_diagonal * cfg.max_distance;
+    const float t_min = scene_diagonal * 1e-5f;
+    l->info(std::format("ambient occlusion bvh built with {} triangles and {} nodes", tris.size(), scene_bvh.nodes.size()));
+
+    // Vertices across all meshes are handed out to threads in fixed size chunks.
+    std::vector<size_t> mesh_vertex_offsets(asset.meshes.size() + 1, 0);
+    for (size_t i{0}; i < asset.meshes.size(); i++)
+    {
+        mesh_vertex_offsets[i + 1] = mesh_vertex_offsets[i] + (mesh_transforms[i].has_value() ? asset.meshes[i].positions.size() : 0);
+    }
+    const size_t total_vertices = mesh_vertex_offsets.back();
+    std::vector<glm::mat3> normal_transforms(asset.meshes.size(), glm::mat3{1.f});
+    for (size_t i{0}; i < asset.meshes.size(); i++)
+    {
+        if (mesh_transforms[i].has_value()) normal_transforms[i] = glm::transpose(glm::inverse(glm::mat3{mesh_transforms[i].value()}));
+    }
+
+    std::atomic<size_t> next_chunk{0};
+    const auto bake = [&]
+    {
+        while (true)
+        {
+            const size_t chunk_start = next_chunk.fetch_add(bake_chunk_size);
+            if (chunk_start >= total_vertices) return;
+            const size_t chunk_end = std::min(chunk_start + bake_chunk_size, total_vertices);
+            size_t mesh_index = static_cast<size_t>(std::ranges::upper_bound(mesh_vertex_offsets, chunk_start) - mesh_vertex_offsets.begin()) - 1;
+            for (size_t vertex{chunk_start}; vertex < chunk_end; vertex++)
+            {
+                while (vertex >= mesh_vertex_offsets[mesh_index + 1]) mesh_index += 1;
+                rosy_asset::position& p = asset.meshes[mesh_index].positions[vertex - mesh_vertex_offsets[mesh_index]];
+                const glm::mat4& transform = mesh_transforms[mesh_index].value();
+                const glm::vec3 origin{transform * glm::vec4{p.vertex[0], p.vertex[1], p.vertex[2], 1.f}};
+                glm::vec3 normal = normal_transforms[mesh_index] * glm::vec3{p.normal[0], p.normal[1], p.normal[2]};
+                if (glm::dot(normal, normal) <= 0.f)
+                {
+                    p.occlusion = 1.f;
+                    continue;
+                }
+                normal = glm::normalize(normal);
+                const glm::vec3 ray_origin = origin + normal * t_min;
+
+                uint32_t hits{0};
+                const auto seed = static_cast<uint32_t>(vertex * cfg.num_rays);
+                for (uint32_t ray{0}; ray < cfg.num_rays; ray++)
+                {
+                    const uint32_t h = pcg_hash(seed + ray);
+                    const glm::vec3 dir = cosine_direction(normal, to_unit_float(h), to_unit_float(pcg_hash(h)));
+                    if (occluded(scene_bvh, ray_origin, dir, t_min, t_max)) hits += 1;
+                }
+                p.occlusion = 1.f - static_cast<float>(hits) / static_cast<float>(cfg.num_rays);
+            }
+        }
+    };
+
+    const uint32_t num_threads = cfg.num_threads > 0 ? cfg.num_threads : std::max(1u, std::thread::hardware_concurrency());
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(num_threads - 1);
+        for (uint32_t i{1}; i < num_threads; i++) workers.emplace_back(bake);
+        bake();
+    }
+    l->info(std::format("ambient occlusion baked {} vertices with {} rays each on {} threads", total_vertices, cfg.num_rays, num_threads));
+    return rosy::result::ok;
+}
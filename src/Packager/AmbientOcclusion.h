@@ -0,0 +1,18 @@
+#pragma once
+#include "Asset/Asset.h"
+#include "Logger/Logger.h"
+
+namespace rosy_packager
+{
+    struct ambient_occlusion_config
+    {
+        uint32_t num_rays{64};
+        // Hits further away than this fraction of the scene's bounding box diagonal do not occlude.
+        float max_distance{0.1f};
+        uint32_t num_threads{0}; // 0 uses every hardware thread
+    };
+
+    // Bakes per-vertex ambient occlusion into position::occlusion by casting cosine weighted rays against a BVH of every triangle
+    // in the asset's root scene. A mesh instanced by several nodes is baked where its first node places it.
+    [[nodiscard]] rosy::result bake_ambient_occlusion(const std::shared_ptr<rosy_logger::log>& l, rosy_asset::asset& asset, const ambient_occlusion_config& cfg);
+}
@@ -128,6 +128,7 @@ namespace
             if (attr->GetAttributeType() == FbxNodeAttribute::EType::eMesh)
             {
                 rosy_asset::mesh new_asset_mesh{};
+                std::optional<stage_timer> decode_timer{std::in_place, cfg.profile, "primitive decode", node_name};
                 const FbxMesh* fbx_mesh = p_node->GetMesh();
                 if (!fbx_mesh->IsTriangleMesh())
                 {
@@ -369,9 +370,12 @@ namespace
                     new_asset_mesh.surfaces.emplace_back(s);
                 }
 
+                decode_timer.reset();
+
                 const size_t current_asset_mesh_index = fbx_asset.meshes.size();
                 {
                     // add to meshes
+                    stage_timer optimize_timer{cfg.profile, "mesh optimization", node_name};
                     optimize_mesh(l, new_asset_mesh);
                     fbx_asset.meshes.emplace_back(new_asset_mesh);
                 }
@@ -407,7 +411,7 @@ namespace
 }
 
 
-rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unused]] fbx_config& cfg)
+rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, fbx_config& cfg)
 {
     const std::filesystem::path file_path{source_path};
     {
@@ -418,6 +422,8 @@ rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unu
 
     // IMAGES
 
+    // Images are compressed once meshes and nodes are known so the texture budget can measure texel density.
+    std::vector<texture_job> texture_jobs;
     for (const std::filesystem::path parent_dir = file_path.parent_path(); const auto& entry : std::filesystem::directory_iterator(parent_dir))
     {
         const auto& entry_path = entry.path();
@@ -441,35 +447,21 @@ rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unu
         rosy_asset::image img{};
         if (image_type == "normal.tga")
         {
-            if (const auto res = generate_normal_map_texture(l, entry_path); res != rosy::result::ok)
-            {
-                l->error(std::format("error creating normal fbx image: {} for {}", static_cast<uint8_t>(res), entry_path.filename().string()));
-                return res;
-            }
             img.image_type = rosy_asset::image_type_normal_map;
         }
         if (image_type == "mixmap.tga")
         {
-            if (const auto res = generate_srgb_texture(l, entry_path); res != rosy::result::ok)
-            {
-                l->error(std::format("error creating mixmap fbx image: {} for {}", static_cast<uint8_t>(res), entry_path.filename().string()));
-                return res;
-            }
             img.image_type = rosy_asset::image_type_mixmap;
         }
         if (image_type == "albedo.tga")
         {
-            if (const auto res = generate_srgb_texture(l, entry_path); res != rosy::result::ok)
-            {
-                l->error(std::format("error creating albedo fbx image: {} for {}", static_cast<uint8_t>(res), entry_path.filename().string()));
-                return res;
-            }
             img.image_type = rosy_asset::image_type_color;
         }
 
         std::filesystem::path out_path{ entry_path };
         out_path.replace_extension(".dds");
         std::ranges::copy(out_path.string(), std::back_inserter(img.name));
+        texture_jobs.push_back({.source_path = entry_path, .image_index = static_cast<uint32_t>(fbx_asset.images.size()), .image_type = img.image_type});
         fbx_asset.images.push_back(img);
     }
 
@@ -482,6 +474,7 @@ rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unu
 
     FbxImporter* rsy_importer = FbxImporter::Create(rsy_sdk_manager, "");
 
+    std::optional<stage_timer> parse_timer{std::in_place, cfg.profile, "parse", source_path};
     if (const bool rsy_import_status = rsy_importer->Initialize(file_path.string().c_str(), -1, rsy_sdk_manager->GetIOSettings()); !rsy_import_status)
     {
         l->error("Call to FbxImporter::Initialize() failed.");
@@ -518,6 +511,7 @@ rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unu
         return rosy::result::read_failed;
     }
     rsy_importer->Destroy();
+    parse_timer.reset();
     l->info("importing fbx scene success?");
 
     rosy_asset::scene default_scene{};
@@ -535,10 +529,17 @@ rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unu
 
     rsy_sdk_manager->Destroy();
 
+    if (const auto res = compress_textures(l, fbx_asset, texture_jobs, cfg.texture_budget, cfg.profile); res != rosy::result::ok)
+    {
+        l->error("Error compressing fbx images");
+        return res;
+    }
+
     // TANGENTS
 
     if (cfg.use_mikktspace)
     {
+        stage_timer tangent_timer{cfg.profile, "tangent generation", source_path};
         if (const auto res = generate_tangents(l, fbx_asset); res != rosy::result::ok)
         {
             l->error("Error generating fbx tangents");
@@ -546,6 +547,26 @@ rosy::result fbx::import(const std::shared_ptr<rosy_logger::log>& l, [[maybe_unu
         }
     }
 
+    if (cfg.flatten_hierarchy)
+    {
+        stage_timer flatten_timer{cfg.profile, "hierarchy flattening", source_path};
+        if (const auto res = flatten_node_hierarchy(l, fbx_asset, cfg.flatten); res != rosy::result::ok)
+        {
+            l->error("Error flattening fbx node hierarchy");
+            return res;
+        }
+    }
+
+    if (cfg.bake_ambient_occlusion)
+    {
+        stage_timer ao_timer{cfg.profile, "ambient occlusion", source_path};
+        if (const auto res = bake_ambient_occlusion(l, fbx_asset, cfg.ambient_occlusion); res != rosy::result::ok)
+        {
+            l->error("Error baking fbx ambient occlusion");
+            return res;
+        }
+    }
+
     l->info("all done importing fbx asset");
     return rosy::result::ok;
 }
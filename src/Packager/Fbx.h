@@ -1,6 +1,10 @@
 #pragma once
 #include "Asset/Asset.h"
 #include "Logger/Logger.h"
+#include "AmbientOcclusion.h"
+#include "Flatten.h"
+#include "Profile.h"
+#include "TextureBudget.h"
 #include <string>
 
 
@@ -10,6 +14,12 @@ namespace rosy_packager
     {
         bool condition_images{true};
         bool use_mikktspace{true};
+        texture_budget_config texture_budget{};
+        bool flatten_hierarchy{false};
+        flatten_config flatten{};
+        bool bake_ambient_occlusion{false};
+        ambient_occlusion_config ambient_occlusion{};
+        profile_report* profile{nullptr}; // optional, when set each import stage is timed into it
     };
 
     struct fbx
@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "Flatten.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace rosy_packager;
+
+namespace
+{
+    struct flatten_context
+    {
+        const rosy_asset::asset* source{nullptr};
+        const flatten_config* cfg{nullptr};
+        std::vector<rosy_asset::node> nodes;
+        std::vector<bool> visiting;
+    };
+
+    bool keep_node(const flatten_context& ctx, const rosy_asset::node& n)
+    {
+        if (n.mesh_id != UINT32_MAX) return true;
+        const std::string name{n.name.begin(), n.name.end()};
+        return std::ranges::find(ctx.cfg->keep_node_names, name) != ctx.cfg->keep_node_names.end();
+    }
+
+    // Visits a source node with the transforms of any collapsed ancestors folded into carry and appends the indices of
+    // the nodes that take its place in the flattened hierarchy to out.
+    rosy::result flatten_node(const std::shared_ptr<rosy_logger::log>& l, flatten_context& ctx, const uint32_t source_index, const glm::mat4& carry,
+                              std::vector<uint32_t>& out)
+    {
+        if (source_index >= ctx.source->nodes.size())
+        {
+            l->error(std::format("node index {} is out of range while flattening", source_index));
+            return rosy::result::invalid_argument;
+        }
+        if (ctx.visiting[source_index])
+        {
+            l->error(std::format("node {} is its own ancestor, cannot flatten a cyclic hierarchy", source_index));
+            return rosy::result::invalid_state;
+        }
+        ctx.visiting[source_index] = true;
+
+        const rosy_asset::node& source_node = ctx.source->nodes[source_index];
+        const glm::mat4 transform = carry * glm::make_mat4(source_node.transform.data());
+        if (!keep_node(ctx, source_node))
+        {
+            for (const uint32_t child : source_node.child_nodes)
+            {
+                if (const auto res = flatten_node(l, ctx, child, transform, out); res != rosy::result::ok) return res;
+            }
+            ctx.visiting[source_index] = false;
+            return rosy::result::ok;
+        }
+
+        const auto new_index = static_cast<uint32_t>(ctx.nodes.size());
+        {
+            rosy_asset::node n = source_node;
+            n.child_nodes.clear();
+            std::copy_n(glm::value_ptr(transform), 16, n.transform.begin());
+            ctx.nodes.push_back(std::move(n));
+        }
+        std::vector<uint32_t> children;
+        for (const uint32_t child : source_node.child_nodes)
+        {
+            if (const auto res = flatten_node(l, ctx, child, glm::mat4{1.f}, children); res != rosy::result::ok) return res;
+        }
+        ctx.nodes[new_index].child_nodes = std::move(children);
+        out.push_back(new_index);
+        ctx.visiting[source_index] = false;
+        return rosy::result::ok;
+    }
+}
+
+rosy::result rosy_packager::flatten_node_hierarchy(const std::shared_ptr<rosy_logger::log>& l, rosy_asset::asset& asset, const flatten_config& cfg)
+{
+    flatten_context ctx{
+        .source = &asset,
+        .cfg = &cfg,
+    };
+    ctx.nodes.reserve(asset.nodes.size());
+    ctx.visiting.resize(asset.nodes.size(), false);
+
+    std::vector<rosy_asset::scene> scenes;
+    scenes.reserve(asset.scenes.size());
+    for (const rosy_asset::scene& s : asset.scenes)
+    {
+        rosy_asset::scene new_scene{};
+        for (const uint32_t node_index : s.nodes)
+        {
+            if (const auto res = flatten_node(l, ctx, node_index, glm::mat4{1.f}, new_scene.nodes); res != rosy::result::ok) return res;
+        }
+        scenes.push_back(std::move(new_scene));
+    }
+
+    l->info(std::format("flattened node hierarchy from {} to {} nodes", asset.nodes.size(), ctx.nodes.size()));
+    asset.nodes = std::move(ctx.nodes);
+    asset.scenes = std::move(scenes);
+    return rosy::result::ok;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "Asset/Asset.h"
+#include "Logger/Logger.h"
+#include <string>
+
+namespace rosy_packager
+{
+    struct flatten_config
+    {
+        // Mesh-less nodes with one of these names survive flattening because gameplay or level files look them up by name.
+        std::vector<std::string> keep_node_names{"mobs", "static", "rosy", "floor"};
+    };
+
+    // Removes every mesh-less node that is not in the keep list, folding its transform into its children and handing those
+    // children to its parent. World space transforms of every remaining node are unchanged. Mesh-less leaves are dropped.
+    [[nodiscard]] rosy::result flatten_node_hierarchy(const std::shared_ptr<rosy_logger::log>& l, rosy_asset::asset& asset, const flatten_config& cfg);
+}
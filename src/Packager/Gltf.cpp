@@ -74,24 +74,27 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
         fastgltf::Options::LoadExternalBuffers | fastgltf::Options::DecomposeNodeMatrices;
 
     fastgltf::Asset gltf;
-    fastgltf::Parser parser{fastgltf::Extensions::KHR_lights_punctual};
-    auto data = fastgltf::GltfDataBuffer::FromPath(file_path);
-    if (data.error() != fastgltf::Error::None)
     {
-        auto err = fastgltf::to_underlying(data.error());
-        l->error(std::format("import - failed to open {}, {}", source_path, err));
-        return rosy::result::error;
-    }
-    auto asset = parser.loadGltf(data.get(), file_path.parent_path(), gltf_options);
-    if (asset)
-    {
-        gltf = std::move(asset.get());
-    }
-    else
-    {
-        auto err = fastgltf::to_underlying(asset.error());
-        l->error(std::format("import - failed to load {}, {}", source_path, err));
-        return rosy::result::error;
+        stage_timer parse_timer{cfg.profile, "parse", source_path};
+        fastgltf::Parser parser{fastgltf::Extensions::KHR_lights_punctual};
+        auto data = fastgltf::GltfDataBuffer::FromPath(file_path);
+        if (data.error() != fastgltf::Error::None)
+        {
+            auto err = fastgltf::to_underlying(data.error());
+            l->error(std::format("import - failed to open {}, {}", source_path, err));
+            return rosy::result::error;
+        }
+        auto asset = parser.loadGltf(data.get(), file_path.parent_path(), gltf_options);
+        if (asset)
+        {
+            gltf = std::move(asset.get());
+        }
+        else
+        {
+            auto err = fastgltf::to_underlying(asset.error());
+            l->error(std::format("import - failed to load {}, {}", source_path, err));
+            return rosy::result::error;
+        }
     }
 
     // IMAGES
@@ -199,6 +202,8 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
             gltf_asset.materials.push_back(m);
         }
     }
+    // Images are compressed once meshes and nodes are known so the texture budget can measure texel density.
+    std::vector<texture_job> texture_jobs;
     if (cfg.condition_images)
     {
         // Color images
@@ -222,11 +227,7 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
 
             std::filesystem::path source_img_path{gltf_asset.asset_path};
             source_img_path.replace_filename(uri_ds.uri.string());
-            if (const auto res = generate_srgb_texture(l, source_img_path); res != rosy::result::ok)
-            {
-                l->info(std::format("error creating color gltf image: {}", static_cast<uint8_t>(res)));
-                return res;
-            }
+            texture_jobs.push_back({.source_path = source_img_path, .image_index = gltf_index, .image_type = rosy_asset::image_type_color});
         }
         // Metallic images
         std::ranges::sort(metallic_images);
@@ -249,11 +250,7 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
 
             std::filesystem::path source_img_path{gltf_asset.asset_path};
             source_img_path.replace_filename(uri_ds.uri.string());
-            if (const auto res = generate_srgb_texture(l, source_img_path); res != rosy::result::ok)
-            {
-                l->info(std::format("error creating metallic gltf image: {}", static_cast<uint8_t>(res)));
-                return res;
-            }
+            texture_jobs.push_back({.source_path = source_img_path, .image_index = gltf_index, .image_type = rosy_asset::image_type_metallic_roughness});
         }
         // Normal maps
         std::ranges::sort(normal_map_images);
@@ -277,11 +274,7 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
 
             std::filesystem::path source_img_path{gltf_asset.asset_path};
             source_img_path.replace_filename(uri_ds.uri.string());
-            if (const auto res = generate_normal_map_texture(l, source_img_path); res != rosy::result::ok)
-            {
-                l->info(std::format("error creating normal gltf image: {}", static_cast<uint8_t>(res)));
-                return res;
-            }
+            texture_jobs.push_back({.source_path = source_img_path, .image_index = gltf_index, .image_type = rosy_asset::image_type_normal_map});
         }
     }
 
@@ -318,6 +311,8 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
     for (fastgltf::Mesh& fast_gltf_mesh : gltf.meshes)
     {
         rosy_asset::mesh new_mesh{};
+        const std::string mesh_detail{std::format("mesh {}", gltf_asset.meshes.size())};
+        std::optional<stage_timer> decode_timer{std::in_place, cfg.profile, "primitive decode", mesh_detail};
         for (auto& primitive : fast_gltf_mesh.primitives)
         {
             // PRIMITIVE SURFACE
@@ -423,7 +418,10 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
             new_mesh.surfaces.push_back(new_surface);
         }
 
+        decode_timer.reset();
+
         {
+            stage_timer optimize_timer{cfg.profile, "mesh optimization", mesh_detail};
             optimize_mesh(l, new_mesh);
         }
 
@@ -471,13 +469,40 @@ rosy::result gltf::import(std::shared_ptr<rosy_logger::log>& l, gltf_config& cfg
         gltf_asset.nodes.push_back(n);
     }
 
+    if (const auto res = compress_textures(l, gltf_asset, texture_jobs, cfg.texture_budget, cfg.profile); res != rosy::result::ok)
+    {
+        l->error("Error compressing gltf images");
+        return res;
+    }
+
     if (cfg.use_mikktspace)
     {
+        stage_timer tangent_timer{cfg.profile, "tangent generation", source_path};
         if (const auto res = generate_tangents(l, gltf_asset); res != rosy::result::ok)
         {
             l->error("Error generating gltf tangents");
             return res;
         }
     }
+
+    if (cfg.flatten_hierarchy)
+    {
+        stage_timer flatten_timer{cfg.profile, "hierarchy flattening", source_path};
+        if (const auto res = flatten_node_hierarchy(l, gltf_asset, cfg.flatten); res != rosy::result::ok)
+        {
+            l->error("Error flattening gltf node hierarchy");
+            return res;
+        }
+    }
+
+    if (cfg.bake_ambient_occlusion)
+    {
+        stage_timer ao_timer{cfg.profile, "ambient occlusion", source_path};
+        if (const auto res = bake_ambient_occlusion(l, gltf_asset, cfg.ambient_occlusion); res != rosy::result::ok)
+        {
+            l->error("Error baking gltf ambient occlusion");
+            return res;
+        }
+    }
     return rosy::result::ok;
 }
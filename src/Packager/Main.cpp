@@ -1,17 +1,48 @@
 #include "pch.h"
+#include <charconv>
 #include "Logger/Logger.h"
 #include "Asset/Asset.h"
 #include "Gltf.h"
 #include "FBX.h"
+#include "Profile.h"
 
 using namespace rosy_packager;
 
 namespace {
-    int load_gltf(std::shared_ptr<rosy_logger::log> l, const std::filesystem::path& source_path)
+    // Options parsed from the command line that apply to every input.
+    struct package_options
+    {
+        texture_budget_config texture_budget{};
+        bool flatten_hierarchy{false};
+        flatten_config flatten{};
+        bool bake_ambient_occlusion{false};
+    };
+
+    template <typename T>
+    bool parse_number(const std::string_view text, T& value)
+    {
+        const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc{} && ptr == text.data() + text.size();
+    }
+
+    // Command line budgets can be overridden per asset by a <name>.budget.json next to the source file.
+    rosy::result asset_texture_budget(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& source_path, const package_options& options,
+                                      texture_budget_config& texture_budget)
+    {
+        texture_budget = options.texture_budget;
+        std::filesystem::path budget_path{ source_path };
+        budget_path.replace_extension(".budget.json");
+        return load_texture_budget(l, budget_path, texture_budget);
+    }
+
+    int load_gltf(std::shared_ptr<rosy_logger::log> l, const std::filesystem::path& source_path, const package_options& options, profile_report& report)
     {
         const auto start = std::chrono::system_clock::now();
+        const double cpu_start_ms = process_cpu_time_ms();
         std::filesystem::path output_path{ source_path };
         output_path.replace_extension(".rsy");
+        report.source_path = source_path.string();
+        report.output_path = output_path.string();
         l->info(std::format("Parsing {} as {}", source_path.string(), output_path.string()));
         gltf g{};
         {
@@ -20,18 +51,31 @@ namespace {
             g.source_path = source_path.string();
             g.gltf_asset = a;
         }
+        texture_budget_config texture_budget{};
+        if (const auto res = asset_texture_budget(l, source_path, options, texture_budget); res != rosy::result::ok)
+        {
+            return EXIT_FAILURE;
+        }
         gltf_config gltf_cfg{
             .condition_images = true,
             .use_mikktspace = true,
+            .texture_budget = texture_budget,
+            .flatten_hierarchy = options.flatten_hierarchy,
+            .flatten = options.flatten,
+            .bake_ambient_occlusion = options.bake_ambient_occlusion,
+            .profile = &report,
         };
         if (const auto res = g.import(l, gltf_cfg); res != rosy::result::ok)
         {
             l->error(std::format("Error importing gltf {}", static_cast<uint8_t>(res)));
             return EXIT_FAILURE;
         }
-        if (const auto res = g.gltf_asset.write(l); res != rosy::result::ok)
         {
-            return EXIT_FAILURE;
+            stage_timer write_timer{&report, "asset write", output_path.string()};
+            if (const auto res = g.gltf_asset.write(l); res != rosy::result::ok)
+            {
+                return EXIT_FAILURE;
+            }
         }
         int mi{ 0 };
         constexpr int max_pos{ 1 };
@@ -60,16 +104,23 @@ namespace {
 
         const auto end = std::chrono::system_clock::now();
         const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        report.succeeded = true;
+        report.total_wall_ms = static_cast<double>(elapsed.count()) / 1000.0;
+        report.total_cpu_ms = process_cpu_time_ms() - cpu_start_ms;
+        report.peak_memory_bytes = process_peak_memory_bytes();
         l->info(std::format("Finished packaging. Took {}ms", static_cast<double>(elapsed.count()) / 1000.0l));
         return 0;
     }
 
 
-    int load_fbx(const std::shared_ptr<rosy_logger::log> l, const std::filesystem::path& source_path)
+    int load_fbx(const std::shared_ptr<rosy_logger::log> l, const std::filesystem::path& source_path, const package_options& options, profile_report& report)
     {
         const auto start = std::chrono::system_clock::now();
+        const double cpu_start_ms = process_cpu_time_ms();
         std::filesystem::path output_path{ source_path };
         output_path.replace_extension(".rsy");
+        report.source_path = source_path.string();
+        report.output_path = output_path.string();
         l->info(std::format("Parsing {} as {}", source_path.string(), output_path.string()));
         fbx f{};
         {
@@ -78,18 +129,31 @@ namespace {
             f.source_path = source_path.string();
             f.fbx_asset = a;
         }
+        texture_budget_config texture_budget{};
+        if (const auto res = asset_texture_budget(l, source_path, options, texture_budget); res != rosy::result::ok)
+        {
+            return EXIT_FAILURE;
+        }
         fbx_config fbx_cfg{
             .condition_images = true,
             .use_mikktspace = true,
+            .texture_budget = texture_budget,
+            .flatten_hierarchy = options.flatten_hierarchy,
+            .flatten = options.flatten,
+            .bake_ambient_occlusion = options.bake_ambient_occlusion,
+            .profile = &report,
         };
         if (const auto res = f.import(l, fbx_cfg); res != rosy::result::ok)
         {
             l->error(std::format("Error importing fbx {}", static_cast<uint8_t>(res)));
             return EXIT_FAILURE;
         }
-        if (const auto res = f.fbx_asset.write(l); res != rosy::result::ok)
         {
-            return EXIT_FAILURE;
+            stage_timer write_timer{&report, "asset write", output_path.string()};
+            if (const auto res = f.fbx_asset.write(l); res != rosy::result::ok)
+            {
+                return EXIT_FAILURE;
+            }
         }
         int mi{ 0 };
         constexpr int max_pos{ 1 };
@@ -118,9 +182,45 @@ namespace {
 
         const auto end = std::chrono::system_clock::now();
         const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        report.succeeded = true;
+        report.total_wall_ms = static_cast<double>(elapsed.count()) / 1000.0;
+        report.total_cpu_ms = process_cpu_time_ms() - cpu_start_ms;
+        report.peak_memory_bytes = process_peak_memory_bytes();
         l->info(std::format("Finished packaging. Took {}ms", static_cast<double>(elapsed.count()) / 1000.0l));
         return 0;
     }
+
+
+    int package(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& cwd, const std::string& arg, const package_options& options, profile_report& report)
+    {
+        std::filesystem::path source_path{ arg };
+        report.source_path = source_path.string();
+        if (!source_path.has_extension())
+        {
+            l->error("Need to provide a path to gltf file with the gltf extension, glb is not supported.");
+            return EXIT_FAILURE;
+        }
+        if (source_path.extension() == ".fbx")
+        {
+            l->info("importing an fbx file");
+            if (!source_path.is_absolute())
+            {
+                source_path = std::filesystem::path{ std::format("{}\\{}", cwd.string(), source_path.string()) };
+            }
+            return load_fbx(l, source_path, options, report);
+        }
+        if (source_path.extension() != ".gltf")
+        {
+            l->error(std::format("Received a path without a gltf extension, glb is not supported. Found {}",
+                source_path.extension().string()));
+            return EXIT_FAILURE;
+        }
+        if (!source_path.is_absolute())
+        {
+            source_path = std::filesystem::path{ std::format("{}\\{}", cwd.string(), source_path.string()) };
+        }
+        return load_gltf(l, source_path, options, report);
+    }
 }
 
 int main(const int argc, char* argv[])
@@ -142,33 +242,106 @@ int main(const int argc, char* argv[])
     }
     if (argc <= 1)
     {
-        l->error("Need to provide a relative or absolute path to a gltf file");
+        l->error("Need to provide one or more relative or absolute paths to gltf or fbx files");
         return EXIT_FAILURE;
     }
-    std::filesystem::path source_path{ argv[1] };
-    if (!source_path.has_extension())
-    {
-        l->error("Need to provide a path to gltf file with the gltf extension, glb is not supported.");
-        return EXIT_FAILURE;
-    }
-    if (source_path.extension() == ".fbx")
+
+    // Every argument is an input file except for --batch-report <path>, which overrides where the aggregate profile
+    // report for a batch of more than one input is written, --bake-ao which bakes per-vertex ambient occlusion, --flatten which
+    // collapses mesh-less transform nodes, --keep-node <name> which adds a node name that flattening must keep, and the texture
+    // budget options which take a size in texels or, for --texels-per-unit, a texel density.
+    std::vector<std::string> inputs;
+    package_options options{};
+    const std::array<std::tuple<std::string_view, uint32_t*>, 5> texture_size_flags{{
+        {"--max-texture-size", &options.texture_budget.max_asset_size},
+        {"--max-color-size", &options.texture_budget.max_color_size},
+        {"--max-normal-size", &options.texture_budget.max_normal_map_size},
+        {"--max-metallic-size", &options.texture_budget.max_metallic_roughness_size},
+        {"--max-mixmap-size", &options.texture_budget.max_mixmap_size},
+    }};
+    std::filesystem::path batch_report_path{ cwd / "packager_profile.json" };
+    for (int i = 1; i < argc; i++)
     {
-        l->info("importing an fbx file");
-        if (!source_path.is_absolute())
+        if (const std::string arg{ argv[i] }; arg == "--batch-report")
         {
-            source_path = std::filesystem::path{ std::format("{}\\{}", cwd.string(), source_path.string()) };
+            if (i + 1 >= argc)
+            {
+                l->error("--batch-report requires a path");
+                return EXIT_FAILURE;
+            }
+            batch_report_path = std::filesystem::path{ argv[i + 1] };
+            i += 1;
+        }
+        else if (arg == "--flatten")
+        {
+            options.flatten_hierarchy = true;
+        }
+        else if (arg == "--keep-node")
+        {
+            if (i + 1 >= argc)
+            {
+                l->error("--keep-node requires a node name");
+                return EXIT_FAILURE;
+            }
+            options.flatten.keep_node_names.emplace_back(argv[i + 1]);
+            i += 1;
+        }
+        else if (arg == "--bake-ao")
+        {
+            options.bake_ambient_occlusion = true;
+        }
+        else if (arg == "--texels-per-unit")
+        {
+            if (i + 1 >= argc || !parse_number(argv[i + 1], options.texture_budget.texels_per_unit))
+            {
+                l->error("--texels-per-unit requires a number");
+                return EXIT_FAILURE;
+            }
+            i += 1;
+        }
+        else if (const auto flag = std::ranges::find(texture_size_flags, std::string_view{ arg }, [](const auto& f) { return std::get<0>(f); });
+            flag != texture_size_flags.end())
+        {
+            if (i + 1 >= argc || !parse_number(argv[i + 1], *std::get<1>(*flag)))
+            {
+                l->error(std::format("{} requires a size in texels", arg));
+                return EXIT_FAILURE;
+            }
+            i += 1;
+        }
+        else
+        {
+            inputs.push_back(arg);
         }
-        return load_fbx(l, source_path);
     }
-    if (source_path.extension() != ".gltf")
+
+    int exit_code{ 0 };
+    std::vector<profile_report> reports;
+    reports.reserve(inputs.size());
+    for (const std::string& input : inputs)
     {
-        l->error(std::format("Received a path without a gltf extension, glb is not supported. Found {}",
-            source_path.extension().string()));
-        return EXIT_FAILURE;
+        profile_report report{};
+        if (package(l, cwd, input, options, report) != 0)
+        {
+            exit_code = EXIT_FAILURE;
+        }
+        if (!report.output_path.empty())
+        {
+            std::filesystem::path report_path{ report.output_path };
+            report_path.replace_extension(".profile.json");
+            if (const auto res = report.write(l, report_path); res != rosy::result::ok)
+            {
+                l->warn(std::format("Failed to write profile report for {}", input));
+            }
+        }
+        reports.push_back(std::move(report));
     }
-    if (!source_path.is_absolute())
+    if (reports.size() > 1)
     {
-        source_path = std::filesystem::path{ std::format("{}\\{}", cwd.string(), source_path.string()) };
+        if (const auto res = write_batch_profile_report(l, reports, batch_report_path); res != rosy::result::ok)
+        {
+            l->warn("Failed to write batch profile report");
+        }
     }
-    return load_gltf(l, source_path);
+    return exit_code;
 };
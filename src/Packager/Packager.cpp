@@ -213,7 +213,8 @@ rosy::result rosy_packager::generate_tangents(const std::shared_ptr<rosy_logger:
     return rosy::result::ok;
 }
 
-rosy::result rosy_packager::generate_srgb_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path)
+rosy::result rosy_packager::generate_srgb_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path, const uint32_t max_size,
+                                                  texture_compression_result& out)
 {
     std::string input_filename{image_path.string()};
     std::filesystem::path output_file{image_path};
@@ -224,6 +225,19 @@ rosy::result rosy_packager::generate_srgb_texture(const std::shared_ptr<rosy_log
         l->error(std::format("Failed to load file  for  {}", input_filename));
         return rosy::result::error;
     }
+    out.source_width = static_cast<uint32_t>(image.width());
+    out.source_height = static_cast<uint32_t>(image.height());
+    if (max_size > 0 && std::max(out.source_width, out.source_height) > max_size)
+    {
+        // Filter in linear space with premultiplied alpha, the same as the mip chain below.
+        image.toLinearFromSrgb();
+        image.premultiplyAlpha();
+        image.resize(static_cast<int>(max_size), nvtt::RoundMode_None, nvtt::ResizeFilter_Kaiser);
+        image.demultiplyAlpha();
+        image.toSrgb();
+    }
+    out.width = static_cast<uint32_t>(image.width());
+    out.height = static_cast<uint32_t>(image.height());
 
     nvtt::CompressionOptions compression_options;
     compression_options.setFormat(nvtt::Format_BC7);
@@ -260,7 +274,8 @@ rosy::result rosy_packager::generate_srgb_texture(const std::shared_ptr<rosy_log
     return rosy::result::ok;
 }
 
-rosy::result rosy_packager::generate_normal_map_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path)
+rosy::result rosy_packager::generate_normal_map_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path, const uint32_t max_size,
+                                                        texture_compression_result& out)
 {
     std::string input_filename{image_path.string()};
     std::filesystem::path output_file{image_path};
@@ -271,6 +286,15 @@ rosy::result rosy_packager::generate_normal_map_texture(const std::shared_ptr<ro
         l->error(std::format("Failed to open {}", input_filename));
         return rosy::result::error;
     }
+    out.source_width = static_cast<uint32_t>(image.width());
+    out.source_height = static_cast<uint32_t>(image.height());
+    if (max_size > 0 && std::max(out.source_width, out.source_height) > max_size)
+    {
+        // Each mip is renormalized before compression so the shortened normals from filtering are fixed up there.
+        image.resize(static_cast<int>(max_size), nvtt::RoundMode_None, nvtt::ResizeFilter_Kaiser);
+    }
+    out.width = static_cast<uint32_t>(image.width());
+    out.height = static_cast<uint32_t>(image.height());
 
     nvtt::CompressionOptions compression_options;
     compression_options.setFormat(nvtt::Format_BC7);
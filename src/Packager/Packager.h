@@ -3,8 +3,19 @@
 
 namespace rosy_packager
 {
+    struct texture_compression_result
+    {
+        uint32_t source_width{0};
+        uint32_t source_height{0};
+        uint32_t width{0};
+        uint32_t height{0};
+    };
+
     void optimize_mesh(const std::shared_ptr<rosy_logger::log>& l, rosy_asset::mesh& asset_mesh);
     [[nodiscard]] rosy::result generate_tangents(const std::shared_ptr<rosy_logger::log>& l, rosy_asset::asset& asset);
-    [[nodiscard]] rosy::result generate_srgb_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path);
-    [[nodiscard]] rosy::result generate_normal_map_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path);
+    // max_size is the largest width or height to compress at, larger images are downsampled first. 0 keeps the source size.
+    [[nodiscard]] rosy::result generate_srgb_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path, uint32_t max_size,
+                                                     texture_compression_result& out);
+    [[nodiscard]] rosy::result generate_normal_map_texture(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& image_path, uint32_t max_size,
+                                                           texture_compression_result& out);
 }
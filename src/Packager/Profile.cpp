@@ -0,0 +1,219 @@
+#include "pch.h"
+#include "Profile.h"
+#include <iomanip>
+#include <map>
+#include <nlohmann/json.hpp>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <ctime>
+#endif
+
+using namespace rosy_packager;
+using json = nlohmann::json;
+
+namespace
+{
+    struct stage_totals
+    {
+        size_t count{0};
+        double wall_ms{0.0};
+        double cpu_ms{0.0};
+        uint64_t peak_memory_bytes{0};
+    };
+
+    void add_stage_totals(std::map<std::string, stage_totals>& totals, const profile_stage& stage)
+    {
+        auto& [count, wall_ms, cpu_ms, peak_memory_bytes] = totals[stage.name];
+        count += 1;
+        wall_ms += stage.wall_ms;
+        cpu_ms += stage.cpu_ms;
+        peak_memory_bytes = std::max(peak_memory_bytes, stage.peak_memory_bytes);
+    }
+
+    json totals_to_json(const std::map<std::string, stage_totals>& totals)
+    {
+        json j = json::object();
+        for (const auto& [name, t] : totals)
+        {
+            j[name] = json{
+                {"count", t.count},
+                {"wall_ms", t.wall_ms},
+                {"cpu_ms", t.cpu_ms},
+                {"peak_memory_bytes", t.peak_memory_bytes},
+            };
+        }
+        return j;
+    }
+
+    uint64_t texture_bytes_saved(const profile_report& report)
+    {
+        uint64_t saved{0};
+        for (const profile_texture& t : report.textures) saved += t.source_bytes - std::min(t.output_bytes, t.source_bytes);
+        return saved;
+    }
+
+    json report_to_json(const profile_report& report)
+    {
+        std::map<std::string, stage_totals> totals;
+        json stages = json::array();
+        for (const profile_stage& stage : report.stages)
+        {
+            stages.push_back(json{
+                {"name", stage.name},
+                {"detail", stage.detail},
+                {"wall_ms", stage.wall_ms},
+                {"cpu_ms", stage.cpu_ms},
+                {"peak_memory_bytes", stage.peak_memory_bytes},
+                {"memory_growth_bytes", stage.memory_growth_bytes},
+            });
+            add_stage_totals(totals, stage);
+        }
+        json textures = json::array();
+        for (const profile_texture& t : report.textures)
+        {
+            textures.push_back(json{
+                {"path", t.path},
+                {"image_type", t.image_type},
+                {"source_width", t.source_width},
+                {"source_height", t.source_height},
+                {"width", t.width},
+                {"height", t.height},
+                {"limited_by", t.limited_by},
+                {"source_bytes", t.source_bytes},
+                {"output_bytes", t.output_bytes},
+            });
+        }
+        return json{
+            {"source_path", report.source_path},
+            {"output_path", report.output_path},
+            {"succeeded", report.succeeded},
+            {"total_wall_ms", report.total_wall_ms},
+            {"total_cpu_ms", report.total_cpu_ms},
+            {"peak_memory_bytes", report.peak_memory_bytes},
+            {"stage_totals", totals_to_json(totals)},
+            {"stages", stages},
+            {"texture_bytes_saved", texture_bytes_saved(report)},
+            {"textures", textures},
+        };
+    }
+
+    rosy::result write_json(const std::shared_ptr<rosy_logger::log>& l, const json& j, const std::filesystem::path& report_path)
+    {
+        std::ofstream o(report_path);
+        if (!o.is_open())
+        {
+            l->error(std::format("Failed to open profile report {}", report_path.string()));
+            return rosy::result::open_failed;
+        }
+        o << std::setw(4) << j << '\n';
+        if (!o.good())
+        {
+            l->error(std::format("Failed to write profile report {}", report_path.string()));
+            return rosy::result::write_failed;
+        }
+        l->info(std::format("Wrote profile report {}", report_path.string()));
+        return rosy::result::ok;
+    }
+}
+
+double rosy_packager::process_cpu_time_ms()
+{
+#ifdef _WIN32
+    FILETIME creation_time{};
+    FILETIME exit_time{};
+    FILETIME kernel_time{};
+    FILETIME user_time{};
+    if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)) return 0.0;
+    // FILETIME is in 100 nanosecond intervals.
+    const auto to_ms = [](const FILETIME& ft) -> double
+    {
+        const uint64_t ticks = (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+        return static_cast<double>(ticks) / 10'000.0;
+    };
+    return to_ms(kernel_time) + to_ms(user_time);
+#else
+    return static_cast<double>(std::clock()) * 1'000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+uint64_t rosy_packager::process_peak_memory_bytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+#else
+    return 0;
+#endif
+}
+
+stage_timer::stage_timer(profile_report* profile, const std::string_view name, const std::string_view detail) : report(profile)
+{
+    if (report == nullptr) return;
+    stage.name = std::string{name};
+    stage.detail = std::string{detail};
+    peak_start = process_peak_memory_bytes();
+    cpu_start_ms = process_cpu_time_ms();
+    wall_start = std::chrono::steady_clock::now();
+}
+
+stage_timer::~stage_timer()
+{
+    if (report == nullptr) return;
+    const auto wall_end = std::chrono::steady_clock::now();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(wall_end - wall_start);
+    stage.wall_ms = static_cast<double>(elapsed.count()) / 1'000.0;
+    stage.cpu_ms = process_cpu_time_ms() - cpu_start_ms;
+    stage.peak_memory_bytes = process_peak_memory_bytes();
+    stage.memory_growth_bytes = stage.peak_memory_bytes - std::min(peak_start, stage.peak_memory_bytes);
+    report->stages.push_back(std::move(stage));
+}
+
+rosy::result profile_report::write(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& report_path) const
+{
+    return write_json(l, report_to_json(*this), report_path);
+}
+
+rosy::result rosy_packager::write_batch_profile_report(const std::shared_ptr<rosy_logger::log>& l, const std::vector<profile_report>& reports,
+                                                       const std::filesystem::path& report_path)
+{
+    std::map<std::string, stage_totals> totals;
+    json files = json::array();
+    double total_wall_ms{0.0};
+    double total_cpu_ms{0.0};
+    uint64_t peak_memory_bytes{0};
+    size_t num_failed{0};
+    uint64_t bytes_saved{0};
+    for (const profile_report& report : reports)
+    {
+        bytes_saved += texture_bytes_saved(report);
+        for (const profile_stage& stage : report.stages) add_stage_totals(totals, stage);
+        total_wall_ms += report.total_wall_ms;
+        total_cpu_ms += report.total_cpu_ms;
+        peak_memory_bytes = std::max(peak_memory_bytes, report.peak_memory_bytes);
+        if (!report.succeeded) num_failed += 1;
+        files.push_back(json{
+            {"source_path", report.source_path},
+            {"succeeded", report.succeeded},
+            {"total_wall_ms", report.total_wall_ms},
+            {"total_cpu_ms", report.total_cpu_ms},
+            {"peak_memory_bytes", report.peak_memory_bytes},
+            {"texture_bytes_saved", texture_bytes_saved(report)},
+        });
+    }
+    const json j{
+        {"num_files", reports.size()},
+        {"num_failed", num_failed},
+        {"total_wall_ms", total_wall_ms},
+        {"total_cpu_ms", total_cpu_ms},
+        {"peak_memory_bytes", peak_memory_bytes},
+        {"texture_bytes_saved", bytes_saved},
+        {"stage_totals", totals_to_json(totals)},
+        {"files", files},
+    };
+    return write_json(l, j, report_path);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "Asset/Asset.h"
+#include "Logger/Logger.h"
+#include <string>
+
+namespace rosy_packager
+{
+    // A single timed stage of packaging, such as parsing or compressing one texture. Peak memory is the process high water mark
+    // when the stage ended and memory_growth is how much that high water mark rose while the stage ran.
+    struct profile_stage
+    {
+        std::string name{};
+        std::string detail{};
+        double wall_ms{0.0};
+        double cpu_ms{0.0};
+        uint64_t peak_memory_bytes{0};
+        uint64_t memory_growth_bytes{0};
+    };
+
+    // What the texture budget did to one image. Byte counts are for the full BC7 mip chain.
+    struct profile_texture
+    {
+        std::string path{};
+        uint32_t image_type{0};
+        uint32_t source_width{0};
+        uint32_t source_height{0};
+        uint32_t width{0};
+        uint32_t height{0};
+        std::string limited_by{}; // empty when the image was compressed at its source size
+        uint64_t source_bytes{0};
+        uint64_t output_bytes{0};
+    };
+
+    struct profile_report
+    {
+        std::string source_path{};
+        std::string output_path{};
+        bool succeeded{false};
+        double total_wall_ms{0.0};
+        double total_cpu_ms{0.0};
+        uint64_t peak_memory_bytes{0};
+        std::vector<profile_stage> stages{};
+        std::vector<profile_texture> textures{};
+
+        [[nodiscard]] rosy::result write(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& report_path) const;
+    };
+
+    [[nodiscard]] rosy::result write_batch_profile_report(const std::shared_ptr<rosy_logger::log>& l, const std::vector<profile_report>& reports,
+                                                          const std::filesystem::path& report_path);
+
+    // stage_timer records a stage into a report when it goes out of scope. A null report turns it into a no-op.
+    struct stage_timer
+    {
+        stage_timer(profile_report* profile, std::string_view name, std::string_view detail = {});
+        ~stage_timer();
+        stage_timer(const stage_timer&) = delete;
+        stage_timer& operator=(const stage_timer&) = delete;
+        stage_timer(stage_timer&&) = delete;
+        stage_timer& operator=(stage_timer&&) = delete;
+
+    private:
+        profile_report* report{nullptr};
+        profile_stage stage{};
+        std::chrono::steady_clock::time_point wall_start{};
+        double cpu_start_ms{0.0};
+        uint64_t peak_start{0};
+    };
+
+    [[nodiscard]] double process_cpu_time_ms();
+    [[nodiscard]] uint64_t process_peak_memory_bytes();
+}
@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "TextureBudget.h"
+#include "Packager.h"
+#include <bit>
+#include <nlohmann/json.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace rosy_packager;
+using json = nlohmann::json;
+
+namespace
+{
+    // Smallest size the texel density rule will ask for, one BC block.
+    constexpr uint32_t min_texel_density_size{4};
+
+    // BC7 stores every 4x4 block in 16 bytes, summed over a full mip chain down to 1x1.
+    uint64_t bc7_mip_chain_bytes(uint32_t width, uint32_t height)
+    {
+        uint64_t bytes{0};
+        while (true)
+        {
+            bytes += static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * 16;
+            if (width == 1 && height == 1) break;
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+        return bytes;
+    }
+
+    uint32_t type_max_size(const texture_budget_config& cfg, const uint32_t image_type)
+    {
+        switch (image_type)
+        {
+        case rosy_asset::image_type_color:
+            return cfg.max_color_size;
+        case rosy_asset::image_type_normal_map:
+            return cfg.max_normal_map_size;
+        case rosy_asset::image_type_metallic_roughness:
+            return cfg.max_metallic_roughness_size;
+        case rosy_asset::image_type_mixmap:
+            return cfg.max_mixmap_size;
+        default:
+            return 0;
+        }
+    }
+
+    // The size each image needs to reach cfg.texels_per_unit on the surface instance that needs the most detail from it, 0 if unused.
+    std::vector<uint32_t> texel_density_sizes(const rosy_asset::asset& asset, const float texels_per_unit)
+    {
+        std::vector<uint32_t> sizes(asset.images.size(), 0);
+        if (texels_per_unit <= 0.f || asset.scenes.empty() || asset.root_scene >= asset.scenes.size()) return sizes;
+
+        std::stack<std::tuple<uint32_t, glm::mat4>> nodes;
+        for (const uint32_t node_index : asset.scenes[asset.root_scene].nodes) nodes.emplace(node_index, glm::mat4{1.f});
+        while (!nodes.empty())
+        {
+            const auto [node_index, parent_transform] = nodes.top();
+            nodes.pop();
+            if (node_index >= asset.nodes.size()) continue;
+            const rosy_asset::node& n = asset.nodes[node_index];
+            const glm::mat4 transform = parent_transform * glm::make_mat4(n.transform.data());
+            for (const uint32_t child : n.child_nodes) nodes.emplace(child, transform);
+            if (n.mesh_id >= asset.meshes.size()) continue;
+
+            const rosy_asset::mesh& m = asset.meshes[n.mesh_id];
+            for (const rosy_asset::surface& s : m.surfaces)
+            {
+                if (s.material >= asset.materials.size()) continue;
+                double world_area{0.0};
+                double uv_area{0.0};
+                for (size_t i{s.start_index}; i + 2 < static_cast<size_t>(s.start_index) + s.count && i + 2 < m.indices.size(); i += 3)
+                {
+                    const rosy_asset::position& p0 = m.positions[m.indices[i]];
+                    const rosy_asset::position& p1 = m.positions[m.indices[i + 1]];
+                    const rosy_asset::position& p2 = m.positions[m.indices[i + 2]];
+                    const glm::vec3 w0{transform * glm::vec4{p0.vertex[0], p0.vertex[1], p0.vertex[2], 1.f}};
+                    const glm::vec3 w1{transform * glm::vec4{p1.vertex[0], p1.vertex[1], p1.vertex[2], 1.f}};
+                    const glm::vec3 w2{transform * glm::vec4{p2.vertex[0], p2.vertex[1], p2.vertex[2], 1.f}};
+                    world_area += 0.5 * glm::length(glm::cross(w1 - w0, w2 - w0));
+                    const glm::vec2 t0{p0.texture_coordinates[0], p0.texture_coordinates[1]};
+                    const glm::vec2 e1 = glm::vec2{p1.texture_coordinates[0], p1.texture_coordinates[1]} - t0;
+                    const glm::vec2 e2 = glm::vec2{p2.texture_coordinates[0], p2.texture_coordinates[1]} - t0;
+                    uv_area += 0.5 * std::abs(e1.x * e2.y - e1.y * e2.x);
+                }
+                if (uv_area <= 1e-12 || world_area <= 0.0) continue;
+
+                // A texture of size T spreads T * T texels over uv_area of it, which covers world_area.
+                const double needed = static_cast<double>(texels_per_unit) * std::sqrt(world_area / uv_area);
+                const auto needed_size = std::bit_ceil(static_cast<uint32_t>(std::clamp(needed, static_cast<double>(min_texel_density_size), 65'536.0)));
+                const rosy_asset::material& mat = asset.materials[s.material];
+                for (const uint32_t image_index : {mat.color_image_index, mat.normal_image_index, mat.metallic_image_index, mat.mixmap_image_index})
+                {
+                    if (image_index >= sizes.size()) continue;
+                    sizes[image_index] = std::max(sizes[image_index], needed_size);
+                }
+            }
+        }
+        return sizes;
+    }
+}
+
+rosy::result rosy_packager::load_texture_budget(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& budget_path, texture_budget_config& cfg)
+{
+    if (!std::filesystem::exists(budget_path)) return rosy::result::ok;
+    std::ifstream i(budget_path);
+    if (!i.is_open())
+    {
+        l->error(std::format("Failed to open texture budget {}", budget_path.string()));
+        return rosy::result::open_failed;
+    }
+    // Read into a copy so a key of the wrong type leaves cfg as it was.
+    texture_budget_config loaded = cfg;
+    try
+    {
+        const json j = json::parse(i, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+        {
+            l->error(std::format("Texture budget {} is not a JSON object", budget_path.string()));
+            return rosy::result::read_failed;
+        }
+        loaded.max_color_size = j.value("max_color_size", loaded.max_color_size);
+        loaded.max_normal_map_size = j.value("max_normal_map_size", loaded.max_normal_map_size);
+        loaded.max_metallic_roughness_size = j.value("max_metallic_roughness_size", loaded.max_metallic_roughness_size);
+        loaded.max_mixmap_size = j.value("max_mixmap_size", loaded.max_mixmap_size);
+        loaded.max_asset_size = j.value("max_asset_size", loaded.max_asset_size);
+        loaded.texels_per_unit = j.value("texels_per_unit", loaded.texels_per_unit);
+    }
+    catch (std::exception& e)
+    {
+        l->error(std::format("error reading texture budget {}: {}", budget_path.string(), e.what()));
+        return rosy::result::error;
+    }
+    catch (...)
+    {
+        l->error(std::format("error unknown exception reading texture budget {}", budget_path.string()));
+        return rosy::result::error;
+    }
+    cfg = loaded;
+    l->info(std::format("Loaded texture budget {}", budget_path.string()));
+    return rosy::result::ok;
+}
+
+rosy::result rosy_packager::compress_textures(const std::shared_ptr<rosy_logger::log>& l, const rosy_asset::asset& asset, const std::vector<texture_job>& jobs,
+                                              const texture_budget_config& cfg, profile_report* profile)
+{
+    const std::vector<uint32_t> density_sizes = texel_density_sizes(asset, cfg.texels_per_unit);
+    uint64_t total_source_bytes{0};
+    uint64_t total_output_bytes{0};
+    for (const auto& [source_path, image_index, image_type] : jobs)
+    {
+        // The smallest limit that applies wins and is remembered for the report.
+        uint32_t max_size{0};
+        std::string limited_by{};
+        const auto apply_limit = [&](const uint32_t limit, const std::string_view reason)
+        {
+            if (limit == 0 || (max_size != 0 && limit >= max_size)) return;
+            max_size = limit;
+            limited_by = std::string{reason};
+        };
+        apply_limit(type_max_size(cfg, image_type), "image type");
+        apply_limit(cfg.max_asset_size, "asset");
+        if (image_index < density_sizes.size()) apply_limit(density_sizes[image_index], "texel density");
+
+        texture_compression_result tex{};
+        {
+            stage_timer texture_timer{profile, "texture compression", source_path.string()};
+            const rosy::result res = image_type == rosy_asset::image_type_normal_map
+                                         ? generate_normal_map_texture(l, source_path, max_size, tex)
+                                         : generate_srgb_texture(l, source_path, max_size, tex);
+            if (res != rosy::result::ok)
+            {
+                l->error(std::format("error compressing image {}: {}", source_path.string(), static_cast<uint8_t>(res)));
+                return res;
+            }
+        }
+
+        const bool downsampled = tex.width != tex.source_width || tex.height != tex.source_height;
+        const uint64_t source_bytes = bc7_mip_chain_bytes(tex.source_width, tex.source_height);
+        const uint64_t output_bytes = bc7_mip_chain_bytes(tex.width, tex.height);
+        total_source_bytes += source_bytes;
+        total_output_bytes += output_bytes;
+        if (downsampled)
+        {
+            l->info(std::format("downsampled {} from {}x{} to {}x{} by the {} budget", source_path.filename().string(), tex.source_width, tex.source_height,
+                                tex.width, tex.height, limited_by));
+        }
+        if (profile != nullptr)
+        {
+            profile->textures.push_back({
+                .path = source_path.string(),
+                .image_type = image_type,
+                .source_width = tex.source_width,
+                .source_height = tex.source_height,
+                .width = tex.width,
+                .height = tex.height,
+                .limited_by = downsampled ? limited_by : std::string{},
+                .source_bytes = source_bytes,
+                .output_bytes = output_bytes,
+            });
+        }
+    }
+    l->info(std::format("texture budget saved {} of {} bytes across {} images", total_source_bytes - total_output_bytes, total_source_bytes, jobs.size()));
+    return rosy::result::ok;
+}
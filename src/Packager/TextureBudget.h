@@ -0,0 +1,39 @@
+#pragma once
+#include "Asset/Asset.h"
+#include "Logger/Logger.h"
+#include "Profile.h"
+
+namespace rosy_packager
+{
+    // Every size is the largest width or height in texels an image may be compressed at, 0 means no limit. The smallest
+    // applicable limit wins and images are only ever made smaller, never upscaled.
+    struct texture_budget_config
+    {
+        uint32_t max_color_size{0};
+        uint32_t max_normal_map_size{0};
+        uint32_t max_metallic_roughness_size{0};
+        uint32_t max_mixmap_size{0};
+        uint32_t max_asset_size{0}; // applies to every image in the asset
+        // Target texel density in texels per world unit. Each image is limited to the size that meets it on the surface
+        // that needs the most detail from it, judged by the ratio of world space triangle area to UV area. 0 disables it.
+        float texels_per_unit{0.f};
+    };
+
+    // An image the importer found that still has to be compressed into a .dds next to its source.
+    struct texture_job
+    {
+        std::filesystem::path source_path{};
+        uint32_t image_index{0};
+        uint32_t image_type{0};
+    };
+
+    // Reads optional overrides for a single asset from a JSON file next to it, for example sponza.budget.json:
+    // {"max_color_size": 1024, "max_normal_map_size": 512, "max_asset_size": 2048, "texels_per_unit": 256}
+    // A missing file leaves the config unchanged.
+    [[nodiscard]] rosy::result load_texture_budget(const std::shared_ptr<rosy_logger::log>& l, const std::filesystem::path& budget_path, texture_budget_config& cfg);
+
+    // Compresses every job after the asset's meshes are known, so texel density can be measured, downsampling
+    // images over budget before BC7 compression and recording what was saved into the profile when there is one.
+    [[nodiscard]] rosy::result compress_textures(const std::shared_ptr<rosy_logger::log>& l, const rosy_asset::asset& asset, const std::vector<texture_job>& jobs,
+                                                 const texture_budget_config& cfg, profile_report* profile);
+}
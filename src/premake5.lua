@@ -91,6 +91,11 @@ project "Engine"
         libdirs { "libs/SDL/build/Release" }
         libdirs { "libs/flecs/out/Release" }
     filter {}
+    -- AVX2 kernels are only called after a runtime CPU check and include nothing but intrinsics and the kernel templates
+    filter "files:Engine/TransformsAvx2.cpp"
+        vectorextensions "AVX2"
+        flags { "NoPCH" }
+    filter {}
     -- defines
     defines { "SIMDJSON_EXCEPTIONS=OFF" }
     filter "configurations:RenderDoc"
@@ -118,6 +123,7 @@ project "Packager"
     includedirs { "libs/MikkTSpace/" }
     includedirs { "libs/MikkTSpace/" }
     includedirs { "libs/meshoptimizer/src" }
+    includedirs { "libs/json/single_include/" }
     -- linking
     links { "fastgltf" }
     links { "nvtt30205" }
@@ -133,3 +139,52 @@ project "Packager"
         libdirs { "libs/fastgltf/build/Release" }
         libdirs { "\"" .. fbx_sdk .. "/lib/x64/release/\"" }
         libdirs { "libs/meshoptimizer/build/Release" }
+    filter {}
+
+project "Bench"
+    debugdir "./Bench/"
+    -- source files
+    files { "Bench/**.h", "Bench/**.cpp" }
+    files { "Engine/Transforms.h", "Engine/TransformKernels.h", "Engine/Transforms.cpp", "Engine/TransformsAvx2.cpp" }
+    files { "Engine/Navigation.h", "Engine/Navigation.cpp" }
+    files { "Engine/Collision.h", "Engine/Collision.cpp" }
+    files { "Logger/**.h", "Logger/**.cpp" }
+    -- include directories
+    includedirs { vk_sdk .. "/Include/" }
+    -- AVX2 kernels are only called after a runtime CPU check and include nothing but intrinsics and the kernel templates
+    filter "files:Engine/TransformsAvx2.cpp"
+        vectorextensions "AVX2"
+        flags { "NoPCH" }
+    filter {}
+
+project "Headless"
+    debugdir "./Engine/"
+    -- source files, the level and its assets without the window, the renderer or the debug UI
+    files { "Headless/**.h", "Headless/**.cpp" }
+    files { "Engine/**.h", "Engine/**.cpp" }
+    removefiles { "Engine/Main.*", "Engine/Engine.*", "Engine/Graphics.*", "Engine/DebugUI.*" }
+    files { "Asset/**.h", "Asset/**.cpp" }
+    files { "Logger/**.h", "Logger/**.cpp" }
+    files { "libs/json/single_include/nlohmann/json.hpp" }
+    -- include directories, SDL only for its event types
+    includedirs { "libs/SDL/include/" }
+    includedirs { vk_sdk .. "/Include/" }
+    includedirs { "libs/" }
+    includedirs { "libs/json/single_include/" }
+    includedirs { "libs/flecs/include/" }
+    -- linking
+    links { "flecs" }
+    -- library directories
+    filter(debug_configurations)
+        libdirs { "libs/flecs/out/Debug" }
+    filter {}
+    filter(release_configurations)
+        libdirs { "libs/flecs/out/Release" }
+    filter {}
+    -- AVX2 kernels are only called after a runtime CPU check and include nothing but intrinsics and the kernel templates
+    filter "files:Engine/TransformsAvx2.cpp"
+        vectorextensions "AVX2"
+        flags { "NoPCH" }
+    filter {}
+    -- defines
+    defines { "SIMDJSON_EXCEPTIONS=OFF" }